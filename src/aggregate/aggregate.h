@@ -213,6 +213,17 @@ ResultProcessor *Grouper_GetRP(Grouper *gr);
  */
 void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dst);
 
+/**
+ * Adds a worker to the grouper. Once workers are added, the grouper hands its
+ * input to them in batches on the query thread pool, and each worker groups its
+ * rows into its own table. The worker tables are merged when the input ends.
+ *
+ * `reducers` holds the worker's own reducers, created with the same options as
+ * (and in the order of) those added with Grouper_AddReducer(). All of them must
+ * implement Reducer::Merge. The grouper takes ownership of the reducers.
+ */
+void Grouper_AddWorker(Grouper *g, Reducer **reducers);
+
 void AREQ_Execute(AREQ *req, RedisModuleCtx *outctx);
 void AREQ_Free(AREQ *req);
 
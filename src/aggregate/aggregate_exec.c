@@ -112,16 +112,15 @@ static size_t serializeResult(AREQ *req, RedisModuleCtx *outctx, const SearchRes
   if (!(options & QEXEC_F_SEND_NOFIELDS)) {
     const RLookup *lk = cv->lastLk;
     count++;
-    int excludeFlags = RLOOKUP_F_HIDDEN;
+    // Hidden fields are only sent when they are returned explicitly
+    int excludeFlags = (req->outFields.explicitReturn ? 0 : RLOOKUP_F_HIDDEN);
     int requiredFlags = (req->outFields.explicitReturn ? RLOOKUP_F_EXPLICITRETURN : 0);
     size_t nfields = RLookup_GetLength(lk, &r->rowdata, requiredFlags, excludeFlags);
 
     RedisModule_ReplyWithArray(outctx, nfields * 2);
 
     for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
-      if (kk->flags & RLOOKUP_F_HIDDEN) {
-        // printf("Skipping hidden field %s/%p\n", kk->name, kk);
-        // todo: this is a dead code, no one set RLOOKUP_F_HIDDEN
+      if (kk->flags & excludeFlags) {
         continue;
       }
       if (req->outFields.explicitReturn && (kk->flags & RLOOKUP_F_EXPLICITRETURN) == 0) {
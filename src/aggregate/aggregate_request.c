@@ -7,6 +7,9 @@
 #include <util/arr.h>
 #include <rmutil/util.h>
 #include "ext/default.h"
+#include "numeric_index.h"
+#include "geo_index.h"
+#include "tag_index.h"
 #include "extension.h"
 
 /**
@@ -277,6 +280,20 @@ static int parseQueryLegacyArgs(ArgsCursor *ac, RSSearchOptions *options, QueryE
       GeoFilter_Free(options->legacy.gf);
       return ARG_ERROR;
     }
+  } else if (AC_AdvanceIfMatch(ac, "GEOBOX") || AC_AdvanceIfMatch(ac, "GEOPOLYGON")) {
+    int isBox = !strcasecmp(AC_StringArg(ac, ac->offset - 1), "GEOBOX");
+    if (options->legacy.shape) {
+      QERR_MKBADARGS_FMT(status, "Only one GEOBOX or GEOPOLYGON filter is supported");
+      return ARG_ERROR;
+    }
+    options->legacy.shape = rm_calloc(1, sizeof(*options->legacy.shape));
+    int rc = isBox ? GeoFilter_ParseBox(options->legacy.shape, ac, status)
+                   : GeoFilter_ParsePolygon(options->legacy.shape, ac, status);
+    if (rc != REDISMODULE_OK) {
+      GeoFilter_Free(options->legacy.shape);
+      options->legacy.shape = NULL;
+      return ARG_ERROR;
+    }
   } else {
     return ARG_UNKNOWN;
   }
@@ -309,6 +326,7 @@ static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts
       {AC_MKBITFLAG("NOCONTENT", &req->reqflags, QEXEC_F_SEND_NOFIELDS)},
       {AC_MKBITFLAG("NOSTOPWORDS", &searchOpts->flags, Search_NoStopwrods)},
       {AC_MKBITFLAG("EXPLAINSCORE", &req->reqflags, QEXEC_F_SEND_SCOREEXPLAIN)},
+      {AC_MKBITFLAG("PRUNESCORES", &searchOpts->flags, Search_PruneScores)},
       {.name = "PAYLOAD",
        .type = AC_ARGTYPE_STRING,
        .target = &req->ast.udata,
@@ -676,6 +694,10 @@ static void applyGlobalFilters(RSSearchOptions *opts, QueryAST *ast, const Redis
     QAST_GlobalFilterOptions legacyOpts = {.geo = opts->legacy.gf};
     QAST_SetGlobalFilters(ast, &legacyOpts);
   }
+  if (opts->legacy.shape) {
+    QAST_GlobalFilterOptions legacyOpts = {.geo = opts->legacy.shape};
+    QAST_SetGlobalFilters(ast, &legacyOpts);
+  }
 
   if (opts->inkeys) {
     opts->inids = rm_malloc(sizeof(*opts->inids) * opts->ninkeys);
@@ -749,6 +771,40 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   return REDISMODULE_OK;
 }
 
+/**
+ * Build the reducers of a group step. Each reducer gets its own copy of the arguments, so that
+ * the reducers can be built again for the grouper's workers. Returns NULL on error
+ */
+static Reducer **buildReducers(PLN_GroupStep *gstp, RLookup *srclookup, QueryError *err) {
+  size_t nreducers = array_len(gstp->reducers);
+  Reducer **reducers = rm_calloc(nreducers ? nreducers : 1, sizeof(*reducers));
+  for (size_t ii = 0; ii < nreducers; ++ii) {
+    // Build the actual reducer
+    PLN_Reducer *pr = gstp->reducers + ii;
+    ArgsCursor args = pr->args;
+    ReducerOptions options = REDUCEROPTS_INIT(pr->name, &args, srclookup, err);
+    ReducerFactory ff = RDCR_GetFactory(pr->name);
+    if (!ff) {
+      // No such reducer!
+      QueryError_SetErrorFmt(err, QUERY_ENOREDUCER, "No such reducer: %s", pr->name);
+    } else {
+      reducers[ii] = ff(&options);
+    }
+    if (!reducers[ii]) {
+      for (size_t jj = 0; jj < ii; ++jj) {
+        reducers[jj]->Free(reducers[jj]);
+      }
+      rm_free(reducers);
+      return NULL;
+    }
+  }
+  return reducers;
+}
+
+/**
+ * Groups are accumulated by the query pool's workers when all the reducers can merge their
+ * partial results. Each worker builds its own set of reducers.
+ */
 static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup, QueryError *err) {
   const RLookupKey *srckeys[gstp->nproperties], *dstkeys[gstp->nproperties];
   for (size_t ii = 0; ii < gstp->nproperties; ++ii) {
@@ -761,30 +817,35 @@ static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup, Qu
     dstkeys[ii] = RLookup_GetKey(&gstp->lookup, fldname, RLOOKUP_F_OCREAT | RLOOKUP_F_NOINCREF);
   }
 
+  Reducer **reducers = buildReducers(gstp, srclookup, err);
+  if (!reducers) {
+    return NULL;
+  }
+
   Grouper *grp = Grouper_New(srckeys, dstkeys, gstp->nproperties);
 
   size_t nreducers = array_len(gstp->reducers);
+  int canMerge = 1;
   for (size_t ii = 0; ii < nreducers; ++ii) {
-    // Build the actual reducer
-    PLN_Reducer *pr = gstp->reducers + ii;
-    ReducerOptions options = REDUCEROPTS_INIT(pr->name, &pr->args, srclookup, err);
-    ReducerFactory ff = RDCR_GetFactory(pr->name);
-    if (!ff) {
-      // No such reducer!
-      Grouper_Free(grp);
-      QueryError_SetErrorFmt(err, QUERY_ENOREDUCER, "No such reducer: %s", pr->name);
-      return NULL;
-    }
-    Reducer *rr = ff(&options);
-    if (!rr) {
-      Grouper_Free(grp);
-      return NULL;
-    }
-
     // Set the destination key for the grouper!
+    PLN_Reducer *pr = gstp->reducers + ii;
     RLookupKey *dstkey =
         RLookup_GetKey(&gstp->lookup, pr->alias, RLOOKUP_F_OCREAT | RLOOKUP_F_NOINCREF);
-    Grouper_AddReducer(grp, rr, dstkey);
+    Grouper_AddReducer(grp, reducers[ii], dstkey);
+    canMerge = canMerge && reducers[ii]->Merge;
+  }
+  rm_free(reducers);
+
+  if (CONCURRENT_POOL_QUERY != -1 && canMerge) {
+    for (size_t ii = 0; ii < RSGlobalConfig.queryWorkers; ++ii) {
+      reducers = buildReducers(gstp, srclookup, err);
+      if (!reducers) {
+        Grouper_Free(grp);
+        return NULL;
+      }
+      Grouper_AddWorker(grp, reducers);
+      rm_free(reducers);
+    }
   }
 
   return Grouper_GetRP(grp);
@@ -803,6 +864,23 @@ static ResultProcessor *pushRP(AREQ *req, ResultProcessor *rp, ResultProcessor *
   return rp;
 }
 
+/* DOCVALUES keys are not in the sorting vector, so unlike sortables they are not implicitly in the
+ * rows of the first lookup. Write the lookup's doc values into the rows, before a step which reads
+ * them from there */
+static ResultProcessor *pushDocValuesRP(AREQ *req, RLookup *lookup, ResultProcessor *rpUpstream) {
+  const RLookupKey **kklist = NULL;
+  for (RLookupKey *kk = lookup->head; kk; kk = kk->next) {
+    if (kk->flags & RLOOKUP_F_DVSRC) {
+      *array_ensure_tail(&kklist, const RLookupKey *) = kk;
+    }
+  }
+  if (kklist != NULL) {
+    rpUpstream = pushRP(req, RPDocValues_New(kklist, array_len(kklist)), rpUpstream);
+    array_free(kklist);
+  }
+  return rpUpstream;
+}
+
 static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcessor *rpUpstream,
                                    QueryError *status) {
   AGGPlan *pln = &req->ap;
@@ -820,7 +898,7 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
     // See if we need a loader step?
     const RLookupKey **kklist = NULL;
     for (RLookupKey *kk = firstLk->head; kk; kk = kk->next) {
-      if ((kk->flags & RLOOKUP_F_DOCSRC) && (!(kk->flags & RLOOKUP_F_SVSRC))) {
+      if ((kk->flags & RLOOKUP_F_DOCSRC) && !(kk->flags & (RLOOKUP_F_SVSRC | RLOOKUP_F_DVSRC))) {
         *array_ensure_tail(&kklist, const RLookupKey *) = kk;
       }
     }
@@ -830,6 +908,7 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
       RS_LOG_ASSERT(rpLoader, "RPLoader_New failed");
       rpUpstream = pushRP(req, rpLoader, rpUpstream);
     }
+    rpUpstream = pushDocValuesRP(req, firstLk, rpUpstream);
   }
 
   return pushRP(req, groupRP, rpUpstream);
@@ -870,6 +949,10 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
     }
 
     rp = RPSorter_NewByFields(limit, sortkeys, nkeys, astp->sortAscMap);
+    // Search queries have no steps which could write the sort keys before the sorter
+    if (req->reqflags & QEXEC_F_IS_SEARCH) {
+      RPSorter_EnableSortBound(rp);
+    }
     up = pushRP(req, rp, up);
   }
 
@@ -905,6 +988,23 @@ static ResultProcessor *getScorerRP(AREQ *req) {
   return rp;
 }
 
+/* Let the root union skip documents which can not make it into the top results. This needs a bound
+ * on what the scorer gives a term, and on the document scores it multiplies by */
+static void enableScorePruning(AREQ *req) {
+  const char *scorer = req->searchopts.scorerName;
+  if (!scorer) {
+    scorer = DEFAULT_SCORER_NAME;
+  }
+  TermScoreBound bound = DefaultScorer_GetTermBound(scorer);
+  if (!bound) {
+    return;
+  }
+  IndexSpec *sp = req->sctx->spec;
+  RSIndexStats stats = {0};
+  IndexSpec_GetStats(sp, &stats);
+  UI_EnableScorePruning(req->rootiter, &req->qiter.minScore, bound, &stats, sp->docs.maxScore);
+}
+
 static int hasQuerySortby(const AGGPlan *pln) {
   const PLN_BaseStep *bstp = AGPLN_FindStep(pln, NULL, NULL, PLN_T_GROUP);
   if (bstp != NULL) {
@@ -920,6 +1020,147 @@ static int hasQuerySortby(const AGGPlan *pln) {
   return 0;
 }
 
+/**
+ * Aggregations over indexes spanning more than one scan range split the index scan over the query
+ * pool, with a separate iterator tree per worker. Searches need the index results for scoring and
+ * highlighting, so they always scan serially - as do aggregations reading geo distances.
+ */
+static ResultProcessor *getIndexRP(AREQ *req, int needIndexResults) {
+  RedisSearchCtx *sctx = req->sctx;
+  size_t nworkers = RSGlobalConfig.queryWorkers;
+  if (CONCURRENT_POOL_QUERY == -1 || (req->reqflags & QEXEC_F_IS_SEARCH) || needIndexResults ||
+      req->rootiter->mode != MODE_SORTED ||
+      sctx->spec->docs.maxDocId <= PARALLEL_SCAN_MIN_RANGE) {
+    return RPIndexIterator_New(req->rootiter);
+  }
+
+  IndexIterator *its[nworkers];
+  its[0] = req->rootiter;
+  for (size_t ii = 1; ii < nworkers; ++ii) {
+    its[ii] = QAST_Iterate(&req->ast, &req->searchopts, sctx, &req->conc);
+  }
+  return RPParallelIndexIterator_New(its, nworkers);
+}
+
+/**
+ * A search that is a single numeric range and only asks for the number of results (LIMIT 0 0) is
+ * answered by counting the numeric tree's ranges, instead of iterating, scoring and sorting each
+ * match. Returns NULL if the request cannot be counted this way.
+ */
+static ResultProcessor *getCountRP(AREQ *req) {
+  const QueryNode *root = req->ast.root;
+  if (!(req->reqflags & QEXEC_F_IS_SEARCH) || !(req->reqflags & QEXEC_F_NOROWS) || !root ||
+      root->type != QN_NUMERIC) {
+    return NULL;
+  }
+  return RPCounter_New(NumericFilter_Count(req->sctx, root->nn.nf));
+}
+
+/**
+ * Aggregations starting with `GROUPBY 1 @tag`, with only `COUNT 0` reducers, are answered from the
+ * tag index without loading any document: each group's count is the number of matches among its
+ * tag's documents. GROUPBY groups the field values loaded from the documents, so this is only done
+ * while they are all exactly the documents' tags. Returns NULL if the request cannot be answered
+ * this way, otherwise `folded` is set to the GROUPBY step.
+ */
+// Grouping a document, which loads its value and hashes it into a group, costs about as much as
+// reading this many postings
+#define TAGCOUNT_DOC_COST 16
+
+static ResultProcessor *getTagCountRP(AREQ *req, const PLN_BaseStep **folded) {
+  RedisSearchCtx *sctx = req->sctx;
+  if ((req->reqflags & QEXEC_F_IS_SEARCH) || req->rootiter->mode != MODE_SORTED) {
+    return NULL;
+  }
+
+  const PLN_BaseStep *stp = NULL;
+  for (const DLLIST_node *nn = req->ap.steps.next; nn != &req->ap.steps; nn = nn->next) {
+    stp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+    if (stp->type != PLN_T_ROOT) {
+      break;
+    }
+  }
+  if (!stp || stp->type != PLN_T_GROUP) {
+    return NULL;
+  }
+  PLN_GroupStep *gstp = (PLN_GroupStep *)stp;
+  size_t nreducers = array_len(gstp->reducers);
+  if (gstp->nproperties != 1) {
+    return NULL;
+  }
+  for (size_t ii = 0; ii < nreducers; ++ii) {
+    if (strcasecmp(gstp->reducers[ii].name, "COUNT") || gstp->reducers[ii].args.argc) {
+      return NULL;
+    }
+  }
+
+  const char *field = gstp->properties[0] + 1;  // account for the @-
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, field, strlen(field));
+  // A field which is not indexed, or was added after documents were indexed, has no postings for
+  // (some of) the documents, so its values are only known by loading them
+  if (!fs || fs->types != INDEXFLD_T_TAG || !FieldSpec_IsIndexable(fs) ||
+      FieldSpec_IsNotReindexed(fs)) {
+    return NULL;
+  }
+  RedisModuleKey *key = NULL;
+  TagIndex *idx =
+      TagIndex_Open(sctx, IndexSpec_GetFormattedKey(sctx->spec, fs, INDEXFLD_T_TAG), 0, &key);
+  int valuesAreTags = !idx || idx->valuesAreTags;
+  // The counter reads the postings of every tag, while the grouper only loads the matching
+  // documents. A selective query is grouped faster
+  size_t budget = IITER_NUM_ESTIMATED(req->rootiter) * TAGCOUNT_DOC_COST;
+  int cheaper = !idx || TagIndex_CountCost(idx, budget) <= budget;
+  if (key) {
+    RedisModule_CloseKey(key);
+  }
+  if (!valuesAreTags || !cheaper) {
+    return NULL;
+  }
+
+  const RLookupKey *tagKey =
+      RLookup_GetKey(&gstp->lookup, field, RLOOKUP_F_OCREAT | RLOOKUP_F_NOINCREF);
+  const RLookupKey *countKeys[nreducers ? nreducers : 1];
+  for (size_t ii = 0; ii < nreducers; ++ii) {
+    countKeys[ii] = RLookup_GetKey(&gstp->lookup, gstp->reducers[ii].alias,
+                                   RLOOKUP_F_OCREAT | RLOOKUP_F_NOINCREF);
+  }
+  *folded = stp;
+  // Documents indexed while the query runs are skipped, their values were not checked here
+  return RPTagCounter_New(req->rootiter, field, sctx->spec->docs.maxDocId, tagKey, countKeys,
+                          nreducers);
+}
+
+typedef struct {
+  const GeoFilter *gf;
+  size_t numGeo;
+  size_t numNumeric;
+} FilterNodes;
+
+static int collectFilterNodes(QueryNode *node, QueryNode *q, void *ctx) {
+  FilterNodes *fn = ctx;
+  if (node->type == QN_GEO) {
+    fn->gf = node->gn.gf;
+    fn->numGeo++;
+  } else if (node->type == QN_NUMERIC) {
+    fn->numNumeric++;
+  }
+  return 1;
+}
+
+/**
+ * Distances are read from the geo records of the index results, so they are only written when the
+ * query has a single geo radius filter and no other filter whose records could be mistaken for it.
+ * Returns the query's geo filter, or NULL if distances cannot be written.
+ */
+static const GeoFilter *getDistanceFilter(AREQ *req) {
+  if (!req->ast.root) {
+    return NULL;
+  }
+  FilterNodes fn = {0};
+  QueryNode_ForEach(req->ast.root, collectFilterNodes, &fn, 0);
+  return fn.numGeo == 1 && !fn.numNumeric && fn.gf->shape == GEO_SHAPE_RADIUS ? fn.gf : NULL;
+}
+
 #define PUSH_RP()                           \
   rpUpstream = pushRP(req, rp, rpUpstream); \
   rp = NULL;
@@ -927,12 +1168,17 @@ static int hasQuerySortby(const AGGPlan *pln) {
 /**
  * Builds the implicit pipeline for querying and scoring, and ensures that our
  * subsequent execution stages actually have data to operate on.
+ * Returns the plan step already computed by the pipeline, if any.
  */
-static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
+static const PLN_BaseStep *buildImplicitPipeline(AREQ *req, QueryError *Status) {
   RedisSearchCtx *sctx = req->sctx;
   req->qiter.conc = &req->conc;
   req->qiter.sctx = sctx;
   req->qiter.err = Status;
+  clock_gettime(CLOCK_MONOTONIC, &req->qiter.startTime);
+  req->qiter.timeoutMS = req->tmoMS ? req->tmoMS : RSGlobalConfig.queryTimeoutMS;
+  req->qiter.timeoutPolicy =
+      req->tmoPolicy == TimeoutPolicy_Default ? RSGlobalConfig.timeoutPolicy : req->tmoPolicy;
 
   IndexSpecCache *cache = IndexSpec_GetSpecCache(req->sctx->spec);
   RS_LOG_ASSERT(cache, "IndexSpec_GetSpecCache failed")
@@ -940,16 +1186,36 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
 
   RLookup_Init(first, cache);
 
-  ResultProcessor *rp = RPIndexIterator_New(req->rootiter);
+  const PLN_BaseStep *folded = NULL;
+  ResultProcessor *rp = getTagCountRP(req, &folded);
+  if (!rp) {
+    rp = getCountRP(req);
+  }
+  int counted = rp != NULL;
+  const GeoFilter *distFilter = counted ? NULL : getDistanceFilter(req);
+  if (!counted) {
+    rp = getIndexRP(req, distFilter != NULL);
+  }
   ResultProcessor *rpUpstream = NULL;
   req->qiter.rootProc = req->qiter.endProc = rp;
   PUSH_RP();
 
+  if (distFilter) {
+    RLookupKey *dk = RLookup_GetKey(first, GEO_DISTANCE_PROPERTY,
+                                    RLOOKUP_F_OCREAT | RLOOKUP_F_NOINCREF | RLOOKUP_F_HIDDEN);
+    rp = RPGeoDistance_New(distFilter, dk);
+    PUSH_RP();
+  }
+
   /** Create a scorer if there is no subsequent sorter within this grouping */
-  if (!hasQuerySortby(&req->ap) && (req->reqflags & QEXEC_F_IS_SEARCH)) {
+  if (!counted && !hasQuerySortby(&req->ap) && (req->reqflags & QEXEC_F_IS_SEARCH)) {
     rp = getScorerRP(req);
     PUSH_RP();
+    if (req->searchopts.flags & Search_PruneScores) {
+      enableScorePruning(req);
+    }
   }
+  return folded;
 }
 
 /**
@@ -1010,8 +1276,9 @@ error:
 }
 
 int AREQ_BuildPipeline(AREQ *req, int options, QueryError *status) {
+  const PLN_BaseStep *folded = NULL;
   if (!(options & AREQ_BUILDPIPELINE_NO_ROOT)) {
-    buildImplicitPipeline(req, status);
+    folded = buildImplicitPipeline(req, status);
   }
 
   AGGPlan *pln = &req->ap;
@@ -1022,6 +1289,10 @@ int AREQ_BuildPipeline(AREQ *req, int options, QueryError *status) {
 
   for (const DLLIST_node *nn = pln->steps.next; nn != &pln->steps; nn = nn->next) {
     const PLN_BaseStep *stp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+    if (stp == folded) {
+      // Already computed by the root processor
+      continue;
+    }
 
     switch (stp->type) {
       case PLN_T_GROUP: {
@@ -1055,6 +1326,9 @@ int AREQ_BuildPipeline(AREQ *req, int options, QueryError *status) {
         if (!ExprAST_GetLookupKeys(mstp->parsedExpr, curLookup, status)) {
           goto error;
         }
+        if (curLookup == AGPLN_GetLookup(pln, NULL, AGPLN_GETLOOKUP_FIRST)) {
+          rpUpstream = pushDocValuesRP(req, curLookup, rpUpstream);
+        }
 
         if (stp->type == PLN_T_APPLY) {
           RLookupKey *dstkey =
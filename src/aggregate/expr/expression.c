@@ -1,4 +1,5 @@
 #include "expression.h"
+#include "exprprog.h"
 #include "result_processor.h"
 #include "rlookup.h"
 
@@ -228,6 +229,9 @@ static int evalInternal(ExprEval *eval, const RSExpr *e, RSValue *res) {
 }
 
 int ExprEval_Eval(ExprEval *evaluator, RSValue *result) {
+  if (evaluator->prog) {
+    return ExprProgram_Eval(evaluator->prog, evaluator, result);
+  }
   return evalInternal(evaluator, evaluator->root, result);
 }
 
@@ -330,6 +334,9 @@ error:
 }
 
 void EvalCtx_Destroy(EvalCtx *r) {
+  if (r->ee.prog) {
+    ExprProgram_Free(r->ee.prog);
+  }
   if (r->_expr && r->_own_expr) {
     ExprAST_Free((RSExpr *) r->_expr);
   }
@@ -358,6 +365,11 @@ int EvalCtx_Eval(EvalCtx *r) {
   if (!r->_expr) {
     return REDISMODULE_ERR;
   }
+  // Evaluated once with the tree evaluator; a program compiled earlier may be for another expression
+  if (r->ee.prog) {
+    ExprProgram_Free(r->ee.prog);
+    r->ee.prog = NULL;
+  }
   r->ee.root = r->_expr;
   if (ExprAST_GetLookupKeys((RSExpr *) r->ee.root, (RLookup *) r->ee.lookup, r->ee.err) != EXPR_EVAL_OK) {
     return REDISMODULE_ERR;
@@ -461,6 +473,9 @@ static void rpevalFree(ResultProcessor *rp) {
     RSValue_Decref(ee->val);
   }
   BlkAlloc_FreeAll(&ee->eval.stralloc, NULL, NULL, 0);
+  if (ee->eval.prog) {
+    ExprProgram_Free(ee->eval.prog);
+  }
   rm_free(ee);
 }
 static ResultProcessor *RPEvaluator_NewCommon(const RSExpr *ast, const RLookup *lookup,
@@ -471,6 +486,8 @@ static ResultProcessor *RPEvaluator_NewCommon(const RSExpr *ast, const RLookup *
   rp->base.name = isFilter ? "Filter" : "Projector";
   rp->eval.lookup = lookup;
   rp->eval.root = ast;
+  // The expression is evaluated for every row, so compile it once
+  rp->eval.prog = ExprProgram_Compile(ast);
   rp->outkey = dstkey;
   BlkAlloc_Init(&rp->eval.stralloc);
   return &rp->base;
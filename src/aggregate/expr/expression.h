@@ -107,6 +107,8 @@ typedef struct ExprEval {
   const RLookupRow *srcrow;
   const RSExpr *root;
   BlkAlloc stralloc; // Optional. YNOT?
+  // If set, root compiled into a program, which is evaluated instead of the tree
+  struct ExprProgram *prog;
 } ExprEval;
 
 #define EXPR_EVAL_ERR 0
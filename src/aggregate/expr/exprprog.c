@@ -0,0 +1,512 @@
+#include "exprprog.h"
+#include "rlookup.h"
+#include "util/arr.h"
+
+#include <math.h>
+
+extern int func_exists(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc, QueryError *err);
+
+/* Where an instruction reads an operand from */
+typedef enum {
+  // A number register
+  EXPR_ARG_NUM,
+  // A value register. Register 0 is the evaluation's result
+  EXPR_ARG_VALUE,
+  // A literal of the expression
+  EXPR_ARG_CONST,
+} ExprArgKind;
+
+typedef struct {
+  uint16_t kind;
+  uint16_t idx;
+} ExprArg;
+
+typedef enum {
+  // value[dst] = the row's value of `key`
+  EXPR_I_PROP,
+  // value[dst] = a, as a reference to a literal or a boxed number
+  EXPR_I_LOAD,
+  // num[dst] = a <flags> b, converting value operands to numbers
+  EXPR_I_ARITH,
+  // num[dst] = a <flags> b, for any two values
+  EXPR_I_CMP,
+  // num[dst] = a <flags> b, when both operands are numbers
+  EXPR_I_NCMP,
+  // The left side of && or ||: if it decides the predicate, set num[dst] and jump to `target`
+  EXPR_I_TEST,
+  // The right side of && or ||: num[dst] = the truth of a
+  EXPR_I_BOOL,
+  // num[dst] = !a
+  EXPR_I_NOT,
+  // value[dst] = func(value[a.idx], ..., value[a.idx + nargs - 1])
+  EXPR_I_CALL,
+} ExprOpcode;
+
+// EXPR_I_PROP flags
+#define EXPR_PROP_NULLOK 0x01  // a missing value is passed on as NULL instead of failing
+#define EXPR_PROP_ROOT 0x02    // a missing value makes the evaluation return EXPR_EVAL_NULL
+
+typedef struct {
+  uint8_t op;
+  // The arithmetic operator, the predicate's condition or the PROP flags
+  uint8_t flags;
+  uint16_t dst;
+  ExprArg a;
+  ExprArg b;
+  union {
+    const RLookupKey *key;
+    const RSFunctionExpr *func;
+    uint32_t target;
+  };
+} ExprInstr;
+
+struct ExprProgram {
+  arrayof(ExprInstr) code;
+  // Literals of the expression, referenced by EXPR_ARG_CONST operands
+  arrayof(const RSValue *) consts;
+  // Number registers, starting with the numeric literals and folded constants
+  arrayof(double) nums;
+  // Value registers. The first one stands for the evaluation's result and is never used
+  RSValue *values;
+  size_t nvalues;
+  // Where the value of the whole expression ends up
+  ExprArg result;
+  // A predicate was folded away. Predicates fail on an error raised before them, and the only
+  // such error is one the evaluator already had, so check it once up front
+  int failOnError;
+};
+
+static uint16_t newValueReg(ExprProgram *p) {
+  return p->nvalues++;
+}
+
+static ExprArg newNumReg(ExprProgram *p, double n) {
+  p->nums = array_append(p->nums, n);
+  return (ExprArg){.kind = EXPR_ARG_NUM, .idx = array_len(p->nums) - 1};
+}
+
+static void emit(ExprProgram *p, ExprInstr in) {
+  p->code = array_append(p->code, in);
+}
+
+/* Literals and operators over them, which always evaluate to the same value */
+static int isConstant(const RSExpr *e) {
+  switch (e->t) {
+    case RSExpr_Literal:
+      return 1;
+    case RSExpr_Op:
+      return isConstant(e->op.left) && isConstant(e->op.right);
+    case RSExpr_Predicate:
+      return isConstant(e->pred.left) && isConstant(e->pred.right);
+    case RSExpr_Inverted:
+      return isConstant(e->inverted.child);
+    default:
+      return 0;
+  }
+}
+
+static int hasPredicate(const RSExpr *e) {
+  switch (e->t) {
+    case RSExpr_Op:
+      return hasPredicate(e->op.left) || hasPredicate(e->op.right);
+    case RSExpr_Predicate:
+      return 1;
+    case RSExpr_Inverted:
+      return hasPredicate(e->inverted.child);
+    default:
+      return 0;
+  }
+}
+
+/* Evaluate a constant operator with the tree evaluator. Returns 0 if it fails, so that the error
+ * is raised when the program runs, as it would be without folding */
+static int foldConstant(const RSExpr *e, double *n) {
+  QueryError status = {0};
+  ExprEval eval = {.err = &status, .root = e};
+  RSValue v = RSVALUE_STATIC;
+  int ok = ExprEval_Eval(&eval, &v) == EXPR_EVAL_OK && !QueryError_HasError(&status) &&
+           v.t == RSValue_Number;
+  if (ok) {
+    *n = v.numval;
+  }
+  RSValue_Clear(&v);
+  QueryError_ClearError(&status);
+  return ok;
+}
+
+/* Turn numeric literals into number registers, so arithmetic on them needs no conversion */
+static ExprArg numericArg(ExprProgram *p, ExprArg a) {
+  if (a.kind == EXPR_ARG_CONST) {
+    const RSValue *v = RSValue_Dereference(p->consts[a.idx]);
+    if (v->t == RSValue_Number) {
+      return newNumReg(p, v->numval);
+    }
+  }
+  return a;
+}
+
+static ExprArg compileExpr(ExprProgram *p, const RSExpr *e, int dst, int propFlags);
+
+/* Compile an expression whose value must end up in a given value register */
+static void compileInto(ExprProgram *p, const RSExpr *e, uint16_t dst, int propFlags) {
+  ExprArg a = compileExpr(p, e, dst, propFlags);
+  if (a.kind != EXPR_ARG_VALUE) {
+    emit(p, (ExprInstr){.op = EXPR_I_LOAD, .dst = dst, .a = a});
+  }
+}
+
+static ExprArg compileFunc(ExprProgram *p, const RSFunctionExpr *f, int dst) {
+  // Arguments take consecutive registers
+  uint16_t base = p->nvalues;
+  p->nvalues += f->args->len;
+  int argFlags = f->Call == func_exists ? EXPR_PROP_NULLOK : 0;
+  for (size_t ii = 0; ii < f->args->len; ii++) {
+    compileInto(p, f->args->args[ii], base + ii, argFlags);
+  }
+
+  uint16_t out = dst >= 0 ? dst : newValueReg(p);
+  emit(p, (ExprInstr){.op = EXPR_I_CALL,
+                      .dst = out,
+                      .a = {.kind = EXPR_ARG_VALUE, .idx = base},
+                      .func = f});
+  return (ExprArg){.kind = EXPR_ARG_VALUE, .idx = out};
+}
+
+static ExprArg compilePredicate(ExprProgram *p, const RSPredicate *pred) {
+  if (pred->cond == RSCondition_And || pred->cond == RSCondition_Or) {
+    ExprArg l = compileExpr(p, pred->left, -1, 0);
+    ExprArg out = newNumReg(p, 0);
+    size_t test = array_len(p->code);
+    emit(p, (ExprInstr){.op = EXPR_I_TEST, .flags = pred->cond, .dst = out.idx, .a = l});
+    ExprArg r = compileExpr(p, pred->right, -1, 0);
+    emit(p, (ExprInstr){.op = EXPR_I_BOOL, .flags = pred->cond, .dst = out.idx, .a = r});
+    p->code[test].target = array_len(p->code);
+    return out;
+  }
+
+  ExprArg l = numericArg(p, compileExpr(p, pred->left, -1, 0));
+  ExprArg r = numericArg(p, compileExpr(p, pred->right, -1, 0));
+  ExprArg out = newNumReg(p, 0);
+  int numeric = l.kind == EXPR_ARG_NUM && r.kind == EXPR_ARG_NUM;
+  emit(p, (ExprInstr){.op = numeric ? EXPR_I_NCMP : EXPR_I_CMP,
+                      .flags = pred->cond,
+                      .dst = out.idx,
+                      .a = l,
+                      .b = r});
+  return out;
+}
+
+/* Compile an expression, returning where its value is. Properties and function calls are written
+ * to value register `dst` if it is not negative */
+static ExprArg compileExpr(ExprProgram *p, const RSExpr *e, int dst, int propFlags) {
+  if (e->t != RSExpr_Literal && isConstant(e)) {
+    double n;
+    if (foldConstant(e, &n)) {
+      p->failOnError |= hasPredicate(e);
+      return newNumReg(p, n);
+    }
+  }
+
+  switch (e->t) {
+    case RSExpr_Literal:
+      p->consts = array_append(p->consts, &e->literal);
+      return (ExprArg){.kind = EXPR_ARG_CONST, .idx = array_len(p->consts) - 1};
+
+    case RSExpr_Property: {
+      uint16_t out = dst >= 0 ? dst : newValueReg(p);
+      emit(p, (ExprInstr){.op = EXPR_I_PROP,
+                          .flags = propFlags,
+                          .dst = out,
+                          .key = e->property.lookupObj});
+      return (ExprArg){.kind = EXPR_ARG_VALUE, .idx = out};
+    }
+
+    case RSExpr_Op: {
+      ExprArg l = numericArg(p, compileExpr(p, e->op.left, -1, 0));
+      ExprArg r = numericArg(p, compileExpr(p, e->op.right, -1, 0));
+      ExprArg out = newNumReg(p, 0);
+      emit(p, (ExprInstr){.op = EXPR_I_ARITH, .flags = e->op.op, .dst = out.idx, .a = l, .b = r});
+      return out;
+    }
+
+    case RSExpr_Function:
+      return compileFunc(p, &e->func, dst);
+
+    case RSExpr_Predicate:
+      return compilePredicate(p, &e->pred);
+
+    case RSExpr_Inverted: {
+      ExprArg a = compileExpr(p, e->inverted.child, -1, 0);
+      ExprArg out = newNumReg(p, 0);
+      emit(p, (ExprInstr){.op = EXPR_I_NOT, .dst = out.idx, .a = a});
+      return out;
+    }
+  }
+  return (ExprArg){0};
+}
+
+ExprProgram *ExprProgram_Compile(const RSExpr *root) {
+  ExprProgram *p = rm_calloc(1, sizeof(*p));
+  p->code = array_new(ExprInstr, 8);
+  p->consts = array_new(const RSValue *, 4);
+  p->nums = array_new(double, 8);
+  p->nvalues = 1;
+
+  p->result = compileExpr(p, root, 0, EXPR_PROP_NULLOK | EXPR_PROP_ROOT);
+  if (p->result.kind == EXPR_ARG_CONST) {
+    // A literal is returned as a reference to it
+    emit(p, (ExprInstr){.op = EXPR_I_LOAD, .dst = 0, .a = p->result});
+    p->result = (ExprArg){.kind = EXPR_ARG_VALUE, .idx = 0};
+  }
+
+  p->values = rm_calloc(p->nvalues, sizeof(*p->values));
+  return p;
+}
+
+size_t ExprProgram_Len(const ExprProgram *p) {
+  return array_len(p->code);
+}
+
+void ExprProgram_Free(ExprProgram *p) {
+  for (size_t ii = 1; ii < p->nvalues; ii++) {
+    RSValue_Clear(p->values + ii);
+  }
+  rm_free(p->values);
+  array_free(p->code);
+  array_free(p->consts);
+  array_free(p->nums);
+  rm_free(p);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#define VALUE_REG(idx) ((idx) ? p->values + (idx) : result)
+
+/* The operand as a value. Numbers are boxed into `tmp` */
+static inline const RSValue *argValue(ExprProgram *p, RSValue *result, ExprArg a, RSValue *tmp) {
+  switch (a.kind) {
+    case EXPR_ARG_NUM:
+      tmp->t = RSValue_Number;
+      tmp->numval = p->nums[a.idx];
+      return tmp;
+    case EXPR_ARG_VALUE:
+      return VALUE_REG(a.idx);
+    default:
+      return p->consts[a.idx];
+  }
+}
+
+static inline int argBool(ExprProgram *p, RSValue *result, ExprArg a) {
+  if (a.kind == EXPR_ARG_NUM) {
+    return p->nums[a.idx] != 0;
+  }
+  RSValue tmp = RSVALUE_STATIC;
+  return RSValue_BoolTest(argValue(p, result, a, &tmp));
+}
+
+static inline int argNumber(ExprProgram *p, RSValue *result, ExprArg a, double *n) {
+  if (a.kind == EXPR_ARG_NUM) {
+    *n = p->nums[a.idx];
+    return 1;
+  }
+  RSValue tmp = RSVALUE_STATIC;
+  return RSValue_ToNumber(argValue(p, result, a, &tmp), n);
+}
+
+static inline double arith(int op, double n1, double n2) {
+  switch (op) {
+    case '+':
+      return n1 + n2;
+    case '/':
+      return n1 / n2;
+    case '-':
+      return n1 - n2;
+    case '*':
+      return n1 * n2;
+    case '%':
+      return (long long)n1 % (long long)n2;
+    case '^':
+      return pow(n1, n2);
+    default:
+      return NAN;
+  }
+}
+
+static inline int numCompare(RSCondition cond, double n1, double n2) {
+  int cmp = n1 > n2 ? 1 : (n1 < n2 ? -1 : 0);
+  switch (cond) {
+    case RSCondition_Eq:
+      return cmp == 0;
+    case RSCondition_Lt:
+      return cmp < 0;
+    case RSCondition_Le:
+      return cmp <= 0;
+    case RSCondition_Gt:
+      return cmp > 0;
+    case RSCondition_Ge:
+      return cmp >= 0;
+    case RSCondition_Ne:
+      return cmp != 0;
+    default:
+      return 0;
+  }
+}
+
+static inline int valueCompare(RSCondition cond, const RSValue *l, const RSValue *r,
+                               QueryError *qerr) {
+  switch (cond) {
+    case RSCondition_Eq:
+      return RSValue_Equal(l, r, qerr);
+    case RSCondition_Lt:
+      return RSValue_Cmp(l, r, qerr) < 0;
+    case RSCondition_Le:
+      return RSValue_Cmp(l, r, qerr) <= 0;
+    case RSCondition_Gt:
+      return RSValue_Cmp(l, r, qerr) > 0;
+    case RSCondition_Ge:
+      return RSValue_Cmp(l, r, qerr) >= 0;
+    case RSCondition_Ne:
+      return !RSValue_Equal(l, r, qerr);
+    default:
+      return 0;
+  }
+}
+
+// A predicate fails if an error was raised while evaluating the row, as in the tree evaluator
+#define HAS_ERROR(eval) ((eval)->err && (eval)->err->code != QUERY_OK)
+
+static int runProgram(ExprProgram *p, ExprEval *eval, RSValue *result) {
+  int rc = EXPR_EVAL_OK;
+  const ExprInstr *code = p->code;
+  size_t len = array_len(p->code);
+
+  for (size_t pc = 0; pc < len; pc++) {
+    const ExprInstr *in = code + pc;
+    switch (in->op) {
+      case EXPR_I_PROP: {
+        RSValue *dst = VALUE_REG(in->dst);
+        if (!in->key) {
+          if (eval->err) {
+            QueryError_SetError(eval->err, QUERY_ENOPROPKEY, NULL);
+          }
+          return EXPR_EVAL_ERR;
+        }
+        RSValue *value = RLookup_GetItem(in->key, eval->srcrow);
+        if (!value) {
+          if (eval->err) {
+            QueryError_SetError(eval->err, QUERY_ENOPROPVAL, NULL);
+          }
+          dst->t = RSValue_Null;
+          if (!(in->flags & EXPR_PROP_NULLOK)) {
+            return EXPR_EVAL_ERR;
+          }
+          if (in->flags & EXPR_PROP_ROOT) {
+            rc = EXPR_EVAL_NULL;
+          }
+          break;
+        }
+        RSValue_MakeReference(dst, value);
+        break;
+      }
+
+      case EXPR_I_LOAD: {
+        RSValue *dst = VALUE_REG(in->dst);
+        if (in->a.kind == EXPR_ARG_NUM) {
+          RSValue_Clear(dst);
+          dst->t = RSValue_Number;
+          dst->numval = p->nums[in->a.idx];
+        } else {
+          RSValue_MakeReference(dst, (RSValue *)p->consts[in->a.idx]);
+        }
+        break;
+      }
+
+      case EXPR_I_ARITH: {
+        double n1, n2;
+        if (!argNumber(p, result, in->a, &n1) || !argNumber(p, result, in->b, &n2)) {
+          QueryError_SetError(eval->err, QUERY_ENOTNUMERIC, NULL);
+          return EXPR_EVAL_ERR;
+        }
+        p->nums[in->dst] = arith(in->flags, n1, n2);
+        break;
+      }
+
+      case EXPR_I_NCMP:
+        p->nums[in->dst] = numCompare(in->flags, p->nums[in->a.idx], p->nums[in->b.idx]);
+        if (HAS_ERROR(eval)) {
+          return EXPR_EVAL_ERR;
+        }
+        break;
+
+      case EXPR_I_CMP: {
+        RSValue t1 = RSVALUE_STATIC, t2 = RSVALUE_STATIC;
+        const RSValue *l = argValue(p, result, in->a, &t1);
+        const RSValue *r = argValue(p, result, in->b, &t2);
+        p->nums[in->dst] = valueCompare(in->flags, l, r, eval->err);
+        if (HAS_ERROR(eval)) {
+          return EXPR_EVAL_ERR;
+        }
+        break;
+      }
+
+      case EXPR_I_TEST: {
+        int b = argBool(p, result, in->a);
+        if (b == (in->flags == RSCondition_Or)) {
+          p->nums[in->dst] = b;
+          if (HAS_ERROR(eval)) {
+            return EXPR_EVAL_ERR;
+          }
+          // the loop increments pc
+          pc = in->target - 1;
+        }
+        break;
+      }
+
+      case EXPR_I_BOOL:
+        p->nums[in->dst] = argBool(p, result, in->a);
+        if (HAS_ERROR(eval)) {
+          return EXPR_EVAL_ERR;
+        }
+        break;
+
+      case EXPR_I_NOT:
+        p->nums[in->dst] = !argBool(p, result, in->a);
+        break;
+
+      case EXPR_I_CALL: {
+        size_t nargs = in->func->args->len;
+        RSValue *argv[nargs ? nargs : 1];
+        for (size_t ii = 0; ii < nargs; ii++) {
+          argv[ii] = p->values + in->a.idx + ii;
+        }
+        int callrc = in->func->Call(eval, VALUE_REG(in->dst), argv, nargs, eval->err);
+        for (size_t ii = 0; ii < nargs; ii++) {
+          RSValue_Clear(argv[ii]);
+        }
+        if (callrc != EXPR_EVAL_OK) {
+          return in->dst ? EXPR_EVAL_ERR : callrc;
+        }
+        break;
+      }
+    }
+  }
+
+  if (p->result.kind == EXPR_ARG_NUM) {
+    result->numval = p->nums[p->result.idx];
+    result->t = RSValue_Number;
+  }
+  return rc;
+}
+
+int ExprProgram_Eval(ExprProgram *p, ExprEval *eval, RSValue *result) {
+  RSValue_Clear(result);
+  if (p->failOnError && HAS_ERROR(eval)) {
+    return EXPR_EVAL_ERR;
+  }
+  int rc = runProgram(p, eval, result);
+  // Drop the row's values held by the registers
+  for (size_t ii = 1; ii < p->nvalues; ii++) {
+    RSValue_Clear(p->values + ii);
+  }
+  return rc;
+}
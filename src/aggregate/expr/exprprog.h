@@ -0,0 +1,39 @@
+#ifndef RS_AGG_EXPRPROG_H_
+#define RS_AGG_EXPRPROG_H_
+
+#include "expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An expression compiled into a flat list of instructions over a register file.
+ *
+ * Expressions are compiled once per query (or per schema rule), after their lookup keys have been
+ * resolved. Constant sub-expressions are folded at compile time, and arithmetic, predicates and
+ * negations between numbers run on plain double registers, so only properties, string literals
+ * and function calls go through RSValues. The registers belong to the program and are reused for
+ * every row, so a program may only be evaluated by one thread at a time.
+ *
+ * Evaluating a program gives the same results and errors as evaluating its expression tree.
+ */
+typedef struct ExprProgram ExprProgram;
+
+/* Compile the expression. Its lookup keys must already be resolved (see ExprAST_GetLookupKeys).
+ * The expression must outlive the program */
+ExprProgram *ExprProgram_Compile(const RSExpr *root);
+
+/* Evaluate the program for the evaluator's row. Returns EXPR_EVAL_OK, EXPR_EVAL_NULL or
+ * EXPR_EVAL_ERR, like ExprEval_Eval */
+int ExprProgram_Eval(ExprProgram *prog, ExprEval *eval, RSValue *result);
+
+/* Number of instructions in the program. Folded constants take none */
+size_t ExprProgram_Len(const ExprProgram *prog);
+
+void ExprProgram_Free(ExprProgram *prog);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
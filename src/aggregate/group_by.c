@@ -2,6 +2,7 @@
 #include <result_processor.h>
 #include <util/block_alloc.h>
 #include <util/khash.h>
+#include "concurrent_ctx.h"
 #include "reducer.h"
 
 /**
@@ -34,21 +35,45 @@ typedef struct {
 static const int khid = 33;
 KHASH_MAP_INIT_INT64(khid, Group *);
 
-#define GROUPER_NREDUCERS(g) (array_len((g)->reducers))
-#define GROUP_BYTESIZE(parent) (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(parent)))
+#define GROUPER_NREDUCERS(t) (array_len((t)->reducers))
+#define GROUP_BYTESIZE(t) (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(t)))
 #define GROUPS_PER_BLOCK 1024
 #define GROUPER_NSRCKEYS(g) ((g)->nkeys)
 
-typedef struct Grouper {
-  // Result processor base, for use in row processing
-  ResultProcessor base;
+// Rows handed to each worker in every round of a parallel accumulation
+#define GROUPER_WORKER_ROWS 1024
 
+/** The groups accumulated by the grouper, or by one of its workers */
+typedef struct {
   // Map of group_name => `Group` structure
   khash_t(khid) * groups;
 
   // Backing store for the groups themselves
   BlkAlloc groupsAlloc;
 
+  // array of reducers
+  Reducer **reducers;
+
+  // Worker tables keep copies of the group values, see createGroup()
+  int copyValues;
+} GroupTable;
+
+typedef struct {
+  const struct Grouper *parent;
+  GroupTable table;
+
+  // The rows of the current round
+  SearchResult *rows;
+  size_t nrows;
+} GroupWorker;
+
+typedef struct Grouper {
+  // Result processor base, for use in row processing
+  ResultProcessor base;
+
+  // The groups to yield
+  GroupTable table;
+
   /**
    * Keys to group by. Both srckeys and dstkeys are used because different lookups
    * are employed. The srckeys are the lookup keys for the properties as they
@@ -59,13 +84,52 @@ typedef struct Grouper {
   const RLookupKey **dstkeys;
   size_t nkeys;
 
-  // array of reducers
-  Reducer **reducers;
+  // Workers accumulating in parallel, merged into `table` at the end of the input
+  GroupWorker *workers;
+  size_t nworkers;
+
+  // Rows read from upstream for a round of the workers
+  SearchResult *rows;
 
   // Used for maintaining state when yielding groups
   khiter_t iter;
 } Grouper;
 
+static void groupTableInit(GroupTable *t) {
+  BlkAlloc_Init(&t->groupsAlloc);
+  t->groups = kh_init(khid);
+}
+
+/**
+ * Worker threads may not change the reference counts of row values, which other rows and threads
+ * can share. Their groups keep copies of the values instead
+ */
+static RSValue *copyGroupValue(const RSValue *v) {
+  v = RSValue_Dereference(v);
+  switch (v->t) {
+    case RSValue_Number:
+      return RS_NumVal(v->numval);
+    case RSValue_String:
+    case RSValue_RedisString:
+    case RSValue_OwnRstring: {
+      size_t n;
+      const char *s = RSValue_StringPtrLen(v, &n);
+      return RS_NewCopiedString(s, n);
+    }
+    case RSValue_Array: {
+      uint32_t n = RSValue_ArrayLen(v);
+      RSValue **vals = rm_malloc(n * sizeof(*vals));
+      for (uint32_t ii = 0; ii < n; ++ii) {
+        vals[ii] = copyGroupValue(RSValue_ArrayItem(v, ii));
+      }
+      return RSValue_NewArrayEx(vals, n, RSVAL_ARRAY_ALLOC | RSVAL_ARRAY_NOINCREF);
+    }
+    default:
+      // not the shared RS_NullVal(), whose reference count is not ours to change either
+      return RS_NewValue(RSValue_Null);
+  }
+}
+
 /**
  * Create a new group. groupvals is the key of the group. This will be the
  * number of field arguments passed to GROUPBY, e.g.
@@ -73,23 +137,25 @@ typedef struct Grouper {
  *
  * These will be placed in the output row.
  */
-static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
-  size_t numReducers = array_len(g->reducers);
-  size_t elemSize = GROUP_BYTESIZE(g);
-  Group *group = BlkAlloc_Alloc(&g->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
+static Group *createGroup(const Grouper *g, GroupTable *t, const RSValue **groupvals,
+                          size_t ngrpvals) {
+  size_t numReducers = GROUPER_NREDUCERS(t);
+  size_t elemSize = GROUP_BYTESIZE(t);
+  Group *group = BlkAlloc_Alloc(&t->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
   memset(group, 0, elemSize);
 
   for (size_t ii = 0; ii < numReducers; ++ii) {
-    group->accumdata[ii] = g->reducers[ii]->NewInstance(g->reducers[ii]);
+    group->accumdata[ii] = t->reducers[ii]->NewInstance(t->reducers[ii]);
   }
 
   /** Initialize the row data! */
   for (size_t ii = 0; ii < ngrpvals; ++ii) {
     const RLookupKey *dstkey = g->dstkeys[ii];
-    RLookup_WriteKey(dstkey, &group->rowdata, (RSValue *)groupvals[ii]);
-    // printf("Write: %s => ", dstkey->name);
-    // RSValue_Print(groupvals[ii]);
-    // printf("\n");
+    if (t->copyValues) {
+      RLookup_WriteOwnKey(dstkey, &group->rowdata, copyGroupValue(groupvals[ii]));
+    } else {
+      RLookup_WriteKey(dstkey, &group->rowdata, (RSValue *)groupvals[ii]);
+    }
   }
   return group;
 }
@@ -107,21 +173,21 @@ static void writeGroupValues(const Grouper *g, const Group *gr, SearchResult *r)
 static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
   Grouper *g = (Grouper *)base;
 
-  while (g->iter != kh_end(g->groups)) {
-    if (!kh_exist(g->groups, g->iter)) {
+  while (g->iter != kh_end(g->table.groups)) {
+    if (!kh_exist(g->table.groups, g->iter)) {
       g->iter++;
       continue;
     }
 
-    Group *gr = kh_value(g->groups, g->iter);
+    Group *gr = kh_value(g->table.groups, g->iter);
     // no reducers; just a terminal GROUPBY...
 
-    if (!GROUPER_NREDUCERS(g)) {
+    if (!GROUPER_NREDUCERS(&g->table)) {
       writeGroupValues(g, gr, r);
     }
     // else...
-    for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
-      Reducer *rd = g->reducers[ii];
+    for (size_t ii = 0; ii < GROUPER_NREDUCERS(&g->table); ++ii) {
+      Reducer *rd = g->table.reducers[ii];
       RSValue *v = rd->Finalize(rd, gr->accumdata[ii]);
       if (v) {
         RLookup_WriteOwnKey(rd->dstkey, &r->rowdata, v);
@@ -139,10 +205,10 @@ static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
   return RS_RESULT_EOF;
 }
 
-static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
-  size_t nreducers = GROUPER_NREDUCERS(g);
+static void invokeReducers(GroupTable *t, Group *gr, RLookupRow *srcrow) {
+  size_t nreducers = GROUPER_NREDUCERS(t);
   for (size_t ii = 0; ii < nreducers; ii++) {
-    g->reducers[ii]->Add(g->reducers[ii], gr->accumdata[ii], srcrow);
+    t->reducers[ii]->Add(t->reducers[ii], gr->accumdata[ii], srcrow);
   }
 }
 
@@ -151,6 +217,7 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
  * Add() for each cartesian product of the current row.
  *
  * @param g the grouper
+ * @param t the table holding the groups
  * @param xarr the array of 'x' values - i.e. the raw results received from the
  *  upstream result processor. The number of results can be found via
  *  the `GROUPER_NSRCKEYS(g)` macro
@@ -162,23 +229,23 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
  *  are not hashed together.
  * @param res the row is passed to each reducer
  */
-static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t xlen, size_t arridx,
-                          uint64_t hval, RLookupRow *res) {
+static void extractGroups(const Grouper *g, GroupTable *t, const RSValue **xarr, size_t xpos,
+                          size_t xlen, size_t arridx, uint64_t hval, RLookupRow *res) {
   // end of the line - create/add to group
   if (xpos == xlen) {
     Group *group = NULL;
 
     // Get or create the group
-    khiter_t k = kh_get(khid, g->groups, hval);  // first have to get ieter
-    if (k == kh_end(g->groups)) {                // k will be equal to kh_end if key not present
-      group = createGroup(g, xarr, xlen);
-      kh_set(khid, g->groups, hval, group);
+    khiter_t k = kh_get(khid, t->groups, hval);  // first have to get ieter
+    if (k == kh_end(t->groups)) {                // k will be equal to kh_end if key not present
+      group = createGroup(g, t, xarr, xlen);
+      kh_set(khid, t->groups, hval, group);
     } else {
-      group = kh_value(g->groups, k);
+      group = kh_value(t->groups, k);
     }
 
     // send the result to the group and its reducers
-    invokeReducers(g, group, res);
+    invokeReducers(t, group, res);
     return;
   }
 
@@ -187,7 +254,7 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
   // regular value - just move one step -- increment XPOS
   if (v->t != RSValue_Array) {
     hval = RSValue_Hash(v, hval);
-    extractGroups(g, xarr, xpos + 1, xlen, 0, hval, res);
+    extractGroups(g, t, xarr, xpos + 1, xlen, 0, hval, res);
   } else {
     // Array value. Replace current XPOS with child temporarily
     const RSValue *array = xarr[xpos];
@@ -205,17 +272,17 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
     uint64_t hh = RSValue_Hash(elem, hval);
 
     xarr[xpos] = elem;
-    extractGroups(g, xarr, xpos, xlen, arridx, hh, res);
+    extractGroups(g, t, xarr, xpos, xlen, arridx, hh, res);
     xarr[xpos] = array;
 
     // Replace the value back, and proceed to the next value of the array
     if (++arridx < RSValue_ArrayLen(v)) {
-      extractGroups(g, xarr, xpos, xlen, arridx, hval, res);
+      extractGroups(g, t, xarr, xpos, xlen, arridx, hval, res);
     }
   }
 }
 
-static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
+static void invokeGroupReducers(const Grouper *g, GroupTable *t, RLookupRow *srcrow) {
   uint64_t hval = 0;
   size_t nkeys = GROUPER_NSRCKEYS(g);
   const RSValue *groupvals[nkeys];
@@ -228,7 +295,7 @@ static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
     }
     groupvals[ii] = v;
   }
-  extractGroups(g, groupvals, 0, nkeys, 0, 0, srcrow);
+  extractGroups(g, t, groupvals, 0, nkeys, 0, 0, srcrow);
 }
 
 static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
@@ -237,12 +304,12 @@ static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
   int rc;
 
   while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
-    invokeGroupReducers(g, &res->rowdata);
+    invokeGroupReducers(g, &g->table, &res->rowdata);
     SearchResult_Clear(res);
   }
   if (rc == RS_RESULT_EOF) {
     base->Next = Grouper_rpYield;
-    base->parent->totalResults = kh_size(g->groups);
+    base->parent->totalResults = kh_size(g->table.groups);
     g->iter = kh_begin(khid);
     return Grouper_rpYield(base, res);
   } else {
@@ -250,9 +317,112 @@ static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
   }
 }
 
+static void groupWorkerRun(void *arg) {
+  GroupWorker *w = arg;
+  for (size_t ii = 0; ii < w->nrows; ++ii) {
+    invokeGroupReducers(w->parent, &w->table, &w->rows[ii].rowdata);
+  }
+}
+
+/* Split the rows between the workers, and wait for all of them */
+static void groupRunRound(Grouper *g, size_t nrows) {
+  size_t chunk = (nrows + g->nworkers - 1) / g->nworkers;
+  for (size_t ii = 0; ii < g->nworkers && ii * chunk < nrows; ++ii) {
+    GroupWorker *w = g->workers + ii;
+    w->rows = g->rows + ii * chunk;
+    w->nrows = MIN(chunk, nrows - ii * chunk);
+    ConcurrentSearch_ThreadPoolRun(groupWorkerRun, w, CONCURRENT_POOL_QUERY);
+  }
+  ConcurrentSearch_ThreadPoolWait(CONCURRENT_POOL_QUERY);
+  // Values are released on this thread only
+  for (size_t ii = 0; ii < nrows; ++ii) {
+    SearchResult_Clear(g->rows + ii);
+  }
+}
+
+static void groupTableFree(GroupTable *t);
+
+/* Merge the groups of every worker into the grouper's own table, and free the workers */
+static void groupMergeWorkers(Grouper *g) {
+  GroupTable *dt = &g->table;
+  size_t nreducers = GROUPER_NREDUCERS(dt);
+  const RSValue *groupvals[g->nkeys];
+
+  for (size_t ii = 0; ii < g->nworkers; ++ii) {
+    GroupTable *st = &g->workers[ii].table;
+    for (khiter_t it = kh_begin(st->groups); it != kh_end(st->groups); ++it) {
+      if (!kh_exist(st->groups, it)) {
+        continue;
+      }
+      uint64_t hval = kh_key(st->groups, it);
+      Group *src = kh_value(st->groups, it);
+      Group *dst;
+
+      khiter_t k = kh_get(khid, dt->groups, hval);
+      if (k == kh_end(dt->groups)) {
+        for (size_t jj = 0; jj < g->nkeys; ++jj) {
+          groupvals[jj] = RLookup_GetItem(g->dstkeys[jj], &src->rowdata);
+        }
+        dst = createGroup(g, dt, groupvals, g->nkeys);
+        kh_set(khid, dt->groups, hval, dst);
+      } else {
+        dst = kh_value(dt->groups, k);
+      }
+
+      for (size_t jj = 0; jj < nreducers; ++jj) {
+        dt->reducers[jj]->Merge(dt->reducers[jj], dst->accumdata[jj], src->accumdata[jj]);
+      }
+    }
+    groupTableFree(st);
+  }
+  rm_free(g->workers);
+  g->workers = NULL;
+  g->nworkers = 0;
+}
+
+/**
+ * Accumulate with the workers: rows are read in rounds of GROUPER_WORKER_ROWS per worker, and each
+ * worker groups its share of the round into its own table. The tables are merged at the end of
+ * the input.
+ */
+static int Grouper_rpAccumParallel(ResultProcessor *base, SearchResult *res) {
+  Grouper *g = (Grouper *)base;
+  size_t cap = g->nworkers * GROUPER_WORKER_ROWS;
+  int rc = RS_RESULT_OK;
+
+  if (!g->rows) {
+    g->rows = rm_calloc(cap, sizeof(*g->rows));
+  }
+  while (rc == RS_RESULT_OK) {
+    size_t nrows = 0;
+    while (nrows < cap &&
+           (rc = base->upstream->Next(base->upstream, g->rows + nrows)) == RS_RESULT_OK) {
+      ++nrows;
+    }
+    if (nrows) {
+      groupRunRound(g, nrows);
+    }
+  }
+  if (rc != RS_RESULT_EOF) {
+    return rc;
+  }
+
+  for (size_t ii = 0; ii < cap; ++ii) {
+    SearchResult_Destroy(g->rows + ii);
+  }
+  rm_free(g->rows);
+  g->rows = NULL;
+  groupMergeWorkers(g);
+
+  base->Next = Grouper_rpYield;
+  base->parent->totalResults = kh_size(g->table.groups);
+  g->iter = kh_begin(khid);
+  return Grouper_rpYield(base, res);
+}
+
 static void cleanCallback(void *ptr, void *arg) {
   Group *group = ptr;
-  Grouper *parent = arg;
+  GroupTable *parent = arg;
   // Call the reducer's FreeInstance
   for (size_t ii = 0; ii < GROUPER_NREDUCERS(parent); ++ii) {
     Reducer *rr = parent->reducers[ii];
@@ -262,23 +432,37 @@ static void cleanCallback(void *ptr, void *arg) {
   }
 }
 
-static void Grouper_rpFree(ResultProcessor *grrp) {
-  Grouper *g = (Grouper *)grrp;
-  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
-    if (!kh_exist(g->groups, it)) {
+static void groupTableFree(GroupTable *t) {
+  for (khiter_t it = kh_begin(t->groups); it != kh_end(t->groups); ++it) {
+    if (!kh_exist(t->groups, it)) {
       continue;
     }
-    Group *gr = kh_value(g->groups, it);
+    Group *gr = kh_value(t->groups, it);
     RLookupRow_Cleanup(&gr->rowdata);
   }
-  kh_destroy(khid, g->groups);
-  BlkAlloc_FreeAll(&g->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
+  kh_destroy(khid, t->groups);
+  BlkAlloc_FreeAll(&t->groupsAlloc, cleanCallback, t, GROUP_BYTESIZE(t));
+
+  for (size_t i = 0; i < GROUPER_NREDUCERS(t); i++) {
+    t->reducers[i]->Free(t->reducers[i]);
+  }
+  if (t->reducers) {
+    array_free(t->reducers);
+  }
+}
 
-  for (size_t i = 0; i < GROUPER_NREDUCERS(g); i++) {
-    g->reducers[i]->Free(g->reducers[i]);
+static void Grouper_rpFree(ResultProcessor *grrp) {
+  Grouper *g = (Grouper *)grrp;
+  groupTableFree(&g->table);
+  for (size_t ii = 0; ii < g->nworkers; ++ii) {
+    groupTableFree(&g->workers[ii].table);
   }
-  if (g->reducers) {
-    array_free(g->reducers);
+  rm_free(g->workers);
+  if (g->rows) {
+    for (size_t ii = 0; ii < g->nworkers * GROUPER_WORKER_ROWS; ++ii) {
+      SearchResult_Destroy(g->rows + ii);
+    }
+    rm_free(g->rows);
   }
   rm_free(g->srckeys);
   rm_free(g->dstkeys);
@@ -291,8 +475,7 @@ void Grouper_Free(Grouper *g) {
 
 Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, size_t nkeys) {
   Grouper *g = rm_calloc(1, sizeof(*g));
-  BlkAlloc_Init(&g->groupsAlloc);
-  g->groups = kh_init(khid);
+  groupTableInit(&g->table);
 
   g->srckeys = rm_calloc(nkeys, sizeof(*g->srckeys));
   g->dstkeys = rm_calloc(nkeys, sizeof(*g->dstkeys));
@@ -309,11 +492,26 @@ Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, siz
 }
 
 void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dstkey) {
-  Reducer **rpp = array_ensure_tail(&g->reducers, Reducer *);
+  Reducer **rpp = array_ensure_tail(&g->table.reducers, Reducer *);
   *rpp = r;
   r->dstkey = dstkey;
 }
 
+void Grouper_AddWorker(Grouper *g, Reducer **reducers) {
+  g->workers = rm_realloc(g->workers, (g->nworkers + 1) * sizeof(*g->workers));
+  GroupWorker *w = g->workers + g->nworkers++;
+  memset(w, 0, sizeof(*w));
+  w->parent = g;
+  groupTableInit(&w->table);
+  w->table.copyValues = 1;
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(&g->table); ++ii) {
+    Reducer **rpp = array_ensure_tail(&w->table.reducers, Reducer *);
+    *rpp = reducers[ii];
+    reducers[ii]->dstkey = g->table.reducers[ii]->dstkey;
+  }
+  g->base.Next = Grouper_rpAccumParallel;
+}
+
 ResultProcessor *Grouper_GetRP(Grouper *g) {
   return &g->base;
 }
@@ -72,6 +72,17 @@ typedef struct Reducer {
    */
   RSValue *(*Finalize)(struct Reducer *parent, void *instance);
 
+  /**
+   * Merges the state accumulated in the `src` instance into `dst`. `src` may
+   * come from another reducer built with the same options, which still frees it
+   * afterwards.
+   *
+   * Reducers which implement this may have rows added from worker threads, so
+   * their Add() must not keep references to row values. Reducers which leave
+   * it NULL are always run on the query's own thread.
+   */
+  void (*Merge)(struct Reducer *parent, void *dst, void *src);
+
   /** Frees the object created by NewInstance() */
   void (*FreeInstance)(struct Reducer *parent, void *instance);
 
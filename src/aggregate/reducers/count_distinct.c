@@ -45,6 +45,21 @@ static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void distinctMerge(Reducer *r, void *dst, void *src) {
+  distinctCounter *dctr = dst;
+  const distinctCounter *sctr = src;
+  for (khiter_t it = kh_begin(sctr->dedup); it != kh_end(sctr->dedup); ++it) {
+    if (!kh_exist(sctr->dedup, it)) {
+      continue;
+    }
+    int ret;
+    kh_put(khid, dctr->dedup, kh_key(sctr->dedup, it), &ret);
+    if (ret) {
+      dctr->count++;
+    }
+  }
+}
+
 static RSValue *distinctFinalize(Reducer *parent, void *ctx) {
   distinctCounter *ctr = ctx;
   return RS_NumVal(ctr->count);
@@ -65,6 +80,7 @@ Reducer *RDCRCountDistinct_New(const ReducerOptions *options) {
   }
   r->Add = distinctAdd;
   r->Finalize = distinctFinalize;
+  r->Merge = distinctMerge;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctFreeInstance;
   r->NewInstance = distinctNewInstance;
@@ -99,6 +115,10 @@ static int distinctishAdd(Reducer *parent, void *instance, const RLookupRow *src
   return 1;
 }
 
+static void distinctishMerge(Reducer *parent, void *dst, void *src) {
+  hll_merge(&((distinctishCounter *)dst)->hll, &((distinctishCounter *)src)->hll);
+}
+
 static RSValue *distinctishFinalize(Reducer *parent, void *instance) {
   distinctishCounter *ctr = instance;
   return RS_NumVal((uint64_t)hll_count(&ctr->hll));
@@ -139,6 +159,7 @@ static Reducer *newHllCommon(const ReducerOptions *options, int isRaw) {
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctishFreeInstance;
   r->NewInstance = distinctishNewInstance;
+  r->Merge = distinctishMerge;
 
   if (isRaw) {
     r->reducerId = REDUCER_T_HLL;
@@ -214,6 +235,20 @@ static int hllsumAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void hllsumMerge(Reducer *r, void *dst, void *src) {
+  hllSumCtx *dctr = dst;
+  const hllSumCtx *sctr = src;
+  if (!sctr->hll.bits) {
+    return;
+  } else if (!dctr->hll.bits) {
+    hll_init(&dctr->hll, sctr->hll.bits);
+    memcpy(dctr->hll.registers, sctr->hll.registers, sctr->hll.size);
+  } else {
+    // Fails on different precisions, which Add() skips as well
+    hll_merge(&dctr->hll, &sctr->hll);
+  }
+}
+
 static RSValue *hllsumFinalize(Reducer *parent, void *ctx) {
   hllSumCtx *ctr = ctx;
   return RS_NumVal(ctr->hll.bits ? (uint64_t)hll_count(&ctr->hll) : 0);
@@ -241,6 +276,7 @@ Reducer *RDCRHLLSum_New(const ReducerOptions *options) {
   r->reducerId = REDUCER_T_HLLSUM;
   r->Add = hllsumAdd;
   r->Finalize = hllsumFinalize;
+  r->Merge = hllsumMerge;
   r->NewInstance = hllsumNewInstance;
   r->FreeInstance = hllsumFreeInstance;
   r->Free = Reducer_GenericFree;
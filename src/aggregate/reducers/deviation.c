@@ -53,6 +53,26 @@ static int stddevAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void stddevMerge(Reducer *r, void *dst, void *src) {
+  // Combine the means and sums of squared differences of both sets (Chan et al.)
+  devCtx *dd = dst;
+  const devCtx *sd = src;
+  if (!sd->n) {
+    return;
+  } else if (!dd->n) {
+    dd->n = sd->n;
+    dd->oldM = dd->newM = sd->newM;
+    dd->oldS = dd->newS = sd->n > 1 ? sd->newS : 0.0;
+    return;
+  }
+  double n = dd->n + sd->n;
+  double delta = sd->newM - dd->newM;
+  double dS = dd->n > 1 ? dd->newS : 0.0, sS = sd->n > 1 ? sd->newS : 0.0;
+  dd->oldM = dd->newM = dd->newM + delta * sd->n / n;
+  dd->oldS = dd->newS = dS + sS + delta * delta * dd->n * sd->n / n;
+  dd->n += sd->n;
+}
+
 static RSValue *stddevFinalize(Reducer *parent, void *instance) {
   devCtx *dctx = instance;
   double variance = ((dctx->n > 1) ? dctx->newS / (dctx->n - 1) : 0.0);
@@ -68,6 +88,7 @@ Reducer *RDCRStdDev_New(const ReducerOptions *options) {
   }
   r->Add = stddevAdd;
   r->Finalize = stddevFinalize;
+  r->Merge = stddevMerge;
   r->Free = Reducer_GenericFree;
   r->NewInstance = stddevNewInstance;
   r->reducerId = REDUCER_T_STDDEV;
@@ -49,6 +49,19 @@ static int minmaxAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void minmaxMerge(Reducer *r, void *dst, void *src) {
+  minmaxCtx *dm = dst;
+  const minmaxCtx *sm = src;
+  if (!sm->numMatches) {
+    return;
+  }
+  if (!dm->numMatches || (dm->mode == Minmax_Max && sm->val > dm->val) ||
+      (dm->mode == Minmax_Min && sm->val < dm->val)) {
+    dm->val = sm->val;
+  }
+  dm->numMatches += sm->numMatches;
+}
+
 static RSValue *minmaxFinalize(Reducer *parent, void *instance) {
   minmaxCtx *ctx = instance;
   return RS_NumVal(ctx->numMatches ? ctx->val : 0);
@@ -63,6 +76,7 @@ static Reducer *newMinMax(const ReducerOptions *options, MinmaxMode mode) {
   r->base.NewInstance = minmaxNewInstance;
   r->base.Add = minmaxAdd;
   r->base.Finalize = minmaxFinalize;
+  r->base.Merge = minmaxMerge;
   r->base.Free = Reducer_GenericFree;
   r->mode = mode;
   return &r->base;
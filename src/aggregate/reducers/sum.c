@@ -36,6 +36,13 @@ static int sumAdd(Reducer *baseparent, void *instance, const RLookupRow *row) {
   return 1;
 }
 
+static void sumMerge(Reducer *baseparent, void *dst, void *src) {
+  sumCtx *dctr = dst;
+  const sumCtx *sctr = src;
+  dctr->count += sctr->count;
+  dctr->total += sctr->total;
+}
+
 static RSValue *sumFinalize(Reducer *baseparent, void *instance) {
   sumCtx *ctr = instance;
   SumReducer *parent = (SumReducer *)baseparent;
@@ -59,6 +66,7 @@ static Reducer *newReducerCommon(const ReducerOptions *options, int isAvg) {
   r->base.NewInstance = sumNewInstance;
   r->base.Add = sumAdd;
   r->base.Finalize = sumFinalize;
+  r->base.Merge = sumMerge;
   r->base.Free = Reducer_GenericFree;
   r->isAvg = isAvg;
   return &r->base;
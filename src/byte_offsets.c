@@ -7,11 +7,34 @@ RSByteOffsets *NewByteOffsets() {
 }
 
 void RSByteOffsets_Free(RSByteOffsets *offsets) {
-  rm_free(offsets->offsets.data);
-  rm_free(offsets->fields);
+  if (!offsets->packed) {
+    rm_free(offsets->offsets.data);
+    rm_free(offsets->fields);
+  }
   rm_free(offsets);
 }
 
+RSByteOffsets *RSByteOffsets_Pack(RSByteOffsets *offsets) {
+  if (offsets->packed) {
+    return offsets;
+  }
+  size_t fieldsSize = offsets->numFields * sizeof(*offsets->fields);
+  RSByteOffsets *ret = rm_malloc(sizeof(*ret) + fieldsSize + offsets->offsets.len);
+  ret->numFields = offsets->numFields;
+  ret->packed = 1;
+  ret->fields = (RSByteOffsetField *)(ret + 1);
+  if (fieldsSize) {
+    memcpy(ret->fields, offsets->fields, fieldsSize);
+  }
+  ret->offsets.len = offsets->offsets.len;
+  ret->offsets.data = (char *)ret->fields + fieldsSize;
+  if (offsets->offsets.len) {
+    memcpy(ret->offsets.data, offsets->offsets.data, offsets->offsets.len);
+  }
+  RSByteOffsets_Free(offsets);
+  return ret;
+}
+
 void RSByteOffsets_ReserveFields(RSByteOffsets *offsets, size_t numFields) {
   offsets->fields = rm_realloc(offsets->fields, sizeof(*offsets->fields) * numFields);
 }
@@ -69,7 +92,7 @@ RSByteOffsets *LoadByteOffsets(Buffer *buf) {
     offsets->offsets.data = NULL;
   }
 
-  return offsets;
+  return RSByteOffsets_Pack(offsets);
 }
 
 int RSByteOffset_Iterate(const RSByteOffsets *offsets, uint32_t fieldId,
@@ -5,6 +5,10 @@
 #include "varint.h"
 #include "rmalloc.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct __attribute__((packed)) RSByteOffsetMap {
   // ID this belongs to.
   uint16_t fieldId;
@@ -23,12 +27,19 @@ typedef struct RSByteOffsets {
   RSByteOffsetField *fields;
   // How many fields
   uint8_t numFields;
+  // Whether the fields and offsets share the allocation of the struct (see RSByteOffsets_Pack)
+  uint8_t packed;
 } RSByteOffsets;
 
 RSByteOffsets *NewByteOffsets();
 
 void RSByteOffsets_Free(RSByteOffsets *offsets);
 
+// Move the offsets into a single allocation of their exact size, freeing the original. Offsets
+// are built in growing buffers, but are kept for as long as their document, so they are packed
+// once complete
+RSByteOffsets *RSByteOffsets_Pack(RSByteOffsets *offsets);
+
 // Reserve memory for this many fields
 void RSByteOffsets_ReserveFields(RSByteOffsets *offsets, size_t numFields);
 
@@ -86,4 +97,7 @@ int RSByteOffset_Iterate(const RSByteOffsets *offsets, uint32_t fieldId,
  */
 uint32_t RSByteOffsetIterator_Next(RSByteOffsetIterator *iter);
 
-#endif
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+#endif
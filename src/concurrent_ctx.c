@@ -8,6 +8,7 @@ static threadpool *threadpools_g = NULL;
 
 int CONCURRENT_POOL_INDEX = -1;
 int CONCURRENT_POOL_SEARCH = -1;
+int CONCURRENT_POOL_QUERY = -1;
 
 int ConcurrentSearch_CreatePool(int numThreads) {
   if (!threadpools_g) {
@@ -36,6 +37,12 @@ void ConcurrentSearch_ThreadPoolStart() {
   }
 }
 
+void ConcurrentSearch_QueryPoolStart(void) {
+  if (CONCURRENT_POOL_QUERY == -1 && RSGlobalConfig.queryWorkers > 1) {
+    CONCURRENT_POOL_QUERY = ConcurrentSearch_CreatePool(RSGlobalConfig.queryWorkers);
+  }
+}
+
 /** Stop all the concurrent threads */
 void ConcurrentSearch_ThreadPoolDestroy(void) {
   if (!threadpools_g) {
@@ -63,6 +70,10 @@ void ConcurrentSearch_ThreadPoolRun(void (*func)(void *), void *arg, int type) {
   thpool_add_work(p, func, arg);
 }
 
+void ConcurrentSearch_ThreadPoolWait(int type) {
+  thpool_wait(threadpools_g[type]);
+}
+
 static void threadHandleCommand(void *p) {
   ConcurrentCmdCtx *ctx = p;
   // Lock GIL if needed
@@ -11,6 +11,10 @@
 #define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
 #endif
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Concurrent Search Exection Context.
  *
  * We allow queries to run concurrently, each running on its own thread, locking the redis GIL
@@ -120,6 +124,14 @@ int ConcurrentSearch_CreatePool(int numThreads);
 
 extern int CONCURRENT_POOL_INDEX;
 extern int CONCURRENT_POOL_SEARCH;
+extern int CONCURRENT_POOL_QUERY;
+
+/** Start the pool used to split a single query over several threads, if enabled by QUERY_WORKERS.
+ * CONCURRENT_POOL_QUERY remains -1 otherwise */
+void ConcurrentSearch_QueryPoolStart(void);
+
+/* Wait until all the work submitted to the thread pool has completed */
+void ConcurrentSearch_ThreadPoolWait(int type);
 
 /* Run a function on the concurrent thread pool */
 void ConcurrentSearch_ThreadPoolRun(void (*func)(void *), void *arg, int type);
@@ -209,4 +221,7 @@ static inline int CheckConcurrentSupport(RedisModuleCtx *ctx) {
   return 1;
 }
 
+#ifdef __cplusplus
+}
+#endif
 #endif
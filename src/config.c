@@ -206,6 +206,39 @@ CONFIG_GETTER(getGcScanSize) {
   return sdscatprintf(ss, "%lu", config->gcScanSize);
 }
 
+// BG_INDEX_SCAN_SIZE
+CONFIG_SETTER(setBgIndexScanSize) {
+  int acrc = AC_GetSize(ac, &config->bgIndexScanSize, AC_F_GE1);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getBgIndexScanSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->bgIndexScanSize);
+}
+
+// UNION_ITERATOR_HEAP
+CONFIG_SETTER(setMinUnionIterHeap) {
+  int acrc = AC_GetSize(ac, &config->minUnionIterHeap, AC_F_GE1);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getMinUnionIterHeap) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->minUnionIterHeap);
+}
+
+// QUERY_WORKERS
+CONFIG_SETTER(setQueryWorkers) {
+  int acrc = AC_GetSize(ac, &config->queryWorkers, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getQueryWorkers) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->queryWorkers);
+}
+
 // MIN_PHONETIC_TERM_LEN
 CONFIG_SETTER(setForkGcInterval) {
   int acrc = AC_GetSize(ac, &config->forkGcRunIntervalSec, AC_F_GE1);
@@ -369,7 +402,7 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setForkGCSleep,
          .getValue = getForkGCSleep},
         {.name = "MAXDOCTABLESIZE",
-         .helpText = "Maximum runtime document table size (for this process)",
+         .helpText = "Deprecated, the document table has no size limit",
          .setValue = setMaxDocTableSize,
          .getValue = getMaxDocTableSize,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
@@ -446,6 +479,21 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setNoMemPools,
          .getValue = getNoMemPools,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "BG_INDEX_SCAN_SIZE",
+         .helpText = "Scan this many keys before releasing the GIL during background indexing",
+         .setValue = setBgIndexScanSize,
+         .getValue = getBgIndexScanSize},
+        {.name = "UNION_ITERATOR_HEAP",
+         .helpText = "Minimum number of iterators in a union from which the iterator will switch "
+                     "to heap-based iteration",
+         .setValue = setMinUnionIterHeap,
+         .getValue = getMinUnionIterHeap},
+        {.name = "QUERY_WORKERS",
+         .helpText = "Split the index scan of a single aggregation over this many threads (0 to "
+                     "disable)",
+         .setValue = setQueryWorkers,
+         .getValue = getQueryWorkers,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
         {.name = NULL}}};
 
 void RSConfigOptions_AddConfigs(RSConfigOptions *src, RSConfigOptions *dst) {
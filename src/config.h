@@ -84,6 +84,15 @@ typedef struct {
   long long maxResultsToUnsortedMode;
 
   int noMemPool;
+
+  // Number of keys the background indexer handles before releasing the GIL
+  size_t bgIndexScanSize;
+
+  // Unions with at least this many children keep them in a heap
+  size_t minUnionIterHeap;
+
+  // Number of threads scanning the index for a single aggregation. 0 or 1 disables it
+  size_t queryWorkers;
 } RSConfig;
 
 typedef enum {
@@ -150,6 +159,8 @@ sds RSConfig_GetInfoString(const RSConfig *config);
 #define DEFAULT_MIN_PHONETIC_TERM_LEN 3
 #define DEFAULT_FORK_GC_RUN_INTERVAL 30
 #define DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE 1000
+#define DEFAULT_BG_INDEX_SCAN_SIZE 100
+#define DEFAULT_MIN_UNION_ITERATOR_HEAP 20
 // default configuration
 #define RS_DEFAULT_CONFIG                                                                         \
   {                                                                                               \
@@ -162,6 +173,8 @@ sds RSConfig_GetInfoString(const RSConfig *config);
     .gcPolicy = GCPolicy_Fork, .forkGcRunIntervalSec = DEFAULT_FORK_GC_RUN_INTERVAL,              \
     .forkGcSleepBeforeExit = 0, .maxResultsToUnsortedMode = DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE, \
     .forkGcRetryInterval = 5, .forkGcCleanThreshold = 100, .noMemPool = 0,                          \
+    .bgIndexScanSize = DEFAULT_BG_INDEX_SCAN_SIZE,                                                \
+    .minUnionIterHeap = DEFAULT_MIN_UNION_ITERATOR_HEAP, .queryWorkers = 0,                       \
   }
 
 #endif
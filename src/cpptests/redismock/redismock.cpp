@@ -546,6 +546,55 @@ void RMCK_AutoMemory(RedisModuleCtx *ctx) {
   ctx->automemory = true;
 }
 
+int RMCK_GetContextFlags(RedisModuleCtx *) {
+  return 0;
+}
+
+unsigned long long RMCK_DbSize(RedisModuleCtx *ctx) {
+  return ctx->db->db.size();
+}
+
+/**
+ * The cursor simply remembers the last key returned; keys are visited in
+ * order so that keys added during the scan may or may not be returned, just
+ * like with the real SCAN
+ */
+struct RedisModuleScanCursor {
+  std::string last;
+  bool started = false;
+  bool done = false;
+};
+
+RedisModuleScanCursor *RMCK_ScanCursorCreate() {
+  return new RedisModuleScanCursor();
+}
+
+void RMCK_ScanCursorDestroy(RedisModuleScanCursor *cursor) {
+  delete cursor;
+}
+
+int RMCK_Scan(RedisModuleCtx *ctx, RedisModuleScanCursor *cursor, RedisModuleScanCB fn,
+              void *privdata) {
+  if (cursor->done) {
+    return 0;
+  }
+  auto it = cursor->started ? ctx->db->db.upper_bound(cursor->last) : ctx->db->db.begin();
+  if (it == ctx->db->db.end()) {
+    cursor->done = true;
+    return 0;
+  }
+  cursor->started = true;
+  cursor->last = it->first;
+
+  RedisModuleString keyname(it->first);
+  RedisModuleKey *key = RMCK_OpenKey(ctx, &keyname, REDISMODULE_READ);
+  fn(ctx, &keyname, key, privdata);
+  if (key) {
+    RMCK_CloseKey(key);
+  }
+  return 1;
+}
+
 void RMCK_ThreadSafeContextLock(RedisModuleCtx *) {
   RMCK_GlobalLock.lock();
 }
@@ -767,6 +816,11 @@ static void registerApis() {
   REGISTER_API(FreeThreadSafeContext);
   REGISTER_API(ThreadSafeContextLock);
   REGISTER_API(ThreadSafeContextUnlock);
+  REGISTER_API(GetContextFlags);
+  REGISTER_API(DbSize);
+  REGISTER_API(ScanCursorCreate);
+  REGISTER_API(ScanCursorDestroy);
+  REGISTER_API(Scan);
   REGISTER_API(StringCompare);
   REGISTER_API(AutoMemory);
   REGISTER_API(ExportSharedAPI);
@@ -7,7 +7,14 @@
 #include "common.h"
 #include <module.h>
 #include <version.h>
+#include <concurrent_ctx.h>
+#include <redisearch_api.h>
+#include <tag_index.h>
+#include <index.h>
+#include <aggregate/reducer.h>
 #include <vector>
+#include <map>
+#include <string>
 #include <array>
 #include <iostream>
 #include <cstdarg>
@@ -83,6 +90,103 @@ TEST_F(AggTest, testBasic) {
   RedisModule_FreeThreadSafeContext(ctx);
 }
 
+static TagIndex *openTagIndex(RedisSearchCtx *sctx, const char *field) {
+  return TagIndex_Open(sctx, IndexSpec_GetFormattedKeyByName(sctx->spec, field, INDEXFLD_T_TAG), 0,
+                       NULL);
+}
+
+static void addTagDocument(RSIndex *index, const char *docid, const char *field,
+                           const char *value, unsigned type) {
+  RSDoc *d = RediSearch_CreateDocument(docid, strlen(docid), 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(d, field, value, type);
+  RediSearch_SpecAddDocument(index, d);
+}
+
+TEST_F(AggTest, testTagCounter) {
+  RSIndex *index = RediSearch_CreateIndex("tagcount", NULL);
+  RediSearch_CreateField(index, "t", RSFLDTYPE_TAG, RSFLDOPT_NONE);
+  RediSearch_CreateField(index, "n", RSFLDTYPE_NUMERIC, RSFLDOPT_NONE);
+  // "foo" is dense enough to be counted from a bitmap
+  for (size_t ii = 0; ii < 2000; ++ii) {
+    addTagDocument(index, ("foo" + std::to_string(ii)).c_str(), "t", "foo", RSFLDTYPE_TAG);
+  }
+  addTagDocument(index, "doc3", "t", "bar", RSFLDTYPE_TAG);
+  addTagDocument(index, "doc4", "n", "1", RSFLDTYPE_NUMERIC);
+
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  IndexSpec *sp = (IndexSpec *)index;
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  ASSERT_TRUE(openTagIndex(&sctx, "t")->valuesAreTags);
+
+  QueryIterator qitr = {0};
+  qitr.sctx = &sctx;
+  RLookup lk = {0};
+  RLookupKey *tagKey = RLookup_GetKey(&lk, "t", RLOOKUP_F_OCREAT);
+  RLookupKey *countKey = RLookup_GetKey(&lk, "count", RLOOKUP_F_OCREAT);
+  IndexIterator *root = NewWildcardIterator(sp->docs.maxDocId);
+  ResultProcessor *rp = RPTagCounter_New(root, "t", sp->docs.maxDocId, tagKey,
+                                         (const RLookupKey **)&countKey, 1);
+  QITR_PushRP(&qitr, rp);
+
+  std::map<std::string, double> counts;
+  SearchResult res = {0};
+  int rv;
+  while ((rv = rp->Next(rp, &res)) == RS_RESULT_OK) {
+    RSValue *tag = RLookup_GetItem(tagKey, &res.rowdata);
+    std::string name = RSValue_IsNull(tag) ? "<null>" : RSValue_StringPtrLen(tag, NULL);
+    counts[name] = RLookup_GetItem(countKey, &res.rowdata)->numval;
+    SearchResult_Clear(&res);
+  }
+  ASSERT_EQ(RS_RESULT_EOF, rv);
+  std::map<std::string, double> expected = {{"foo", 2000}, {"bar", 1}, {"<null>", 1}};
+  ASSERT_EQ(expected, counts);
+  ASSERT_EQ(3, qitr.totalResults);
+  SearchResult_Destroy(&res);
+  rp->Free(rp);
+  root->Free(root);
+
+  // Counting reads "foo"'s bitmap and "bar"'s single posting, and stops adding up past the limit
+  size_t cost = TagIndex_CountCost(openTagIndex(&sctx, "t"), SIZE_MAX);
+  ASSERT_LT(cost, 2000);
+  ASSERT_GT(TagIndex_CountCost(openTagIndex(&sctx, "t"), 10), 10);
+
+  // A query past its timeout stops collecting, and either returns what it has or fails
+  for (auto policy : {TimeoutPolicy_Return, TimeoutPolicy_Fail}) {
+    QueryError err = {QUERY_OK};
+    QueryIterator tqitr = {0};
+    tqitr.sctx = &sctx;
+    tqitr.err = &err;
+    tqitr.timeoutMS = 1;
+    tqitr.timeoutPolicy = policy;
+    root = NewWildcardIterator(sp->docs.maxDocId);
+    rp = RPTagCounter_New(root, "t", sp->docs.maxDocId, tagKey, (const RLookupKey **)&countKey, 1);
+    QITR_PushRP(&tqitr, rp);
+    SearchResult tres = {0};
+    rv = rp->Next(rp, &tres);
+    ASSERT_EQ(QITR_S_TIMEDOUT, tqitr.state);
+    if (policy == TimeoutPolicy_Fail) {
+      ASSERT_EQ(RS_RESULT_ERROR, rv);
+      ASSERT_EQ(QUERY_ETIMEDOUT, err.code);
+      QueryError_ClearError(&err);
+    } else {
+      // the ids were not all read, so no tag was counted
+      ASSERT_EQ(RS_RESULT_EOF, rv);
+      ASSERT_EQ(0, tqitr.totalResults);
+    }
+    SearchResult_Destroy(&tres);
+    rp->Free(rp);
+    root->Free(root);
+  }
+  RLookup_Cleanup(&lk);
+
+  // Lowercasing changes the field value, so the tags no longer match the loaded values
+  addTagDocument(index, "doc5", "t", "Baz", RSFLDTYPE_TAG);
+  ASSERT_FALSE(openTagIndex(&sctx, "t")->valuesAreTags);
+
+  RediSearch_DropIndex(index);
+  RedisModule_FreeThreadSafeContext(ctx);
+}
+
 class RPMock : public ResultProcessor {
  public:
   size_t counter;
@@ -171,6 +275,109 @@ TEST_F(AggTest, testGroupBy) {
   RLookup_Cleanup(&rk_in);
 }
 
+// Group NUM_RESULTS rows by value, with `nworkers` workers, and return the reduced values of each
+// group
+static std::map<std::string, std::vector<double>> runGroupBy(size_t nworkers) {
+  static const char *reducerNames[] = {"COUNT", "SUM", "MAX", "STDDEV", "COUNT_DISTINCT"};
+  static std::vector<std::string> keys;
+  static std::vector<const char *> values;
+  if (values.empty()) {
+    for (size_t ii = 0; ii < 997; ++ii) {
+      keys.push_back("key" + std::to_string(ii));
+    }
+    for (auto &k : keys) {
+      values.push_back(k.c_str());
+    }
+  }
+
+  QueryIterator qitr = {0};
+  RPMock ctx;
+  RLookup rk_in = {0};
+  ctx.values = &values[0];
+  ctx.numvals = values.size();
+  ctx.rkscore = RLookup_GetKey(&rk_in, "score", RLOOKUP_F_OCREAT);
+  ctx.rkvalue = RLookup_GetKey(&rk_in, "value", RLOOKUP_F_OCREAT);
+  ctx.Next = [](ResultProcessor *rp, SearchResult *res) -> int {
+    RPMock *p = (RPMock *)rp;
+    if (p->counter >= NUM_RESULTS) {
+      return RS_RESULT_EOF;
+    }
+    res->docId = ++p->counter;
+    RSValue *sval = RS_ConstStringValC((char *)p->values[(p->counter * 7) % p->numvals]);
+    RLookup_WriteOwnKey(p->rkvalue, &res->rowdata, sval);
+    RLookup_WriteOwnKey(p->rkscore, &res->rowdata, RS_NumVal(p->counter % 101));
+    return RS_RESULT_OK;
+  };
+  QITR_PushRP(&qitr, &ctx);
+
+  RLookup rk_out = {0};
+  RLookupKey *v_out = RLookup_GetKey(&rk_out, "value", RLOOKUP_F_OCREAT);
+  Grouper *gr = Grouper_New((const RLookupKey **)&ctx.rkvalue, (const RLookupKey **)&v_out, 1);
+  std::vector<RLookupKey *> outkeys;
+  for (auto name : reducerNames) {
+    outkeys.push_back(RLookup_GetKey(&rk_out, name, RLOOKUP_F_OCREAT));
+  }
+
+  std::vector<Reducer *> reducers(outkeys.size());
+  auto newReducers = [&]() {
+    for (size_t ii = 0; ii < outkeys.size(); ++ii) {
+      if (!strcmp(reducerNames[ii], "COUNT")) {
+        reducers[ii] = RDCRCount_New(NULL);
+      } else {
+        ReducerOptionsCXX options(reducerNames[ii], &rk_in, "score");
+        reducers[ii] = RDCR_GetFactory(reducerNames[ii])(&options);
+      }
+    }
+  };
+  newReducers();
+  for (size_t ii = 0; ii < outkeys.size(); ++ii) {
+    Grouper_AddReducer(gr, reducers[ii], outkeys[ii]);
+  }
+  for (size_t ii = 0; ii < nworkers; ++ii) {
+    newReducers();
+    Grouper_AddWorker(gr, &reducers[0]);
+  }
+
+  SearchResult res = {0};
+  ResultProcessor *gp = Grouper_GetRP(gr);
+  QITR_PushRP(&qitr, gp);
+
+  std::map<std::string, std::vector<double>> groups;
+  while (gp->Next(gp, &res) == RS_RESULT_OK) {
+    RSValue *v = RLookup_GetItem(v_out, &res.rowdata);
+    std::vector<double> &reduced = groups[RSValue_StringPtrLen(v, NULL)];
+    for (auto kk : outkeys) {
+      reduced.push_back(RLookup_GetItem(kk, &res.rowdata)->numval);
+    }
+    SearchResult_Clear(&res);
+  }
+  SearchResult_Destroy(&res);
+  gp->Free(gp);
+  RLookup_Cleanup(&rk_out);
+  RLookup_Cleanup(&rk_in);
+  return groups;
+}
+
+TEST_F(AggTest, testGroupByWorkers) {
+  int prevPool = CONCURRENT_POOL_QUERY;
+  static int pool = ConcurrentSearch_CreatePool(4);
+  CONCURRENT_POOL_QUERY = pool;
+
+  auto serial = runGroupBy(0);
+  auto parallel = runGroupBy(4);
+  CONCURRENT_POOL_QUERY = prevPool;
+
+  ASSERT_EQ(997, serial.size());
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (auto &it : serial) {
+    auto &other = parallel[it.first];
+    ASSERT_EQ(it.second.size(), other.size()) << it.first;
+    for (size_t ii = 0; ii < it.second.size(); ++ii) {
+      ASSERT_NEAR(it.second[ii], other[ii], 1e-6 * (1 + fabs(it.second[ii]))) << it.first;
+    }
+  }
+}
+
 class ArrayGenerator : public ResultProcessor {
  public:
   RLookupKey *kvalue = NULL;
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <aggregate/expr/expression.h>
 #include <aggregate/expr/exprast.h>
+#include <aggregate/expr/exprprog.h>
 #include <aggregate/functions/function.h>
 #include <util/arr.h>
 
@@ -25,6 +26,7 @@ struct TEvalCtx : ExprEval {
     err = &status_s;
     lookup = NULL;
     root = root_;
+    prog = NULL;
   }
 
   void assign(const char *s) {
@@ -261,4 +263,89 @@ TEST_F(ExprTest, testPropertyFetch) {
   // RSValue_Print(&ctx.result());
   RLookupRow_Cleanup(&rr);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+
+TEST_F(ExprTest, testProgram) {
+  RLookup lk;
+  RLookup_Init(&lk, NULL);
+  RLookupRow rr = {0};
+  RLookup_WriteOwnKey(RLookup_GetKey(&lk, "foo", RLOOKUP_F_OCREAT), &rr, RS_NumVal(1));
+  RLookup_WriteOwnKey(RLookup_GetKey(&lk, "bar", RLOOKUP_F_OCREAT), &rr, RS_NumVal(2));
+  RLookup_WriteOwnKey(RLookup_GetKey(&lk, "name", RLOOKUP_F_OCREAT), &rr,
+                      RS_NewCopiedString("hello", 5));
+  RLookup_GetKey(&lk, "missing", RLOOKUP_F_OCREAT);
+
+  // The compiled program must give the same results and errors as the tree evaluator
+  const char *exprs[] = {"1 + 2 * 3",
+                         "@foo + @bar * 3",
+                         "(@foo + 1) / (@bar - 2)",
+                         "(@foo + 7) % @bar",
+                         "2 ^ @bar - 1",
+                         "@name + 1",
+                         "'abc' + 1",
+                         "@foo < @bar && @bar < 3",
+                         "@foo > @bar || @name == 'hello'",
+                         "@foo > @bar && @missing",
+                         "!(@foo == 1) || !@bar",
+                         "1 == 1 && 2 < 3",
+                         "@foo == NULL",
+                         "@name < 'world'",
+                         "NULL",
+                         "'literal'",
+                         "@missing",
+                         "@missing + 1",
+                         "exists(@missing)",
+                         "exists(@foo) && !exists(@missing)",
+                         "upper(@name)",
+                         "substr(upper(@name), 1, @bar)",
+                         "format('%s-%s', @name, @foo + @bar)",
+                         "sqrt(@bar * 8) + log(1)",
+                         "upper(@missing)",
+                         "abs(0 - @foo) + floor(@bar / 3)",
+                         "startswith(lower('ABC'), 'ab') == 1",
+                         "to_number(@name)"};
+
+  for (const char *e : exprs) {
+    TEvalCtx tree(e), compiled(e);
+    ASSERT_TRUE(tree) << e << ": " << tree.error();
+    tree.err = &tree.status_s;
+    compiled.err = &compiled.status_s;
+    tree.lookup = compiled.lookup = &lk;
+    tree.srcrow = compiled.srcrow = &rr;
+    ASSERT_EQ(EXPR_EVAL_OK, tree.bindLookupKeys());
+    ASSERT_EQ(EXPR_EVAL_OK, compiled.bindLookupKeys());
+    compiled.prog = ExprProgram_Compile(compiled.root);
+
+    int treeRc = tree.eval();
+    int compiledRc = compiled.eval();
+    ASSERT_EQ(treeRc, compiledRc) << e;
+    ASSERT_EQ(tree.status_s.code, compiled.status_s.code) << e;
+    if (treeRc == EXPR_EVAL_OK) {
+      ASSERT_EQ(RSValue_Dereference(&tree.result())->t,
+                RSValue_Dereference(&compiled.result())->t)
+          << e;
+      ASSERT_TRUE(RSValue_Equal(&tree.result(), &compiled.result(), NULL)) << e;
+    }
+
+    // Evaluating again must reuse the registers cleanly
+    RSValue_Clear(&compiled.result());
+    QueryError_ClearError(&compiled.status_s);
+    ASSERT_EQ(treeRc, compiled.eval()) << e;
+
+    ExprProgram_Free(compiled.prog);
+    compiled.prog = NULL;
+  }
+
+  // Constant expressions are folded away
+  TEvalCtx ctx("(1 + 2) * 3 > 8 && !('a' == 'b')");
+  ASSERT_TRUE(ctx) << ctx.error();
+  ctx.prog = ExprProgram_Compile(ctx.root);
+  ASSERT_EQ(0, ExprProgram_Len(ctx.prog));
+  ASSERT_EQ(EXPR_EVAL_OK, ctx.eval());
+  ASSERT_EQ(1, ctx.result().numval);
+  ExprProgram_Free(ctx.prog);
+  ctx.prog = NULL;
+
+  RLookupRow_Cleanup(&rr);
+  RLookup_Cleanup(&lk);
+}
@@ -293,3 +293,58 @@ TEST_F(FGCTest, testRemoveMiddleBlock) {
   ASSERT_NE(ss.end(), ss.find(numToDocid(lastLastBlockId)));
   ASSERT_EQ(0, fgc->stats.gcBlocksDenied);
 }
+
+TEST_F(FGCTest, testResumeReader) {
+  unsigned curId = 0;
+  InvertedIndex *iv = getTagInvidx(ctx, sp, "f1", "hello");
+  while (iv->size < 4) {
+    RS::addDocument(ctx, sp, numToDocid(++curId).c_str(), "f1", "hello");
+  }
+  t_docId firstMidId = iv->blocks[1].firstId, lastMidId = iv->blocks[1].lastId;
+
+  // ir stops inside the third block, ir2 inside the first one
+  IndexReader *ir = NewTermIndexReader(iv, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  IndexReader *ir2 = NewTermIndexReader(iv, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *r;
+  t_docId stop = iv->blocks[2].firstId + 5, stop2 = iv->blocks[0].firstId + 5;
+  do {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &r));
+  } while (r->docId < stop);
+  do {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir2, &r));
+  } while (r->docId < stop2);
+  uint32_t uid = ir->blockUid, uid2 = ir2->blockUid;
+
+  // remove the second block entirely, and rewrite the first one
+  FGC_WaitAtFork(fgc);
+  for (t_docId ii = firstMidId; ii <= lastMidId; ++ii) {
+    RS::deleteDocument(ctx, sp, numToDocid(ii).c_str());
+  }
+  RS::deleteDocument(ctx, sp, numToDocid(stop2 + 1).c_str());
+  FGC_WaitAtApply(fgc);
+  FGC_WaitClear(fgc);
+  ASSERT_EQ(3, iv->size);
+
+  // the third block moved but was not changed - the reader continues where it was
+  IndexReader_Resume(ir);
+  ASSERT_EQ(1, ir->currentBlock);
+  ASSERT_EQ(uid, ir->blockUid);
+  for (t_docId id = stop + 1; id <= curId; ++id) {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &r));
+    ASSERT_EQ(id, r->docId);
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &r));
+
+  // the first block was rewritten, so the reader seeks back to its last id
+  IndexReader_Resume(ir2);
+  ASSERT_NE(uid2, ir2->blockUid);
+  for (t_docId id = stop2 + 2; id <= curId; ++id) {
+    if (id == firstMidId) id = lastMidId + 1;
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir2, &r));
+    ASSERT_EQ(id, r->docId);
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir2, &r));
+
+  IR_Free(ir);
+  IR_Free(ir2);
+}
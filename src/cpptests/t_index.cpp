@@ -1,12 +1,15 @@
 #include "../buffer.h"
+#include "../byte_offsets.h"
 #include "../index.h"
 #include "../inverted_index.h"
 #include "../index_result.h"
 #include "../query_parser/tokenizer.h"
 #include "../rmutil/alloc.h"
 #include "../spec.h"
+#include "../config.h"
 #include "../tokenize.h"
 #include "../varint.h"
+#include "../util/arr.h"
 #include "../rmutil/alloc.h"
 #include <assert.h>
 #include <math.h>
@@ -15,6 +18,7 @@
 #include <float.h>
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
 #include <cstdint>
 
 class IndexTest : public ::testing::Test {};
@@ -207,6 +211,102 @@ TEST_P(IndexFlagsTest, testRWFlags) {
 
 INSTANTIATE_TEST_CASE_P(IndexFlagsP, IndexFlagsTest, ::testing::Range(1, 32));
 
+TEST_F(IndexTest, testLargeBlocks) {
+  IndexFlags flags = (IndexFlags)(INDEX_DEFAULT_FLAGS | Index_LargeBlocks);
+  InvertedIndex *idx = NewInvertedIndex(flags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(flags);
+  for (t_docId id = 2; id <= 6000; id += 2) {
+    ForwardIndexEntry h = {0};
+    h.docId = id;
+    h.fieldMask = 1;
+    h.freq = 1;
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+  }
+  // 3000 records in blocks of 1024
+  ASSERT_EQ(3, idx->size);
+  ASSERT_TRUE(idx->blocks[0].skips != NULL);
+  ASSERT_EQ(1024 / 64 - 1, array_len(idx->blocks[0].skips));
+
+  // the rebuilt skip table must be identical to the one written incrementally
+  IndexBlockSkip *written = array_new(IndexBlockSkip, 16);
+  for (size_t ii = 0; ii < array_len(idx->blocks[1].skips); ++ii) {
+    written = array_append(written, idx->blocks[1].skips[ii]);
+  }
+  IndexBlock_UpdateSkips(&idx->blocks[1], idx->flags);
+  ASSERT_EQ(array_len(written), array_len(idx->blocks[1].skips));
+  for (size_t ii = 0; ii < array_len(written); ++ii) {
+    ASSERT_EQ(written[ii].lastId, idx->blocks[1].skips[ii].lastId);
+    ASSERT_EQ(written[ii].offset, idx->blocks[1].skips[ii].offset);
+  }
+  array_free(written);
+
+  IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *h = NULL;
+  for (t_docId id = 1; id < 6000; id += 97) {
+    int rc = IR_SkipTo(ir, id, &h);
+    ASSERT_EQ(id % 2 ? INDEXREAD_NOTFOUND : INDEXREAD_OK, rc);
+    ASSERT_EQ(id + id % 2, h->docId);
+  }
+  IR_Free(ir);
+
+  ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  for (t_docId id = 2; id <= 6000; id += 2) {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+    ASSERT_EQ(id, h->docId);
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testSkipToFlags) {
+  // make sure the seekers agree with the plain decoders for every encoding that has one
+  IndexFlags flagsList[] = {
+      Index_DocIdsOnly,
+      (IndexFlags)(Index_StoreFreqs | Index_StoreFieldFlags),
+      (IndexFlags)(Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets),
+      Index_StoreFreqs,
+  };
+  for (auto indexFlags : flagsList) {
+    InvertedIndex *idx = NewInvertedIndex(indexFlags, 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(indexFlags);
+
+    // 1000 docs with ids 3, 6, 9... spanning several blocks
+    for (t_docId id = 3; id <= 3000; id += 3) {
+      ForwardIndexEntry h = {0};
+      h.docId = id;
+      h.fieldMask = 1;
+      h.freq = 1;
+      InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+    }
+    ASSERT_EQ(1000, idx->numDocs);
+
+    IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h = NULL;
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 3, &h));
+    ASSERT_EQ(3, h->docId);
+    ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, 4, &h));
+    ASSERT_EQ(6, h->docId);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 150, &h));
+    ASSERT_EQ(150, h->docId);
+    // inside the next block
+    ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, 301, &h));
+    ASSERT_EQ(303, h->docId);
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+    ASSERT_EQ(306, h->docId);
+    // a few blocks ahead
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 2400, &h));
+    ASSERT_EQ(2400, h->docId);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 3000, &h));
+    ASSERT_EQ(3000, h->docId);
+    ASSERT_EQ(INDEXREAD_EOF, IR_SkipTo(ir, 3001, &h));
+
+    IR_Free(ir);
+    InvertedIndex_Free(idx);
+  }
+}
+
 InvertedIndex *createIndex(int size, int idStep) {
   InvertedIndex *idx = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
 
@@ -311,6 +411,67 @@ TEST_F(IndexTest, testUnion) {
   InvertedIndex_Free(w2);
 }
 
+static IndexIterator *createUnion(InvertedIndex **idxs, int num, int quickExit, size_t heapMin) {
+  size_t oldHeapMin = RSGlobalConfig.minUnionIterHeap;
+  RSGlobalConfig.minUnionIterHeap = heapMin;
+  IndexIterator **irs = (IndexIterator **)calloc(num, sizeof(IndexIterator *));
+  for (int i = 0; i < num; i++) {
+    irs[i] = NewReadIterator(NewTermIndexReader(idxs[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+  }
+  IndexIterator *ui = NewUnionIterator(irs, num, NULL, quickExit, 1);
+  RSGlobalConfig.minUnionIterHeap = oldHeapMin;
+  return ui;
+}
+
+TEST_F(IndexTest, testUnionHeap) {
+  // the heap based union must behave exactly like the linear one
+  const int num = 25;
+  InvertedIndex *idxs[num];
+  for (int i = 0; i < num; i++) {
+    idxs[i] = createIndex(40, i + 2);
+  }
+
+  for (int quickExit = 0; quickExit < 2; quickExit++) {
+    IndexIterator *linear = createUnion(idxs, num, quickExit, 1000);
+    IndexIterator *heap = createUnion(idxs, num, quickExit, 2);
+    RSIndexResult *h1 = NULL, *h2 = NULL;
+    int n = 0;
+    while (linear->Read(linear->ctx, &h1) != INDEXREAD_EOF) {
+      ASSERT_EQ(INDEXREAD_OK, heap->Read(heap->ctx, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+      ASSERT_EQ(h1->agg.numChildren, h2->agg.numChildren);
+      for (int i = 0; i < h1->agg.numChildren; i++) {
+        ASSERT_EQ(h1->agg.children[i]->freq, h2->agg.children[i]->freq);
+      }
+      n++;
+    }
+    ASSERT_EQ(INDEXREAD_EOF, heap->Read(heap->ctx, &h2));
+    ASSERT_GT(n, 100);
+
+    linear->Rewind(linear->ctx);
+    heap->Rewind(heap->ctx);
+    t_docId skips[] = {7, 8, 37, 38, 121, 500, 501, 877, 1000, 1039, 1041};
+    for (auto docId : skips) {
+      int rc1 = linear->SkipTo(linear->ctx, docId, &h1);
+      int rc2 = heap->SkipTo(heap->ctx, docId, &h2);
+      ASSERT_EQ(rc1, rc2);
+      if (rc1 == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+      rc1 = linear->Read(linear->ctx, &h1);
+      rc2 = heap->Read(heap->ctx, &h2);
+      ASSERT_EQ(rc1, rc2);
+      if (rc1 == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+    }
+    linear->Free(linear);
+    heap->Free(heap);
+  }
+
+  for (int i = 0; i < num; i++) {
+    InvertedIndex_Free(idxs[i]);
+  }
+}
+
 TEST_F(IndexTest, testWeight) {
   InvertedIndex *w = createIndex(10, 1);
   InvertedIndex *w2 = createIndex(10, 2);
@@ -348,6 +509,96 @@ TEST_F(IndexTest, testWeight) {
   InvertedIndex_Free(w2);
 }
 
+static double pruneTestBound(const RSIndexResult *term, uint32_t maxFreq,
+                             const RSIndexStats *stats) {
+  return term->weight * term->term.term->idf * maxFreq;
+}
+
+static double pruneTestScore(const RSIndexResult *h) {
+  double score = 0;
+  for (int i = 0; i < h->agg.numChildren; i++) {
+    const RSIndexResult *c = h->agg.children[i];
+    score += c->weight * c->term.term->idf * c->freq;
+  }
+  return score;
+}
+
+// Collect the top 10 (score, docId) pairs the way the sorter does, raising minScore once full
+static std::vector<std::pair<double, t_docId>> pruneTestTopK(IndexIterator *ui, double *minScore,
+                                                             size_t *nread) {
+  std::vector<std::pair<double, t_docId>> top;
+  RSIndexResult *h = NULL;
+  *nread = 0;
+  while (ui->Read(ui->ctx, &h) != INDEXREAD_EOF) {
+    ++*nread;
+    std::pair<double, t_docId> cur(pruneTestScore(h), h->docId);
+    if (top.size() == 10 && cur < top.front()) continue;
+    top.insert(std::upper_bound(top.begin(), top.end(), cur), cur);
+    if (top.size() > 10) top.erase(top.begin());
+    if (top.size() == 10) *minScore = top.front().first;
+  }
+  return top;
+}
+
+TEST_F(IndexTest, testUnionScorePruning) {
+  const int num = 4;
+  InvertedIndex *idxs[num];
+  for (int i = 0; i < num; i++) {
+    idxs[i] = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idxs[i]->flags);
+    for (t_docId id = i + 1; id < 5000; id += i + 1) {
+      ForwardIndexEntry h = {0};
+      h.docId = id;
+      h.fieldMask = 1;
+      // a few blocks hold high frequencies, the rest are low
+      h.freq = (id / 500) % 3 == i % 3 ? 1 + id % 7 : 1;
+      h.term = "hello";
+      h.len = 5;
+      h.vw = NewVarintVectorWriter(8);
+      VVW_Write(h.vw, 1);
+      InvertedIndex_WriteForwardIndexEntry(idxs[i], enc, &h);
+      VVW_Free(h.vw);
+    }
+  }
+
+  IndexIterator *uis[2];
+  for (int n = 0; n < 2; n++) {
+    IndexIterator **irs = (IndexIterator **)calloc(num, sizeof(IndexIterator *));
+    for (int i = 0; i < num; i++) {
+      RSToken tok = {.str = (char *)"hello", .len = 5};
+      RSQueryTerm *term = NewQueryTerm(&tok, i);
+      term->idf = 1 + i;
+      irs[i] = NewReadIterator(NewTermIndexReader(idxs[i], NULL, RS_FIELDMASK_ALL, term, 1));
+    }
+    uis[n] = NewUnionIterator(irs, num, NULL, 0, 1);
+  }
+
+  double minScore = 0, pruneMinScore = 0;
+  RSIndexStats stats = {0};
+  ASSERT_TRUE(UI_EnableScorePruning(uis[1], &pruneMinScore, pruneTestBound, &stats, 1));
+  // pruning can only be enabled once
+  ASSERT_FALSE(UI_EnableScorePruning(uis[1], &pruneMinScore, pruneTestBound, &stats, 1));
+
+  size_t nfull, npruned;
+  auto full = pruneTestTopK(uis[0], &minScore, &nfull);
+  auto pruned = pruneTestTopK(uis[1], &pruneMinScore, &npruned);
+  ASSERT_EQ(full, pruned);
+  ASSERT_LT(npruned, nfull);
+
+  // rewinding starts over without a threshold
+  uis[1]->Rewind(uis[1]->ctx);
+  pruneMinScore = 0;
+  pruned = pruneTestTopK(uis[1], &pruneMinScore, &npruned);
+  ASSERT_EQ(full, pruned);
+
+  for (int n = 0; n < 2; n++) {
+    uis[n]->Free(uis[n]);
+  }
+  for (int i = 0; i < num; i++) {
+    InvertedIndex_Free(idxs[i]);
+  }
+}
+
 TEST_F(IndexTest, testNot) {
   InvertedIndex *w = createIndex(16, 1);
   // not all numbers that divide by 3
@@ -626,6 +877,40 @@ TEST_F(IndexTest, testIntersection) {
   InvertedIndex_Free(w2);
 }
 
+TEST_F(IndexTest, testIntersectionRanked) {
+  // children are given from the most to the least frequent
+  InvertedIndex *w1 = createIndex(30000, 1);
+  InvertedIndex *w2 = createIndex(10000, 3);
+  InvertedIndex *w3 = createIndex(200, 150);
+  InvertedIndex *ws[] = {w1, w2, w3};
+
+  IndexIterator **irs = (IndexIterator **)calloc(3, sizeof(IndexIterator *));
+  RSIndexResult *records[3];
+  for (int i = 0; i < 3; i++) {
+    irs[i] = NewReadIterator(NewTermIndexReader(ws[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+    records[i] = irs[i]->current;
+  }
+  IndexIterator *ii = NewIntersecIterator(irs, 3, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+
+  RSIndexResult *h = NULL;
+  int count = 0;
+  while (ii->Read(ii->ctx, &h) != INDEXREAD_EOF) {
+    ++count;
+    ASSERT_EQ(count * 150, h->docId);
+    // the aggregate keeps the children in the query order
+    ASSERT_EQ(3, h->agg.numChildren);
+    for (int i = 0; i < 3; i++) {
+      ASSERT_EQ(records[i], h->agg.children[i]);
+    }
+  }
+  ASSERT_EQ(200, count);
+
+  ii->Free(ii);
+  for (int i = 0; i < 3; i++) {
+    InvertedIndex_Free(ws[i]);
+  }
+}
+
 TEST_F(IndexTest, testBuffer) {
   // TEST_START();
   Buffer b = {0};
@@ -947,11 +1232,10 @@ TEST_F(IndexTest, testIndexFlags) {
 
 TEST_F(IndexTest, testDocTable) {
   char buf[16];
-  DocTable dt = NewDocTable(10, 10);
+  DocTable dt = NewDocTable(10);
   t_docId did = 0;
-  // N is set to 100 and the max cap of the doc table is 10 so we surely will
-  // get overflow and check that everything works correctly
-  int N = 100;
+  // N spans several pages, so the page directory has to grow
+  int N = 3 * DOCTABLE_PAGE_SIZE;
   for (int i = 0; i < N; i++) {
     size_t nkey = sprintf(buf, "doc_%d", i);
     t_docId nd = DocTable_Put(&dt, buf, nkey, (double)i, Document_DefaultFlags, buf, strlen(buf));
@@ -962,7 +1246,7 @@ TEST_F(IndexTest, testDocTable) {
   ASSERT_EQ(N + 1, dt.size);
   ASSERT_EQ(N, dt.maxDocId);
 #ifdef __x86_64__
-  ASSERT_EQ(10980, (int)dt.memsize);
+  ASSERT_EQ(331636, (int)dt.memsize);
 #endif
   for (int i = 0; i < N; i++) {
     sprintf(buf, "doc_%d", i);
@@ -994,6 +1278,10 @@ TEST_F(IndexTest, testDocTable) {
     dmd = DocTable_Get(&dt, i + 1);
     ASSERT_TRUE(!dmd);
   }
+  // The pages of deleted documents are freed
+  for (size_t i = 0; i < dt.npages; ++i) {
+    ASSERT_TRUE(dt.pages[i] == NULL);
+  }
 
   ASSERT_FALSE(DocIdMap_Get(&dt.dim, "foo bar", strlen("foo bar")));
   ASSERT_FALSE(DocTable_Get(&dt, N + 2));
@@ -1013,6 +1301,140 @@ TEST_F(IndexTest, testDocTable) {
   DocTable_Free(&dt);
 }
 
+TEST_F(IndexTest, testDocTablePacking) {
+  char buf[16];
+  DocTable dt = NewDocTable(10);
+  int N = 3 * DOCTABLE_PAGE_SIZE + 100;
+  for (int i = 0; i < N; i++) {
+    size_t nkey = sprintf(buf, "doc_%d", i);
+    DocTable_Put(&dt, buf, nkey, 1, Document_DefaultFlags, NULL, 0);
+  }
+  size_t memsize = dt.memsize;
+
+  // Keep every 100th document, which leaves the full pages sparse
+  for (int i = 0; i < N; i++) {
+    if (i % 100) {
+      size_t nkey = sprintf(buf, "doc_%d", i);
+      ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+    }
+  }
+  // The last page still gets new documents, so it is not packed
+  size_t lastPage = dt.maxDocId >> DOCTABLE_PAGE_BITS;
+  for (size_t i = 0; i < lastPage; ++i) {
+    ASSERT_TRUE(dt.pages[i]->packed);
+    ASSERT_LE(dt.pages[i]->used, DOCTABLE_PAGE_PACK_THRESHOLD);
+  }
+  ASSERT_FALSE(dt.pages[lastPage]->packed);
+  ASSERT_LT(dt.memsize, memsize - lastPage * DOCTABLE_PAGE_SIZE * sizeof(void *) / 2);
+
+  for (int i = 0; i < N; i++) {
+    RSDocumentMetadata *dmd = DocTable_Get(&dt, i + 1);
+    if (i % 100) {
+      ASSERT_TRUE(dmd == NULL);
+    } else {
+      ASSERT_TRUE(dmd != NULL);
+      sprintf(buf, "doc_%d", i);
+      ASSERT_STREQ(buf, dmd->keyPtr);
+    }
+  }
+
+  size_t n = 0;
+  t_docId lastId = 0;
+  DOCTABLE_FOREACH((&dt), {
+    ASSERT_GT(dmd->id, lastId);
+    lastId = dmd->id;
+    ++n;
+  });
+  ASSERT_EQ(dt.size - 1, n);
+
+  // Deleting from a packed page keeps the rest of it
+  ASSERT_EQ(1, DocTable_Delete(&dt, "doc_100", 7));
+  ASSERT_TRUE(DocTable_Get(&dt, 101) == NULL);
+  ASSERT_TRUE(DocTable_Get(&dt, 1) != NULL);
+  ASSERT_TRUE(DocTable_Get(&dt, 201) != NULL);
+  DocTable_Free(&dt);
+}
+
+TEST_F(IndexTest, testByteOffsetsPack) {
+  RSByteOffsets *offsets = NewByteOffsets();
+  RSByteOffsets_ReserveFields(offsets, 2);
+  ByteOffsetWriter w;
+  ByteOffsetWriter_Init(&w);
+  // Field 1 has tokens 1-10 and field 3 has tokens 11-100
+  RSByteOffsets_AddField(offsets, 1, 1)->lastTokPos = 10;
+  RSByteOffsets_AddField(offsets, 3, 11)->lastTokPos = 100;
+  for (uint32_t i = 1; i <= 100; i++) {
+    ByteOffsetWriter_Write(&w, i * 7);
+  }
+  ByteOffsetWriter_Move(&w, offsets);
+  ByteOffsetWriter_Cleanup(&w);
+
+  offsets = RSByteOffsets_Pack(offsets);
+  ASSERT_TRUE(offsets->packed);
+  ASSERT_EQ(2, offsets->numFields);
+
+  RSByteOffsetIterator iter;
+  ASSERT_EQ(REDISMODULE_OK, RSByteOffset_Iterate(offsets, 3, &iter));
+  for (uint32_t i = 11; i <= 100; i++) {
+    ASSERT_EQ(i * 7, RSByteOffsetIterator_Next(&iter));
+  }
+  ASSERT_EQ(RSBYTEOFFSET_EOF, RSByteOffsetIterator_Next(&iter));
+  ASSERT_EQ(REDISMODULE_ERR, RSByteOffset_Iterate(offsets, 2, &iter));
+
+  // Loaded offsets are packed too
+  Buffer b;
+  Buffer_Init(&b, 16);
+  RSByteOffsets_Serialize(offsets, &b);
+  RSByteOffsets *loaded = LoadByteOffsets(&b);
+  ASSERT_TRUE(loaded->packed);
+  ASSERT_EQ(offsets->offsets.len, loaded->offsets.len);
+  ASSERT_EQ(0, memcmp(offsets->offsets.data, loaded->offsets.data, loaded->offsets.len));
+  ASSERT_EQ(0, memcmp(offsets->fields, loaded->fields, 2 * sizeof(*loaded->fields)));
+  Buffer_Free(&b);
+  RSByteOffsets_Free(loaded);
+  RSByteOffsets_Free(offsets);
+}
+
+TEST_F(IndexTest, testDocIdMap) {
+  char buf[32];
+  DocTable dt = NewDocTable(10);
+  const int N = 20000;
+  std::vector<t_docId> ids(N);
+  for (int i = 0; i < N; i++) {
+    size_t n = sprintf(buf, "user:%d", i);
+    ids[i] = DocTable_Put(&dt, buf, n, 1.0, 0, NULL, 0);
+    ASSERT_TRUE(ids[i] != 0);
+  }
+  ASSERT_EQ(N, dt.dim.size);
+
+  // Delete every third key, so later keys are shifted back into the holes
+  for (int i = 0; i < N; i += 3) {
+    size_t n = sprintf(buf, "user:%d", i);
+    ASSERT_EQ(1, DocTable_Delete(&dt, buf, n));
+    ASSERT_EQ(0, DocTable_Delete(&dt, buf, n));
+  }
+  for (int i = 0; i < N; i++) {
+    size_t n = sprintf(buf, "user:%d", i);
+    ASSERT_EQ(i % 3 ? ids[i] : 0, DocTable_GetId(&dt, buf, n)) << buf;
+  }
+
+  // Keys can be added back
+  for (int i = 0; i < N; i += 3) {
+    size_t n = sprintf(buf, "user:%d", i);
+    ids[i] = DocTable_Put(&dt, buf, n, 1.0, 0, NULL, 0);
+    ASSERT_TRUE(ids[i] > N);
+  }
+  for (int i = 0; i < N; i++) {
+    size_t n = sprintf(buf, "user:%d", i);
+    ASSERT_EQ(ids[i], DocTable_GetId(&dt, buf, n)) << buf;
+    ASSERT_EQ(ids[i], DocTable_Get(&dt, ids[i])->id);
+  }
+  ASSERT_EQ(N, dt.dim.size);
+  ASSERT_EQ(0, DocTable_GetId(&dt, "user:", 5));
+  ASSERT_GE(DocIdMap_MemUsage(&dt.dim), N * (sizeof(uint32_t) + sizeof(void *)));
+  DocTable_Free(&dt);
+}
+
 TEST_F(IndexTest, testSortable) {
   RSSortingTable *tbl = NewSortingTable();
   RSSortingTable_Add(tbl, "foo", RSValue_String);
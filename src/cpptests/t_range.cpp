@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "numeric_index.h"
+#include "numeric_runs.h"
+#include "geo_polygon.h"
 #include <stdio.h>
 // #include "time_sample.h"
 #include "index.h"
@@ -171,3 +173,221 @@ TEST_F(RangeTest, testRangeIterator) {
 //   NumericFilter_Free(flt);
 //   return 0;
 // }
+
+TEST_F(RangeTest, testRangeCount) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  DocTable dt = NewDocTable(100);
+
+  const size_t N = 20000;
+  std::vector<double> lookup(N + 1);
+  for (size_t i = 0; i < N; i++) {
+    char key[32];
+    sprintf(key, "doc%zu", i + 1);
+    t_docId docId = DocTable_Put(&dt, key, strlen(key), 1, 0, NULL, 0);
+    ASSERT_EQ(i + 1, docId);
+    lookup[docId] = (double)(1 + prng() % (N / 5));
+    NumericRangeTree_Add(t, docId, lookup[docId]);
+  }
+
+  for (size_t round = 0; round < 2; round++) {
+    if (round) {
+      // delete every third document, so that ranges can no longer be counted from their size
+      for (size_t i = 3; i <= N; i += 3) {
+        char key[32];
+        sprintf(key, "doc%zu", i);
+        ASSERT_TRUE(DocTable_Delete(&dt, key, strlen(key)));
+      }
+    }
+    for (size_t i = 0; i < 5; i++) {
+      double min = (double)(1 + prng() % (N / 5));
+      double max = (double)(1 + prng() % (N / 5));
+      NumericFilter *flt = NewNumericFilter(std::min(min, max), std::max(min, max), 1, i % 2);
+
+      size_t count = 0;
+      for (size_t id = 1; id <= N; id++) {
+        if ((!round || id % 3) && NumericFilter_Match(flt, lookup[id])) {
+          count++;
+        }
+      }
+      ASSERT_EQ(count, NumericRangeTree_Count(t, flt, &dt));
+      NumericFilter_Free(flt);
+    }
+  }
+
+  DocTable_Free(&dt);
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testMonotonicBalance) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 200000;
+  for (size_t i = 1; i <= N; i++) {
+    NumericRangeTree_Add(t, i, (double)i);
+  }
+
+  NumericRangeTreeStats stats;
+  NumericRangeTree_GetStats(t, &stats);
+  ASSERT_EQ(t->numRanges, stats.numLeaves);
+  ASSERT_LE(stats.height, 1.5 * (1 + ceil(log2(stats.numLeaves))));
+  size_t nleaves = 0;
+  for (size_t ii = 0; ii < array_len(stats.leafDepths); ii++) {
+    nleaves += stats.leafDepths[ii];
+  }
+  ASSERT_EQ(stats.numLeaves, nleaves);
+  NumericRangeTreeStats_Free(&stats);
+
+  // every record is still reachable after the tree was rebuilt
+  NumericFilter *flt = NewNumericFilter(1000, 150000, 1, 0);
+  IndexIterator *it = createNumericIterator(NULL, t, flt);
+  RSIndexResult *res = NULL;
+  t_docId expected = 1000;
+  while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+    ASSERT_EQ(expected++, res->docId);
+  }
+  ASSERT_EQ(150000, expected);
+  it->Free(it);
+  NumericFilter_Free(flt);
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testSortedRuns) {
+  NumericRuns *r = NewNumericRuns();
+  DocTable dt = NewDocTable(100);
+
+  // timestamps arriving mostly in order, a few of them late
+  const size_t N = 20000;
+  std::vector<double> lookup(N + 1);
+  for (size_t i = 0; i < N; i++) {
+    char key[32];
+    sprintf(key, "doc%zu", i + 1);
+    t_docId docId = DocTable_Put(&dt, key, strlen(key), 1, 0, NULL, 0);
+    lookup[docId] = (double)(1000 + docId * 10 - (prng() % 8 ? 0 : prng() % 500));
+    ASSERT_EQ(1, NumericRuns_Add(r, docId, lookup[docId], &dt));
+  }
+  ASSERT_EQ(N, r->numEntries);
+  ASSERT_LE(array_len(r->runs), 1 + ceil(log2(N)));
+
+  for (size_t round = 0; round < 2; round++) {
+    if (round) {
+      for (size_t i = 3; i <= N; i += 3) {
+        char key[32];
+        sprintf(key, "doc%zu", i);
+        ASSERT_TRUE(DocTable_Delete(&dt, key, strlen(key)));
+      }
+    }
+    for (size_t i = 0; i < 5; i++) {
+      double min = (double)(1000 + prng() % (N * 10));
+      double max = (double)(1000 + prng() % (N * 10));
+      NumericFilter *flt = NewNumericFilter(std::min(min, max), std::max(min, max), i % 2, 1);
+
+      std::vector<t_docId> expected;
+      for (size_t id = 1; id <= N; id++) {
+        if (NumericFilter_Match(flt, lookup[id])) {
+          expected.push_back(id);
+        }
+      }
+
+      // the iterator does not check for deleted documents, the query pipeline does
+      IndexIterator *it = NewNumericRunsIterator(r, flt);
+      RSIndexResult *res = NULL;
+      size_t n = 0;
+      while (it && it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+        ASSERT_EQ(expected[n++], res->docId);
+      }
+      ASSERT_EQ(expected.size(), n);
+      if (it) it->Free(it);
+
+      size_t count = 0;
+      for (auto id : expected) {
+        count += !round || id % 3;
+      }
+      ASSERT_EQ(count, NumericRuns_Count(r, flt, &dt));
+      NumericFilter_Free(flt);
+    }
+  }
+
+  // merges drop the deleted entries
+  for (size_t i = N + 1; i <= 2 * N; i++) {
+    NumericRuns_Add(r, i, (double)(1000 + i * 10), &dt);
+  }
+  ASSERT_LT(r->numEntries, 2 * N);
+  ASSERT_EQ(0, NumericRuns_Add(r, N, 1, &dt));
+
+  // compaction drops every deleted entry left in the runs, keeping their sizes decreasing
+  size_t ndeleted = NumericRuns_NumDeleted(r, &dt);
+  ASSERT_LT(0, ndeleted);
+  size_t numEntries = r->numEntries;
+  ASSERT_EQ(ndeleted, NumericRuns_Compact(r, &dt));
+  ASSERT_EQ(numEntries - ndeleted, r->numEntries);
+  ASSERT_EQ(0, NumericRuns_NumDeleted(r, &dt));
+  for (size_t i = 1; i < array_len(r->runs); i++) {
+    ASSERT_GT(r->runs[i - 1].len, r->runs[i].len);
+  }
+
+  NumericFilter *flt = NewNumericFilter(-INFINITY, INFINITY, 1, 1);
+  IndexIterator *it = NewNumericRunsIterator(r, flt);
+  RSIndexResult *res = NULL;
+  t_docId lastId = 0;
+  size_t n = 0;
+  while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+    ASSERT_LT(lastId, res->docId);
+    ASSERT_LE(res->docId, N);
+    ASSERT_NE(0, res->docId % 3);
+    lastId = res->docId;
+    n++;
+  }
+  ASSERT_EQ(N - N / 3, n);
+  ASSERT_EQ(n, r->numEntries);
+  it->Free(it);
+  NumericFilter_Free(flt);
+
+  NumericRuns_Free(r);
+  DocTable_Free(&dt);
+}
+
+// Reference point-in-polygon test, looking at every edge
+static int containsAll(const double *lonlat, size_t n, double lon, double lat) {
+  int inside = 0;
+  for (size_t ii = 0, jj = n - 1; ii < n; jj = ii++) {
+    double xi = lonlat[2 * ii], yi = lonlat[2 * ii + 1];
+    double xj = lonlat[2 * jj], yj = lonlat[2 * jj + 1];
+    if ((yi > lat) != (yj > lat) && lon < xi + (lat - yi) * (xj - xi) / (yj - yi)) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+TEST_F(RangeTest, testGeoPolygon) {
+  // A concave star with many vertices, so its edges are spread over many bands
+  const size_t n = 400;
+  double lonlat[2 * n];
+  for (size_t ii = 0; ii < n; ++ii) {
+    double a = 2 * M_PI * ii / n;
+    double r = ii % 2 ? 1 : 0.4 + (prng() % 100) / 200.0;
+    lonlat[2 * ii] = 10 + r * cos(a);
+    lonlat[2 * ii + 1] = 50 + r * sin(a);
+  }
+  GeoPolygon *poly = NewGeoPolygon(lonlat, n);
+  ASSERT_LE(9, poly->bbox[0]);
+  ASSERT_GE(11, poly->bbox[2]);
+
+  size_t inside = 0;
+  for (size_t ii = 0; ii < 100000; ++ii) {
+    double lon = 8.8 + (prng() % 10000) / 4000.0;
+    double lat = 48.8 + (prng() % 10000) / 4000.0;
+    int expected = containsAll(lonlat, n, lon, lat);
+    ASSERT_EQ(expected, GeoPolygon_Contains(poly, lon, lat)) << lon << "," << lat;
+    inside += expected;
+  }
+  ASSERT_LT(0, inside);
+  GeoPolygon_Free(poly);
+
+  // A triangle with a horizontal edge
+  double tri[] = {0, 0, 4, 0, 2, 2};
+  poly = NewGeoPolygon(tri, 3);
+  ASSERT_TRUE(GeoPolygon_Contains(poly, 2, 1));
+  ASSERT_FALSE(GeoPolygon_Contains(poly, 0.5, 1.5));
+  ASSERT_FALSE(GeoPolygon_Contains(poly, 5, 1));
+  GeoPolygon_Free(poly);
+}
@@ -1,6 +1,10 @@
 #include <result_processor.h>
 #include <query.h>
+#include <spec.h>
+#include <index.h>
+#include <doc_values.h>
 #include <gtest/gtest.h>
+#include <vector>
 
 struct processor1Ctx : public ResultProcessor {
   processor1Ctx() {
@@ -77,4 +81,104 @@ TEST_F(ResultProcessorTest, testProcessorChain) {
   QITR_FreeChain(&qitr);
   ASSERT_EQ(2, numFreed);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+
+static int scores_Next(ResultProcessor *rp, SearchResult *res) {
+  processor1Ctx *p = static_cast<processor1Ctx *>(rp);
+  if (p->counter >= 1000) return RS_RESULT_EOF;
+
+  res->docId = ++p->counter;
+  res->score = (double)((res->docId * 7919) % 1000);
+  return RS_RESULT_OK;
+}
+
+TEST_F(ResultProcessorTest, testSorterTopK) {
+  QueryIterator qitr = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = scores_Next;
+  p->Free = resultProcessor_GenericFree;
+  QITR_PushRP(&qitr, p);
+  QITR_PushRP(&qitr, RPSorter_NewByScore(10));
+
+  SearchResult r = {0};
+  ResultProcessor *rpTail = qitr.endProc;
+  double expected = 999;
+  while (rpTail->Next(rpTail, &r) == RS_RESULT_OK) {
+    ASSERT_EQ(expected, r.score);
+    expected--;
+    SearchResult_Clear(&r);
+  }
+  ASSERT_EQ(989, expected);
+  SearchResult_Destroy(&r);
+  QITR_FreeChain(&qitr);
+}
+
+static int count_Next(ResultProcessor *rp, SearchResult *res) {
+  int rc = rp->upstream->Next(rp->upstream, res);
+  if (rc == RS_RESULT_OK) {
+    static_cast<processor1Ctx *>(rp)->counter++;
+  }
+  return rc;
+}
+
+TEST_F(ResultProcessorTest, testSorterDocValuesBound) {
+  const char *args[] = {"ON", "HASH", "SCHEMA", "bar", "numeric", "docvalues"};
+  QueryError err = {QUERY_OK};
+  IndexSpec *sp = IndexSpec_Parse("idx", args, sizeof(args) / sizeof(args[0]), &err);
+  ASSERT_FALSE(QueryError_HasError(&err)) << QueryError_GetError(&err);
+
+  const size_t N = 1000;
+  std::vector<t_docId> ids;
+  NumericColumn *col = IndexSpec_GetNumericColumn(sp, sp->fields[0].sortIdx);
+  ASSERT_TRUE(col != NULL);
+  for (size_t i = 0; i < N; ++i) {
+    char key[16];
+    size_t n = sprintf(key, "doc%lu", i);
+    t_docId id = DocTable_Put(&sp->docs, key, n, 1.0, 0, NULL, 0);
+    NumericColumn_Set(col, id, (double)((id * 7919) % N));
+    ids.push_back(id);
+  }
+
+  RLookup lk = {0};
+  RLookup_Init(&lk, IndexSpec_GetSpecCache(sp));
+  const RLookupKey *kk = RLookup_GetKey(&lk, "bar", 0);
+  ASSERT_TRUE(kk != NULL);
+  ASSERT_TRUE(kk->flags & RLOOKUP_F_DVSRC);
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  QueryIterator qitr = {0};
+  qitr.sctx = &sctx;
+  IndexIterator *root = NewIdListIterator(&ids[0], ids.size(), 1);
+  QITR_PushRP(&qitr, RPIndexIterator_New(root));
+  processor1Ctx *counter = new processor1Ctx();
+  counter->Next = count_Next;
+  counter->Free = resultProcessor_GenericFree;
+  QITR_PushRP(&qitr, counter);
+  // descending by the doc values field
+  ResultProcessor *sorter = RPSorter_NewByFields(10, &kk, 1, 0);
+  RPSorter_EnableSortBound(sorter);
+  QITR_PushRP(&qitr, sorter);
+
+  SearchResult r = {0};
+  ResultProcessor *rpTail = qitr.endProc;
+  double expected = N - 1;
+  while (rpTail->Next(rpTail, &r) == RS_RESULT_OK) {
+    const RSValue *v = RLookup_GetItem(kk, &r.rowdata);
+    ASSERT_TRUE(v != NULL);
+    ASSERT_EQ(RSValue_Number, v->t);
+    ASSERT_EQ(expected, v->numval);
+    expected--;
+    SearchResult_Clear(&r);
+  }
+  ASSERT_EQ(N - 11, expected);
+
+  // every document is counted, but those worse than the heap's bound never reach the sorter
+  ASSERT_EQ(N, qitr.totalResults);
+  ASSERT_LT(counter->counter, N / 2);
+
+  SearchResult_Destroy(&r);
+  QITR_FreeChain(&qitr);
+  root->Free(root);
+  RLookup_Cleanup(&lk);
+  IndexSpec_Free(sp);
+}
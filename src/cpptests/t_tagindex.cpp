@@ -1,4 +1,6 @@
 #include "tag_index.h"
+#include "inverted_index.h"
+#include "docid_bitmap.h"
 #include <gtest/gtest.h>
 #include <vector>
 #include <string>
@@ -48,6 +50,78 @@ TEST_F(TagIndexTest, testCreate) {
   TagIndex_Free(idx);
 }
 
+TEST_F(TagIndexTest, testBitmapReader) {
+  TagIndex *idx = NewTagIndex();
+  const char *dense = "dense", *sparse = "sparse";
+  const t_docId N = 30000;
+  for (t_docId d = 1; d <= N; d++) {
+    if (d % 3 == 0) TagIndex_Index(idx, &dense, 1, d);
+    if (d % 1000 == 0) TagIndex_Index(idx, &sparse, 1, d);
+  }
+
+  // sparse tags keep using the index reader
+  IndexIterator *it = TagIndex_OpenReader(idx, NULL, sparse, strlen(sparse), 1);
+  ASSERT_TRUE(it->Read == IR_Read);
+  it->Free(it);
+
+  it = TagIndex_OpenReader(idx, NULL, dense, strlen(dense), 1);
+  ASSERT_TRUE(it->Read != IR_Read);
+  ASSERT_EQ(N / 3, it->NumEstimated(it->ctx));
+
+  InvertedIndex *iv = TagIndex_OpenIndex(idx, dense, strlen(dense), 0);
+  IndexReader *ir = NewTermIndexReader(iv, NULL, RS_FIELDMASK_ALL, NULL, 1);
+
+  RSIndexResult *r1, *r2;
+  size_t n = 0;
+  while (true) {
+    int rc1 = it->Read(it->ctx, &r1);
+    int rc2 = IR_Read(ir, &r2);
+    ASSERT_EQ(rc2, rc1);
+    if (rc1 == INDEXREAD_EOF) break;
+    ASSERT_EQ(r2->docId, r1->docId);
+    ASSERT_EQ(r1->docId, it->LastDocId(it->ctx));
+    ++n;
+  }
+  ASSERT_EQ(N / 3, n);
+  IR_Free(ir);
+
+  // skipping lands on the same ids as the index reader
+  it->Rewind(it->ctx);
+  ir = NewTermIndexReader(iv, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  for (t_docId id = 1; id <= N + 10; id += 7) {
+    int rc1 = it->SkipTo(it->ctx, id, &r1);
+    int rc2 = IR_SkipTo(ir, id, &r2);
+    ASSERT_EQ(rc2, rc1);
+    if (rc1 == INDEXREAD_EOF) break;
+    ASSERT_EQ(r2->docId, r1->docId);
+  }
+  IR_Free(ir);
+
+  IndexCriteriaTester *ct = it->GetCriteriaTester(it->ctx);
+  ASSERT_TRUE(ct->Test(ct, 3));
+  ASSERT_FALSE(ct->Test(ct, 4));
+  ASSERT_FALSE(ct->Test(ct, N + 3));
+
+  // writes within the bitmap's capacity are visible to the cached bitmap. Growing it while the
+  // iterator still uses it drops it from the index instead
+  ASSERT_TRUE(iv->bitmap != NULL);
+  TagIndex_Index(idx, &dense, 1, N + 3);
+  ASSERT_TRUE(ct->Test(ct, N + 3));
+  TagIndex_Index(idx, &dense, 1, N + 200);
+  ASSERT_TRUE(iv->bitmap == NULL);
+  ASSERT_FALSE(ct->Test(ct, N + 200));
+  ct->Free(ct);
+  it->Free(it);
+
+  // a new reader materializes a fresh bitmap
+  it = TagIndex_OpenReader(idx, NULL, dense, strlen(dense), 1);
+  ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, N + 200, &r1));
+  ASSERT_EQ(N + 200, r1->docId);
+  ASSERT_EQ(INDEXREAD_EOF, it->Read(it->ctx, &r1));
+  it->Free(it);
+  TagIndex_Free(idx);
+}
+
 #define TEST_MY_SEP(sep, str)                     \
   orig = s = strdup(str);                         \
   token = TagIndex_SepString(sep, &s, &tokenLen); \
@@ -6,6 +6,7 @@
 #include "numeric_index.h"
 #include "phonetic_manager.h"
 #include "gc.h"
+#include "util/arr.h"
 
 #define DUMP_PHONETIC_HASH "DUMP_PHONETIC_HASH"
 
@@ -184,6 +185,54 @@ end:
   return REDISMODULE_OK;
 }
 
+static void replyWithHistogram(RedisModuleCtx *ctx, size_t *hist) {
+  RedisModule_ReplyWithArray(ctx, array_len(hist));
+  for (size_t ii = 0; ii < array_len(hist); ++ii) {
+    RedisModule_ReplyWithLongLong(ctx, hist[ii]);
+  }
+}
+
+DEBUG_COMMAND(NumericIndexHistogram) {
+  if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  GET_SEARCH_CTX(argv[0])
+  RedisModuleKey *keyp = NULL;
+  RedisModuleString *keyName = getFieldKeyName(sctx->spec, argv[1], INDEXFLD_T_NUMERIC);
+  if (!keyName) {
+    RedisModule_ReplyWithError(sctx->redisCtx, "Could not find given field in index spec");
+    goto end;
+  }
+  NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &keyp);
+  if (!rt) {
+    RedisModule_ReplyWithError(sctx->redisCtx, "can not open numeric field");
+    goto end;
+  }
+
+  NumericRangeTreeStats stats;
+  NumericRangeTree_GetStats(rt, &stats);
+
+  size_t len = 0;
+  RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+  REPLY_WITH_LONG_LONG("height", stats.height, len);
+  REPLY_WITH_LONG_LONG("numLeaves", stats.numLeaves, len);
+  RedisModule_ReplyWithSimpleString(ctx, "leafDepths");
+  replyWithHistogram(ctx, stats.leafDepths);
+  RedisModule_ReplyWithSimpleString(ctx, "leafSizes");
+  replyWithHistogram(ctx, stats.leafSizes);
+  len += 4;
+  RedisModule_ReplySetArrayLength(ctx, len);
+
+  NumericRangeTreeStats_Free(&stats);
+
+end:
+  if (keyp) {
+    RedisModule_CloseKey(keyp);
+  }
+  SearchCtx_Free(sctx);
+  return REDISMODULE_OK;
+}
+
 DEBUG_COMMAND(DumpNumericIndex) {
   if (argc != 2) {
     return RedisModule_WrongArity(ctx);
@@ -601,6 +650,7 @@ DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex},
                                {"DUMP_TERMS", DumpTerms},
                                {"INVIDX_SUMMARY", InvertedIndexSummary},
                                {"NUMIDX_SUMMARY", NumericIndexSummary},
+                               {"NUMIDX_HISTOGRAM", NumericIndexHistogram},
                                {"GC_FORCEINVOKE", GCForceInvoke},
                                {"GC_FORCEBGINVOKE", GCForceBGInvoke},
                                {"GIT_SHA", GitSha},
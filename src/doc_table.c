@@ -4,7 +4,6 @@
 #include <stdio.h>
 #include "redismodule.h"
 #include "util/fnv.h"
-#include "dep/triemap/triemap.h"
 #include "sortable.h"
 #include "rmalloc.h"
 #include "spec.h"
@@ -12,65 +11,58 @@
 #include "rmutil/rm_assert.h"
 
 /* Creates a new DocTable with a given capacity */
-DocTable NewDocTable(size_t cap, size_t max_size) {
+DocTable NewDocTable(size_t cap) {
   DocTable ret = {
       .size = 1,
-      .cap = cap,
       .maxDocId = 0,
       .memsize = 0,
       .sortablesSize = 0,
-      .maxSize = max_size,
       .dim = NewDocIdMap(),
   };
-  ret.buckets = rm_calloc(cap, sizeof(*ret.buckets));
+  ret.npages = (cap >> DOCTABLE_PAGE_BITS) + 1;
+  ret.pages = rm_calloc(ret.npages, sizeof(*ret.pages));
   return ret;
 }
 
-static inline uint32_t DocTable_GetBucket(const DocTable *t, t_docId docId) {
-  return docId < t->maxSize ? docId : docId % t->maxSize;
-}
-
 static inline int DocTable_ValidateDocId(const DocTable *t, t_docId docId) {
   return docId != 0 && docId <= t->maxDocId;
 }
 
+#define DOCTABLE_PAGE_BYTES(n) (sizeof(DocTablePage) + (n) * sizeof(RSDocumentMetadata *))
+
+/* The position of the first document of a packed page whose id is not below docId */
+static size_t DocTablePage_Find(const DocTablePage *page, t_docId docId) {
+  size_t lo = 0, hi = page->used;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (page->dmds[mid]->id < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
 RSDocumentMetadata *DocTable_Get(const DocTable *t, t_docId docId) {
   if (!DocTable_ValidateDocId(t, docId)) {
     return NULL;
   }
-  uint32_t bucketIndex = DocTable_GetBucket(t, docId);
-  if (bucketIndex >= t->cap) {
+  size_t pageIndex = docId >> DOCTABLE_PAGE_BITS;
+  if (pageIndex >= t->npages || !t->pages[pageIndex]) {
     return NULL;
   }
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  DLLIST2_FOREACH(it, &dmdChain->lroot) {
-    RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    if (dmd->id == docId) {
-      return dmd;
-    }
+  const DocTablePage *page = t->pages[pageIndex];
+  if (page->packed) {
+    size_t ix = DocTablePage_Find(page, docId);
+    return ix < page->used && page->dmds[ix]->id == docId ? page->dmds[ix] : NULL;
   }
-  return NULL;
+  return page->dmds[docId & DOCTABLE_PAGE_MASK];
 }
 
 int DocTable_Exists(const DocTable *t, t_docId docId) {
-  if (!docId || docId > t->maxDocId) {
-    return 0;
-  }
-  uint32_t ix = DocTable_GetBucket(t, docId);
-  if (ix >= t->cap) {
-    return 0;
-  }
-  const DMDChain *chain = t->buckets + ix;
-  if (chain == NULL) {
-    return 0;
-  }
-  DLLIST2_FOREACH(it, &chain->lroot) {
-    const RSDocumentMetadata *md = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    if (md->id == docId && !(md->flags & Document_Deleted)) {
-      return 1;
-    }
-  }
-  return 0;
+  const RSDocumentMetadata *md = DocTable_Get(t, docId);
+  return md && !(md->flags & Document_Deleted);
 }
 
 RSDocumentMetadata *DocTable_GetByKeyR(const DocTable *t, RedisModuleString *s) {
@@ -81,30 +73,59 @@ RSDocumentMetadata *DocTable_GetByKeyR(const DocTable *t, RedisModuleString *s)
   return DocTable_Get(t, id);
 }
 
+/* Pack the page if it is sparse and no longer gets new documents */
+static void DocTable_MaybePackPage(DocTable *t, size_t pageIndex) {
+  DocTablePage *page = t->pages[pageIndex];
+  if (!page || page->packed || page->used > DOCTABLE_PAGE_PACK_THRESHOLD ||
+      pageIndex >= (t->maxDocId >> DOCTABLE_PAGE_BITS)) {
+    return;
+  }
+  DocTablePage *packed = rm_malloc(DOCTABLE_PAGE_BYTES(page->used));
+  packed->used = page->used;
+  packed->packed = 1;
+  size_t n = 0;
+  for (size_t ii = 0; ii < DOCTABLE_PAGE_SIZE && n < page->used; ++ii) {
+    if (page->dmds[ii]) {
+      packed->dmds[n++] = page->dmds[ii];
+    }
+  }
+  rm_free(page);
+  t->pages[pageIndex] = packed;
+  t->memsize -= DOCTABLE_PAGE_BYTES(DOCTABLE_PAGE_SIZE) - DOCTABLE_PAGE_BYTES(packed->used);
+}
+
 static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *dmd) {
-  uint32_t bucket = DocTable_GetBucket(t, docId);
-  if (bucket >= t->cap && t->cap < t->maxSize) {
-    /* We have to grow the array capacity.
-     * We only grow till we reach maxSize, then we starts to add the dmds to
-     * the already existing chains.
-     */
-    size_t oldcap = t->cap;
-    // We grow by half of the current capacity with maximum of 1m
-    t->cap += 1 + (t->cap ? MIN(t->cap / 2, 1024 * 1024) : 1);
-    t->cap = MIN(t->cap, t->maxSize);  // make sure we do not excised maxSize
-    t->cap = MAX(t->cap, bucket + 1);  // docs[bucket] needs to be valid, so t->cap > bucket
-    t->buckets = rm_realloc(t->buckets, t->cap * sizeof(DMDChain));
-    for (; oldcap < t->cap; oldcap++) {
-      t->buckets[oldcap].lroot.head = NULL;
-      t->buckets[oldcap].lroot.tail = NULL;
+  size_t pageIndex = docId >> DOCTABLE_PAGE_BITS;
+  if (pageIndex >= t->npages) {
+    // Doc ids only grow, so double the page directory rather than fitting it to the new id
+    size_t npages = MAX(t->npages * 2, pageIndex + 1);
+    t->pages = rm_realloc(t->pages, npages * sizeof(*t->pages));
+    memset(t->pages + t->npages, 0, (npages - t->npages) * sizeof(*t->pages));
+    t->npages = npages;
+  }
+  DocTablePage *page = t->pages[pageIndex];
+  if (!page) {
+    page = t->pages[pageIndex] = rm_calloc(1, DOCTABLE_PAGE_BYTES(DOCTABLE_PAGE_SIZE));
+    t->memsize += DOCTABLE_PAGE_BYTES(DOCTABLE_PAGE_SIZE);
+    // the previous page is complete now, and may already be sparse
+    if (pageIndex) {
+      DocTable_MaybePackPage(t, pageIndex - 1);
     }
   }
 
-  DMDChain *chain = &t->buckets[bucket];
   DMD_Incref(dmd);
+  page->dmds[docId & DOCTABLE_PAGE_MASK] = dmd;
+  page->used++;
+}
 
-  // Adding the dmd to the chain
-  dllist2_append(&chain->lroot, &dmd->llnode);
+/* Copy a payload into a single allocation, with its data null terminated */
+static RSPayload *DocTable_NewPayload(const char *data, size_t len) {
+  RSPayload *pl = rm_malloc(sizeof(*pl) + len + 1);
+  pl->data = (char *)(pl + 1);
+  pl->len = len;
+  memcpy(pl->data, data, len);
+  pl->data[len] = '\0';
+  return pl;
 }
 
 /** Get the docId of a key if it exists in the table, or 0 if it doesnt */
@@ -123,18 +144,10 @@ int DocTable_SetPayload(DocTable *t, t_docId docId, const char *data, size_t len
 
   /* If we already have metadata - clean up the old data */
   if (dmd->payload) {
-    /* Free the old payload */
-    if (dmd->payload->data) {
-      rm_free((void *)dmd->payload->data);
-    }
     t->memsize -= dmd->payload->len;
-  } else {
-    dmd->payload = rm_malloc(sizeof(RSPayload));
+    rm_free(dmd->payload);
   }
-  /* Copy it... */
-  dmd->payload->data = rm_calloc(1, len + 1);
-  dmd->payload->len = len;
-  memcpy(dmd->payload->data, data, len);
+  dmd->payload = DocTable_NewPayload(data, len);
 
   dmd->flags |= Document_HasPayload;
   t->memsize += len;
@@ -177,7 +190,7 @@ int DocTable_SetByteOffsets(DocTable *t, t_docId docId, RSByteOffsets *v) {
     return 0;
   }
 
-  dmd->byteOffsets = v;
+  dmd->byteOffsets = RSByteOffsets_Pack(v);
   dmd->flags |= Document_HasOffsetVector;
   return 1;
 }
@@ -200,10 +213,7 @@ t_docId DocTable_Put(DocTable *t, const char *s, size_t n, double score, u_char
   RSPayload *dpl = NULL;
   if (payload && payloadSize) {
 
-    dpl = rm_malloc(sizeof(RSPayload));
-    dpl->data = rm_calloc(1, payloadSize + 1);
-    memcpy(dpl->data, payload, payloadSize);
-    dpl->len = payloadSize;
+    dpl = DocTable_NewPayload(payload, payloadSize);
     flags |= Document_HasPayload;
     t->memsize += payloadSize + sizeof(RSPayload);
   }
@@ -215,6 +225,7 @@ t_docId DocTable_Put(DocTable *t, const char *s, size_t n, double score, u_char
     dmd = rm_calloc(1, sizeof(RSDocumentMetadata));
     dmd->keyPtr = keyPtr;
     dmd->score = score;
+    DocTable_UpdateMaxScore(t, score);
     dmd->flags = flags;
     dmd->payload = dpl;
     dmd->maxFreq = 1;
@@ -225,7 +236,7 @@ t_docId DocTable_Put(DocTable *t, const char *s, size_t n, double score, u_char
   DocTable_Set(t, docId, dmd);
   ++t->size;
   t->memsize += sizeof(RSDocumentMetadata) + sdsAllocSize(keyPtr);
-  DocIdMap_Put(&t->dim, s, n, docId);
+  DocIdMap_Put(&t->dim, dmd);
   return docId;
 }
 
@@ -259,7 +270,6 @@ inline float DocTable_GetScore(DocTable *t, t_docId docId) {
 
 void DMD_Free(RSDocumentMetadata *md) {
   if (md->payload) {
-    rm_free(md->payload->data);
     rm_free(md->payload);
     md->flags &= ~Document_HasPayload;
     md->payload = NULL;
@@ -279,26 +289,50 @@ void DMD_Free(RSDocumentMetadata *md) {
 }
 
 void DocTable_Free(DocTable *t) {
-  for (int i = 0; i < t->cap; ++i) {
-    DMDChain *chain = &t->buckets[i];
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {
+  for (size_t i = 0; i < t->npages; ++i) {
+    DocTablePage *page = t->pages[i];
+    if (!page) {
       continue;
     }
-    DLLIST2_node *nn = chain->lroot.head;
-    while (nn) {
-      RSDocumentMetadata *md = DLLIST2_ITEM(nn, RSDocumentMetadata, llnode);
-      nn = nn->next;
-      DMD_Free(md);
+    size_t n = page->packed ? page->used : DOCTABLE_PAGE_SIZE;
+    for (size_t j = 0; j < n; ++j) {
+      if (page->dmds[j]) {
+        DMD_Free(page->dmds[j]);
+      }
     }
+    rm_free(page);
   }
-  rm_free(t->buckets);
+  rm_free(t->pages);
   DocIdMap_Free(&t->dim);
 }
 
-static void DocTable_DmdUnchain(DocTable *t, RSDocumentMetadata *md) {
-  uint32_t bucketIndex = DocTable_GetBucket(t, md->id);
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  dllist2_delete(&dmdChain->lroot, &md->llnode);
+/* Remove the document from its page, packing the page once it is sparse and freeing it if it was
+ * its last document */
+static void DocTable_Unset(DocTable *t, t_docId docId) {
+  size_t pageIndex = docId >> DOCTABLE_PAGE_BITS;
+  DocTablePage *page = t->pages[pageIndex];
+  if (!page->packed) {
+    page->dmds[docId & DOCTABLE_PAGE_MASK] = NULL;
+    if (!--page->used) {
+      rm_free(page);
+      t->pages[pageIndex] = NULL;
+      t->memsize -= DOCTABLE_PAGE_BYTES(DOCTABLE_PAGE_SIZE);
+    } else {
+      DocTable_MaybePackPage(t, pageIndex);
+    }
+    return;
+  }
+
+  size_t ix = DocTablePage_Find(page, docId);
+  memmove(page->dmds + ix, page->dmds + ix + 1, (page->used - ix - 1) * sizeof(*page->dmds));
+  t->memsize -= sizeof(*page->dmds);
+  if (!--page->used) {
+    rm_free(page);
+    t->pages[pageIndex] = NULL;
+    t->memsize -= DOCTABLE_PAGE_BYTES(0);
+  } else {
+    t->pages[pageIndex] = rm_realloc(page, DOCTABLE_PAGE_BYTES(page->used));
+  }
 }
 
 int DocTable_Delete(DocTable *t, const char *s, size_t n) {
@@ -322,7 +356,7 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
 
     md->flags |= Document_Deleted;
 
-    DocTable_DmdUnchain(t, md);
+    DocTable_Unset(t, docId);
     DocIdMap_Delete(&t->dim, s, n);
     --t->size;
 
@@ -331,45 +365,43 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
   return NULL;
 }
 
+static void DocTable_RdbSaveDmd(RedisModuleIO *rdb, const RSDocumentMetadata *dmd) {
+  RedisModule_SaveStringBuffer(rdb, dmd->keyPtr, sdslen(dmd->keyPtr));
+  RedisModule_SaveUnsigned(rdb, dmd->flags);
+  RedisModule_SaveUnsigned(rdb, dmd->maxFreq);
+  RedisModule_SaveUnsigned(rdb, dmd->len);
+  RedisModule_SaveFloat(rdb, dmd->score);
+  if (dmd->flags & Document_HasPayload) {
+    if (dmd->payload) {
+      // save an extra space for the null terminator to make the payload null terminated on
+      RedisModule_SaveStringBuffer(rdb, dmd->payload->data, dmd->payload->len + 1);
+    } else {
+      RedisModule_SaveStringBuffer(rdb, "", 1);
+    }
+  }
+
+  //  if (dmd->flags & Document_HasSortVector) {
+  //    SortingVector_RdbSave(rdb, dmd->sortVector);
+  //  }
+
+  if (dmd->flags & Document_HasOffsetVector) {
+    Buffer tmp;
+    Buffer_Init(&tmp, 16);
+    RSByteOffsets_Serialize(dmd->byteOffsets, &tmp);
+    RedisModule_SaveStringBuffer(rdb, tmp.data, tmp.offset);
+    Buffer_Free(&tmp);
+  }
+}
+
 void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb) {
 
   RedisModule_SaveUnsigned(rdb, t->size);
 
   uint32_t elements_written = 0;
-  for (uint32_t i = 0; i < t->cap; ++i) {
-    if (DLLIST2_IS_EMPTY(&t->buckets[i].lroot)) {
-      continue;
-    }
-    DLLIST2_FOREACH(it, &t->buckets[i].lroot) {
-      const RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-      RedisModule_SaveStringBuffer(rdb, dmd->keyPtr, sdslen(dmd->keyPtr));
-      RedisModule_SaveUnsigned(rdb, dmd->flags);
-      RedisModule_SaveUnsigned(rdb, dmd->maxFreq);
-      RedisModule_SaveUnsigned(rdb, dmd->len);
-      RedisModule_SaveFloat(rdb, dmd->score);
-      if (dmd->flags & Document_HasPayload) {
-        if (dmd->payload) {
-          // save an extra space for the null terminator to make the payload null terminated on
-          RedisModule_SaveStringBuffer(rdb, dmd->payload->data, dmd->payload->len + 1);
-        } else {
-          RedisModule_SaveStringBuffer(rdb, "", 1);
-        }
-      }
-
-      //      if (dmd->flags & Document_HasSortVector) {
-      //        SortingVector_RdbSave(rdb, dmd->sortVector);
-      //      }
-
-      if (dmd->flags & Document_HasOffsetVector) {
-        Buffer tmp;
-        Buffer_Init(&tmp, 16);
-        RSByteOffsets_Serialize(dmd->byteOffsets, &tmp);
-        RedisModule_SaveStringBuffer(rdb, tmp.data, tmp.offset);
-        Buffer_Free(&tmp);
-      }
-      ++elements_written;
-    }
-  }
+  DOCTABLE_FOREACH(t, {
+    DocTable_RdbSaveDmd(rdb, dmd);
+    ++elements_written;
+  });
   RS_LOG_ASSERT((elements_written + 1 == t->size), "Wrong number of written elements");
 }
 
@@ -377,25 +409,6 @@ void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
   long long deletedElements = 0;
   size_t size = RedisModule_LoadUnsigned(rdb);
   //  t->maxDocId = RedisModule_LoadUnsigned(rdb);
-  //  if (encver >= INDEX_MIN_COMPACTED_DOCTABLE_VERSION) {
-  //    t->maxSize = RedisModule_LoadUnsigned(rdb);
-  //  } else {
-  //    t->maxSize = MIN(RSGlobalConfig.maxDocTableSize, t->maxDocId);
-  //  }
-
-  //  if (t->maxDocId > t->maxSize) {
-  //    /**
-  //     * If the maximum doc id is greater than the maximum cap size
-  //     * then it means there is a possibility that any index under maxId can
-  //     * be accessed. However, it is possible that this bucket does not have
-  //     * any documents inside it (and thus might not be populated below), but
-  //     * could still be accessed for simple queries (e.g. get, exist). Ensure
-  //     * we don't have to rely on Set/Put to ensure the doc table array.
-  //     */
-  //    t->cap = t->maxSize;
-  //    rm_free(t->buckets);
-  //    t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
-  //  }
 
   for (size_t i = 1; i < size; i++) {
     size_t len;
@@ -425,17 +438,16 @@ void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
     }
 
     dmd->score = RedisModule_LoadFloat(rdb);
+    DocTable_UpdateMaxScore(t, dmd->score);
     dmd->payload = NULL;
     // read payload if set
     if ((dmd->flags & Document_HasPayload)) {
       if (!(dmd->flags & Document_Deleted)) {
-        dmd->payload = rm_malloc(sizeof(RSPayload));
-        dmd->payload->data = RedisModule_LoadStringBuffer(rdb, &dmd->payload->len);
-        char *buf = rm_malloc(dmd->payload->len);
-        memcpy(buf, dmd->payload->data, dmd->payload->len);
-        RedisModule_Free(dmd->payload->data);
-        dmd->payload->data = buf;
-        dmd->payload->len--;
+        size_t plen;
+        char *buf = RedisModule_LoadStringBuffer(rdb, &plen);
+        // The saved payload includes its null terminator
+        dmd->payload = DocTable_NewPayload(buf, plen - 1);
+        RedisModule_Free(buf);
         t->memsize += dmd->payload->len + sizeof(RSPayload);
       } else if ((dmd->flags & Document_Deleted) && (encver == INDEX_MIN_EXPIRE_VERSION)) {
         RedisModule_Free(RedisModule_LoadStringBuffer(rdb, NULL));  // throw this string to garbage
@@ -462,46 +474,116 @@ void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
       RedisModuleString *keyRedisStr =
           RedisModule_CreateString(NULL, dmd->keyPtr, sdslen(dmd->keyPtr));
       RedisModule_FreeString(NULL, keyRedisStr);
-      //      DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
+      //      DocIdMap_Put(&t->dim, dmd);
       //      DocTable_Set(t, dmd->id, dmd);
       //      t->memsize += sizeof(RSDocumentMetadata) + len;
     }
   }
 }
 
+#define DOCIDMAP_MIN_CAP 16
+
+static inline uint32_t DocIdMap_Hash(const char *s, size_t n) {
+  return rs_fnv_32a_buf(s, n, 0);
+}
+
+static inline int DocIdMap_KeyEquals(const RSDocumentMetadata *dmd, const char *s, size_t n) {
+  return sdslen(dmd->keyPtr) == n && !memcmp(dmd->keyPtr, s, n);
+}
+
 DocIdMap NewDocIdMap() {
+  DocIdMap m = {.cap = DOCIDMAP_MIN_CAP, .size = 0};
+  m.hashes = rm_malloc(m.cap * sizeof(*m.hashes));
+  m.dmds = rm_calloc(m.cap, sizeof(*m.dmds));
+  return m;
+}
 
-  TrieMap *m = NewTrieMap();
-  return (DocIdMap){m};
+/* Return the slot of the key, or the empty slot where it would be inserted */
+static size_t DocIdMap_Find(const DocIdMap *m, const char *s, size_t n, uint32_t hash) {
+  size_t mask = m->cap - 1;
+  size_t ix = hash & mask;
+  // The map is never full, so there is always an empty slot to stop at
+  while (m->dmds[ix] && (m->hashes[ix] != hash || !DocIdMap_KeyEquals(m->dmds[ix], s, n))) {
+    ix = (ix + 1) & mask;
+  }
+  return ix;
 }
 
 t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
+  size_t ix = DocIdMap_Find(m, s, n, DocIdMap_Hash(s, n));
+  return m->dmds[ix] ? m->dmds[ix]->id : 0;
+}
 
-  void *val = TrieMap_Find(m->tm, (char *)s, n);
-  if (val && val != TRIEMAP_NOTFOUND) {
-    return *((t_docId *)val);
+static void DocIdMap_Grow(DocIdMap *m) {
+  uint32_t *hashes = m->hashes;
+  RSDocumentMetadata **dmds = m->dmds;
+  size_t cap = m->cap;
+
+  m->cap *= 2;
+  m->hashes = rm_malloc(m->cap * sizeof(*m->hashes));
+  m->dmds = rm_calloc(m->cap, sizeof(*m->dmds));
+  size_t mask = m->cap - 1;
+  for (size_t ii = 0; ii < cap; ++ii) {
+    if (!dmds[ii]) {
+      continue;
+    }
+    size_t ix = hashes[ii] & mask;
+    while (m->dmds[ix]) {
+      ix = (ix + 1) & mask;
+    }
+    m->hashes[ix] = hashes[ii];
+    m->dmds[ix] = dmds[ii];
   }
-  return 0;
+  rm_free(hashes);
+  rm_free(dmds);
 }
 
-void *_docIdMap_replace(void *oldval, void *newval) {
-  if (oldval) {
-    rm_free(oldval);
+void DocIdMap_Put(DocIdMap *m, RSDocumentMetadata *dmd) {
+  // Keep the load factor under 3/4
+  if ((m->size + 1) * 4 > m->cap * 3) {
+    DocIdMap_Grow(m);
+  }
+  size_t n = sdslen(dmd->keyPtr);
+  uint32_t hash = DocIdMap_Hash(dmd->keyPtr, n);
+  size_t ix = DocIdMap_Find(m, dmd->keyPtr, n, hash);
+  if (!m->dmds[ix]) {
+    m->size++;
   }
-  return newval;
+  m->hashes[ix] = hash;
+  m->dmds[ix] = dmd;
 }
 
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId) {
-
-  t_docId *pd = rm_malloc(sizeof(t_docId));
-  *pd = docId;
-  TrieMap_Add(m->tm, (char *)s, n, pd, _docIdMap_replace);
+int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n) {
+  size_t ix = DocIdMap_Find(m, s, n, DocIdMap_Hash(s, n));
+  if (!m->dmds[ix]) {
+    return 0;
+  }
+  m->dmds[ix] = NULL;
+  m->size--;
+
+  // Shift back the entries after the hole that could not be placed at their home slot, so no
+  // lookup stops at the hole before reaching its key
+  size_t mask = m->cap - 1;
+  size_t hole = ix;
+  for (size_t jj = (ix + 1) & mask; m->dmds[jj]; jj = (jj + 1) & mask) {
+    size_t home = m->hashes[jj] & mask;
+    // Leave the entry if its home is cyclically in (hole, jj]
+    if (hole <= jj ? (hole < home && home <= jj) : (hole < home || home <= jj)) {
+      continue;
+    }
+    m->hashes[hole] = m->hashes[jj];
+    m->dmds[hole] = m->dmds[jj];
+    m->dmds[jj] = NULL;
+    hole = jj;
+  }
+  return 1;
 }
 
-void DocIdMap_Free(DocIdMap *m) {
-  TrieMap_Free(m->tm, rm_free);
+size_t DocIdMap_MemUsage(const DocIdMap *m) {
+  return m->cap * (sizeof(*m->hashes) + sizeof(*m->dmds));
 }
 
-int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n) {
-  return TrieMap_Delete(m->tm, (char *)s, n, rm_free);
+void DocIdMap_Free(DocIdMap *m) {
+  rm_free(m->hashes);
+  rm_free(m->dmds);
 }
@@ -3,7 +3,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include "redismodule.h"
-#include "dep/triemap/triemap.h"
 #include "redisearch.h"
 #include "sortable.h"
 #include "byte_offsets.h"
@@ -27,19 +26,32 @@ static inline RedisModuleString *DMD_CreateKeyString(const RSDocumentMetadata *d
   return RedisModule_CreateString(ctx, dmd->keyPtr, sdslen(dmd->keyPtr));
 }
 
-/* Map between external id an incremental id */
+/* Map between external id an incremental id.
+ *
+ * An open addressing hash table of document metadata, probed linearly. The keys are not copied:
+ * an entry points to the metadata of its document, which has both the key and the doc id, and the
+ * full hash of the key is kept next to it so that only true matches are compared. A document must
+ * be removed from the map before its metadata is freed */
 typedef struct {
-  TrieMap *tm;
+  uint32_t *hashes;
+  RSDocumentMetadata **dmds;
+  // Number of slots, a power of 2
+  size_t cap;
+  size_t size;
 } DocIdMap;
 
 DocIdMap NewDocIdMap();
 /* Get docId from a did-map. Returns 0  if the key is not in the map */
 t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n);
 
-/* Put a new doc id in the map if it does not already exist */
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId);
+/* Put a document in the map, keyed by its metadata's key. The key must not already be in the map */
+void DocIdMap_Put(DocIdMap *m, RSDocumentMetadata *dmd);
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n);
+
+/* Memory used by the map, not counting the keys which belong to the documents' metadata */
+size_t DocIdMap_MemUsage(const DocIdMap *m);
+
 /* Free the doc id map */
 void DocIdMap_Free(DocIdMap *m);
 
@@ -52,20 +64,40 @@ void DocIdMap_Free(DocIdMap *m);
  * the
  * same key. This may result in document duplication in results  */
 
+#define DOCTABLE_PAGE_BITS 10
+#define DOCTABLE_PAGE_SIZE (1 << DOCTABLE_PAGE_BITS)
+#define DOCTABLE_PAGE_MASK (DOCTABLE_PAGE_SIZE - 1)
+
+// Pages left with this many documents or fewer are packed, see DocTablePage
+#define DOCTABLE_PAGE_PACK_THRESHOLD (DOCTABLE_PAGE_SIZE / 16)
+
+/* The metadata of DOCTABLE_PAGE_SIZE consecutive doc ids.
+ *
+ * A page has a slot for each of its doc ids while documents are added to it. Once new doc ids are
+ * past the page and deletions leave it with at most DOCTABLE_PAGE_PACK_THRESHOLD documents, it is
+ * packed: it is reallocated to hold only its `used` documents, ordered by doc id, and lookups
+ * search it by the documents' ids. Packed pages never get new documents, since doc ids only grow */
 typedef struct {
-  DLLIST2 lroot;
-} DMDChain;
+  // Number of documents in the page
+  uint32_t used;
+  uint32_t packed;
+  RSDocumentMetadata *dmds[];
+} DocTablePage;
 
 typedef struct {
   size_t size;
-  // the maximum size this table is allowed to grow to
-  t_docId maxSize;
   t_docId maxDocId;
-  size_t cap;
+  // The metadata of doc id n is in pages[n >> DOCTABLE_PAGE_BITS]. Pages are allocated when their
+  // first document is added, packed once they are sparse and freed when their last one is deleted,
+  // so ranges of deleted documents take up a single pointer per page
+  DocTablePage **pages;
+  size_t npages;
   size_t memsize;
   size_t sortablesSize;
+  // The highest score given to any document. It is never lowered, so it bounds the scores of all
+  // the documents in the table
+  float maxScore;
 
-  DMDChain *buckets;
   DocIdMap dim;
 } DocTable;
 
@@ -73,22 +105,27 @@ typedef struct {
 #define DMD_Incref(md) \
   if (md) ++md->ref_count;
 
-#define DOCTABLE_FOREACH(dt, code)                                           \
-  for (size_t i = 1; i < dt->cap; ++i) {                                     \
-    DMDChain *chain = &dt->buckets[i];                                       \
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {                                   \
-      continue;                                                              \
-    }                                                                        \
-    DLLIST2_FOREACH(it, &chain->lroot) {                                     \
-      RSDocumentMetadata *dmd = DLLIST_ITEM(it, RSDocumentMetadata, llnode); \
-      code;                                                                  \
-    }                                                                        \
+/* Run `code` for the metadata `dmd` of every document in the table, by increasing doc id */
+#define DOCTABLE_FOREACH(dt, code)                                \
+  for (size_t pi_ = 0; pi_ < (dt)->npages; ++pi_) {               \
+    DocTablePage *page_ = (dt)->pages[pi_];                       \
+    if (!page_) {                                                 \
+      continue;                                                   \
+    }                                                             \
+    size_t n_ = page_->packed ? page_->used : DOCTABLE_PAGE_SIZE; \
+    for (size_t ii_ = 0; ii_ < n_; ++ii_) {                       \
+      RSDocumentMetadata *dmd = page_->dmds[ii_];                 \
+      if (!dmd) {                                                 \
+        continue;                                                 \
+      }                                                           \
+      code;                                                       \
+    }                                                             \
   }
 
-/* Creates a new DocTable with a given capacity */
-DocTable NewDocTable(size_t cap, size_t max_size);
+/* Creates a new DocTable with room for `cap` documents before growing */
+DocTable NewDocTable(size_t cap);
 
-#define DocTable_New(cap) NewDocTable(cap, RSGlobalConfig.maxDocTableSize)
+#define DocTable_New(cap) NewDocTable(cap)
 
 /* Get the metadata for a doc Id from the DocTable.
  *  If docId is not inside the table, we return NULL */
@@ -113,6 +150,12 @@ const char *DocTable_GetKey(DocTable *t, t_docId docId, size_t *n);
 /* Get the score for a document from the table. Returns 0 if docId is not in the table. */
 float DocTable_GetScore(DocTable *t, t_docId docId);
 
+static inline void DocTable_UpdateMaxScore(DocTable *t, float score) {
+  if (score > t->maxScore) {
+    t->maxScore = score;
+  }
+}
+
 /* Set the payload for a document. Returns 1 if we set the payload, 0 if we couldn't find the
  * document */
 int DocTable_SetPayload(DocTable *t, t_docId docId, const char *data, size_t len);
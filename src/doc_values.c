@@ -0,0 +1,57 @@
+#include "doc_values.h"
+#include "rmalloc.h"
+#include <string.h>
+#include <sys/param.h>
+
+NumericColumn *NewNumericColumn() {
+  NumericColumn *col = rm_new(NumericColumn);
+  col->pages = NULL;
+  col->npages = 0;
+  col->numPages = 0;
+  return col;
+}
+
+void NumericColumn_Set(NumericColumn *col, t_docId docId, double value) {
+  size_t pageIndex = docId >> NUMERIC_COLUMN_PAGE_BITS;
+  NumericColumnPage *page = pageIndex < col->npages ? col->pages[pageIndex] : NULL;
+  if (!page) {
+    if (isnan(value)) {
+      return;
+    }
+    if (pageIndex >= col->npages) {
+      // Doc ids only grow, so double the page directory rather than fitting it to the new id
+      size_t npages = MAX(col->npages * 2, pageIndex + 1);
+      col->pages = rm_realloc(col->pages, npages * sizeof(*col->pages));
+      memset(col->pages + col->npages, 0, (npages - col->npages) * sizeof(*col->pages));
+      col->npages = npages;
+    }
+    page = col->pages[pageIndex] = rm_malloc(sizeof(*page));
+    page->used = 0;
+    for (size_t ii = 0; ii < NUMERIC_COLUMN_PAGE_SIZE; ++ii) {
+      page->values[ii] = NAN;
+    }
+    col->numPages++;
+  }
+
+  double *slot = page->values + (docId & NUMERIC_COLUMN_PAGE_MASK);
+  page->used += !isnan(value) - !isnan(*slot);
+  *slot = value;
+  if (!page->used) {
+    rm_free(page);
+    col->pages[pageIndex] = NULL;
+    col->numPages--;
+  }
+}
+
+size_t NumericColumn_MemUsage(const NumericColumn *col) {
+  return sizeof(*col) + col->npages * sizeof(*col->pages) +
+         col->numPages * sizeof(NumericColumnPage);
+}
+
+void NumericColumn_Free(NumericColumn *col) {
+  for (size_t ii = 0; ii < col->npages; ++ii) {
+    rm_free(col->pages[ii]);
+  }
+  rm_free(col->pages);
+  rm_free(col);
+}
@@ -0,0 +1,55 @@
+#ifndef RS_DOC_VALUES_H_
+#define RS_DOC_VALUES_H_
+
+#include "redisearch.h"
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUMERIC_COLUMN_PAGE_BITS 8
+#define NUMERIC_COLUMN_PAGE_SIZE (1 << NUMERIC_COLUMN_PAGE_BITS)
+#define NUMERIC_COLUMN_PAGE_MASK (NUMERIC_COLUMN_PAGE_SIZE - 1)
+
+/* The values of NUMERIC_COLUMN_PAGE_SIZE consecutive doc ids */
+typedef struct {
+  // Number of documents with a value in the page
+  uint32_t used;
+  double values[NUMERIC_COLUMN_PAGE_SIZE];
+} NumericColumnPage;
+
+/* A column of numeric values indexed by document id. Columns are kept for numeric fields declared
+ * with DOCVALUES, in place of their sorting vector slot, so that sorting by them reads packed
+ * doubles instead of following each document's sorting vector to a separately allocated value.
+ *
+ * Documents without a value hold NaN, which can never be indexed as a numeric value. Pages are
+ * allocated when their first value is set and freed once all their documents are deleted */
+typedef struct NumericColumn {
+  NumericColumnPage **pages;
+  size_t npages;
+  size_t numPages;
+} NumericColumn;
+
+NumericColumn *NewNumericColumn();
+
+/* Set the value of a document, growing the column as needed. Setting NaN clears the value */
+void NumericColumn_Set(NumericColumn *col, t_docId docId, double value);
+
+/* Get the value of a document, or NaN if it has none */
+static inline double NumericColumn_Get(const NumericColumn *col, t_docId docId) {
+  size_t pageIndex = docId >> NUMERIC_COLUMN_PAGE_BITS;
+  if (pageIndex >= col->npages || !col->pages[pageIndex]) {
+    return NAN;
+  }
+  return col->pages[pageIndex]->values[docId & NUMERIC_COLUMN_PAGE_MASK];
+}
+
+size_t NumericColumn_MemUsage(const NumericColumn *col);
+
+void NumericColumn_Free(NumericColumn *col);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
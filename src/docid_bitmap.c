@@ -0,0 +1,188 @@
+#include "docid_bitmap.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+#define BITMAP_WORDS_FOR(id) (((size_t)(id) >> 6) + 1)
+
+DocIdBitmap *NewDocIdBitmap(t_docId maxId) {
+  DocIdBitmap *bm = rm_new(DocIdBitmap);
+  bm->nwords = BITMAP_WORDS_FOR(maxId);
+  bm->words = rm_calloc(bm->nwords, sizeof(*bm->words));
+  bm->numDocs = 0;
+  bm->maxId = 0;
+  bm->refcount = 1;
+  return bm;
+}
+
+int DocIdBitmap_Add(DocIdBitmap *bm, t_docId docId) {
+  size_t w = docId >> 6;
+  if (w >= bm->nwords) {
+    if (bm->refcount > 1) {
+      return 0;
+    }
+    size_t nwords = bm->nwords * 2;
+    if (nwords <= w) {
+      nwords = w + 1;
+    }
+    bm->words = rm_realloc(bm->words, nwords * sizeof(*bm->words));
+    memset(bm->words + bm->nwords, 0, (nwords - bm->nwords) * sizeof(*bm->words));
+    bm->nwords = nwords;
+  }
+
+  uint64_t bit = 1ULL << (docId & 63);
+  if (!(bm->words[w] & bit)) {
+    bm->words[w] |= bit;
+    ++bm->numDocs;
+  }
+  if (docId > bm->maxId) {
+    bm->maxId = docId;
+  }
+  return 1;
+}
+
+t_docId DocIdBitmap_Next(const DocIdBitmap *bm, t_docId docId) {
+  if (docId > bm->maxId) {
+    return 0;
+  }
+  size_t w = docId >> 6;
+  uint64_t word = bm->words[w] & (~0ULL << (docId & 63));
+  while (!word) {
+    if (++w >= bm->nwords) {
+      return 0;
+    }
+    word = bm->words[w];
+  }
+  return ((t_docId)w << 6) + __builtin_ctzll(word);
+}
+
+void DocIdBitmap_Unref(DocIdBitmap *bm) {
+  if (--bm->refcount) {
+    return;
+  }
+  rm_free(bm->words);
+  rm_free(bm);
+}
+
+size_t DocIdBitmap_MemUsage(const DocIdBitmap *bm) {
+  return sizeof(*bm) + bm->nwords * sizeof(*bm->words);
+}
+
+/******************************************************************************
+ * Bitmap iterator
+ ******************************************************************************/
+
+typedef struct {
+  IndexIterator base;
+  DocIdBitmap *bm;
+  t_docId lastDocId;
+} DocIdBitmapIterator;
+
+typedef struct {
+  IndexCriteriaTester base;
+  DocIdBitmap *bm;
+} DocIdBitmapCriteriaTester;
+
+static int DBI_Test(struct IndexCriteriaTester *ct, t_docId id) {
+  return DocIdBitmap_Contains(((DocIdBitmapCriteriaTester *)ct)->bm, id);
+}
+
+static void DBI_TesterFree(struct IndexCriteriaTester *ct) {
+  DocIdBitmap_Unref(((DocIdBitmapCriteriaTester *)ct)->bm);
+  rm_free(ct);
+}
+
+static IndexCriteriaTester *DBI_GetCriteriaTester(void *ctx) {
+  DocIdBitmapIterator *it = ctx;
+  DocIdBitmapCriteriaTester *ct = rm_new(DocIdBitmapCriteriaTester);
+  ct->bm = DocIdBitmap_Ref(it->bm);
+  ct->base.Test = DBI_Test;
+  ct->base.Free = DBI_TesterFree;
+  return &ct->base;
+}
+
+static size_t DBI_NumEstimated(void *ctx) {
+  return ((DocIdBitmapIterator *)ctx)->bm->numDocs;
+}
+
+/* Position the iterator on the first id >= docId. Returns 0 and marks EOF if there is none */
+static inline int DBI_Advance(DocIdBitmapIterator *it, t_docId docId, RSIndexResult **hit) {
+  t_docId next = DocIdBitmap_Next(it->bm, docId);
+  if (!next) {
+    IITER_SET_EOF(&it->base);
+    return 0;
+  }
+  it->lastDocId = next;
+  it->base.current->docId = next;
+  *hit = it->base.current;
+  return 1;
+}
+
+static int DBI_Read(void *ctx, RSIndexResult **hit) {
+  DocIdBitmapIterator *it = ctx;
+  if (!it->base.isValid || !DBI_Advance(it, it->lastDocId + 1, hit)) {
+    return INDEXREAD_EOF;
+  }
+  return INDEXREAD_OK;
+}
+
+static int DBI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
+  DocIdBitmapIterator *it = ctx;
+  if (!docId) {
+    return DBI_Read(ctx, hit);
+  }
+  if (!it->base.isValid || !DBI_Advance(it, docId, hit)) {
+    return INDEXREAD_EOF;
+  }
+  return it->lastDocId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+static t_docId DBI_LastDocId(void *ctx) {
+  return ((DocIdBitmapIterator *)ctx)->lastDocId;
+}
+
+static void DBI_Abort(void *ctx) {
+  IITER_SET_EOF(&((DocIdBitmapIterator *)ctx)->base);
+}
+
+static void DBI_Rewind(void *ctx) {
+  DocIdBitmapIterator *it = ctx;
+  IITER_CLEAR_EOF(&it->base);
+  it->lastDocId = 0;
+  it->base.current->docId = 0;
+}
+
+static void DBI_Free(struct indexIterator *self) {
+  DocIdBitmapIterator *it = self->ctx;
+  IndexResult_Free(it->base.current);
+  DocIdBitmap_Unref(it->bm);
+  rm_free(it);
+}
+
+IndexIterator *NewDocIdBitmapIterator(DocIdBitmap *bm, RSQueryTerm *term, double weight) {
+  DocIdBitmapIterator *it = rm_new(DocIdBitmapIterator);
+  it->bm = DocIdBitmap_Ref(bm);
+  it->lastDocId = 0;
+
+  RSIndexResult *record = NewTokenRecord(term, weight);
+  record->fieldMask = RS_FIELDMASK_ALL;
+  record->freq = 1;
+
+  IndexIterator *ret = &it->base;
+  ret->ctx = it;
+  ret->isValid = 1;
+  ret->current = record;
+  ret->mode = MODE_SORTED;
+  ret->GetCriteriaTester = DBI_GetCriteriaTester;
+  ret->NumEstimated = DBI_NumEstimated;
+  ret->Free = DBI_Free;
+  ret->LastDocId = DBI_LastDocId;
+  ret->Len = DBI_NumEstimated;
+  ret->Read = DBI_Read;
+  ret->SkipTo = DBI_SkipTo;
+  ret->Abort = DBI_Abort;
+  ret->Rewind = DBI_Rewind;
+  ret->HasNext = NULL;
+  ret->GetCurrent = NULL;
+  return ret;
+}
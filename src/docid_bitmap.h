@@ -0,0 +1,62 @@
+#ifndef RS_DOCID_BITMAP_H_
+#define RS_DOCID_BITMAP_H_
+
+#include "redisearch.h"
+#include "index_iterator.h"
+#include "index_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A materialized set of document ids, one bit per id. It is kept alongside inverted indexes that
+ * are dense enough for the bitmap to be smaller than the encoded blocks, and gives iterators O(1)
+ * membership tests instead of block decoding.
+ *
+ * The bitmap is reference counted: the owning index holds one reference and every iterator holds
+ * its own, so a bitmap dropped by the index (e.g. after GC) stays valid for running queries */
+typedef struct DocIdBitmap {
+  uint64_t *words;
+  size_t nwords;
+  // number of bits set
+  size_t numDocs;
+  // the highest id set in the bitmap
+  t_docId maxId;
+  uint32_t refcount;
+} DocIdBitmap;
+
+/* Create an empty bitmap able to hold ids up to maxId without growing */
+DocIdBitmap *NewDocIdBitmap(t_docId maxId);
+
+/* Add a document id to the bitmap. Ids are expected in increasing order, as they are written to
+ * inverted indexes. Growing a bitmap that is shared with iterators would invalidate them, so in
+ * that case nothing is changed and 0 is returned - the caller should drop its reference */
+int DocIdBitmap_Add(DocIdBitmap *bm, t_docId docId);
+
+static inline int DocIdBitmap_Contains(const DocIdBitmap *bm, t_docId docId) {
+  size_t w = docId >> 6;
+  return w < bm->nwords && (bm->words[w] & (1ULL << (docId & 63))) != 0;
+}
+
+/* Return the first id set in the bitmap which is >= docId, or 0 if there is none */
+t_docId DocIdBitmap_Next(const DocIdBitmap *bm, t_docId docId);
+
+static inline DocIdBitmap *DocIdBitmap_Ref(DocIdBitmap *bm) {
+  ++bm->refcount;
+  return bm;
+}
+
+/* Release a reference, freeing the bitmap when it was the last one */
+void DocIdBitmap_Unref(DocIdBitmap *bm);
+
+size_t DocIdBitmap_MemUsage(const DocIdBitmap *bm);
+
+/* Create an iterator over the bitmap. The iterator takes its own reference to the bitmap and
+ * takes ownership of term, yielding term records the same way an IndexReader over a doc-ids-only
+ * index would */
+IndexIterator *NewDocIdBitmapIterator(DocIdBitmap *bm, RSQueryTerm *term, double weight);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
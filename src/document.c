@@ -5,6 +5,8 @@
 #include "forward_index.h"
 #include "numeric_filter.h"
 #include "numeric_index.h"
+#include "numeric_runs.h"
+#include "doc_values.h"
 #include "rmutil/strings.h"
 #include "rmutil/util.h"
 #include "util/mempool.h"
@@ -436,6 +438,15 @@ FIELD_PREPROCESSOR(numericPreprocessor) {
 }
 
 FIELD_BULK_INDEXER(numericIndexer) {
+  if (FieldSpec_HasSortedRuns(fs)) {
+    NumericRuns *runs = IndexSpec_GetNumericRuns(ctx->spec, fs, 1);
+    // Merges triggered by the entry drop deleted documents, so the index may even shrink
+    long added = NumericRuns_Add(runs, aCtx->doc.docId, fdata->numeric, &ctx->spec->docs);
+    ctx->spec->stats.numRecords += added;
+    ctx->spec->stats.invertedSize += added * (long)sizeof(NumericRunEntry);
+    return 0;
+  }
+
   NumericRangeTree *rt = bulk->indexDatas[IXFLDPOS_NUMERIC];
   if (!rt) {
     RedisModuleString *keyName = IndexSpec_GetFormattedKey(ctx->spec, fs, INDEXFLD_T_NUMERIC);
@@ -492,6 +503,22 @@ FIELD_PREPROCESSOR(tagPreprocessor) {
   return 0;
 }
 
+/* Whether the field value is exactly the document's single tag, as aggregations load it */
+static int tagIsFieldValue(const RSAddDocumentCtx *aCtx, const DocumentField *field,
+                           const FieldSpec *fs, char **tags) {
+  if (array_len(tags) != 1 || fs->types != INDEXFLD_T_TAG) {
+    return 0;
+  }
+  size_t len;
+  const char *value;
+  if (FieldSpec_IsSortable(fs)) {
+    value = RSValue_StringPtrLen(aCtx->sv->values[fs->sortIdx], &len);
+  } else {
+    value = RedisModule_StringPtrLen(field->text, &len);
+  }
+  return strlen(tags[0]) == len && !memcmp(tags[0], value, len);
+}
+
 FIELD_BULK_INDEXER(tagIndexer) {
   TagIndex *tidx = bulk->indexDatas[IXFLDPOS_TAG];
   if (!tidx) {
@@ -504,6 +531,9 @@ FIELD_BULK_INDEXER(tagIndexer) {
     }
   }
 
+  if (tidx->valuesAreTags && !tagIsFieldValue(aCtx, field, fs, fdata->tags)) {
+    tidx->valuesAreTags = 0;
+  }
   ctx->spec->stats.invertedSize +=
       TagIndex_Index(tidx, (const char **)fdata->tags, array_len(fdata->tags), aCtx->doc.docId);
   ctx->spec->stats.numRecords++;
@@ -675,6 +705,7 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
 
   // Update the score
   md->score = doc->score;
+  DocTable_UpdateMaxScore(&sctx->spec->docs, md->score);
   // Set the payload if needed
   if (doc->payload) {
     DocTable_SetPayload(&sctx->spec->docs, docId, doc->payload, doc->payloadSize);
@@ -726,6 +757,22 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
     }
   }
 
+  if (sctx->spec->docValues) {
+    // Update NOINDEX doc values in place
+    for (int i = 0; i < doc->numFields; i++) {
+      DocumentField *f = &doc->fields[i];
+      const FieldSpec *fs = IndexSpec_GetField(sctx->spec, f->name, strlen(f->name));
+      if (fs == NULL || !FieldSpec_HasDocValues(fs)) {
+        continue;
+      }
+      double numval;
+      if (RedisModule_StringToDouble(f->text, &numval) == REDISMODULE_ERR) {
+        BAIL("Could not parse numeric index value");
+      }
+      NumericColumn_Set(IndexSpec_GetNumericColumn(sctx->spec, fs->sortIdx), docId, numval);
+    }
+  }
+
 done:
   if (aCtx->donecb) {
     aCtx->donecb(aCtx, sctx->redisCtx, aCtx->donecbData);
@@ -154,6 +154,18 @@ int Document_LoadAllFields(Document *doc, RedisModuleCtx *ctx);
 void Document_LoadPairwiseArgs(Document *doc, RedisModuleString **args, size_t nargs);
 void Document_LoadHSetParams(Document *d, const AddDocumentOptions *opts);
 
+/**
+ * Compute a digest of the document's fields which are indexed by the spec (names and values),
+ * and of its language. The digest does not depend on the order of the fields.
+ */
+uint64_t Document_IndexedFieldsDigest(const Document *doc, const IndexSpec *spec);
+
+/**
+ * Remove the fields which are indexed by the spec from the document, leaving only the fields
+ * which can be updated in place (i.e. NOINDEX sortables)
+ */
+void Document_DropIndexedFields(Document *doc, const IndexSpec *spec);
+
 /**
  * Print contents of document to screen
  */
@@ -3,6 +3,7 @@
 #include "rmalloc.h"
 #include "module.h"
 #include "rmutil/rm_assert.h"
+#include "util/fnv.h"
 
 void Document_Init(Document *doc, RedisModuleString *docKey, double score, RSLanguage lang) {
   doc->docKey = docKey;
@@ -249,6 +250,54 @@ void Document_Clear(Document *d) {
   d->fields = NULL;
 }
 
+static const FieldSpec *getIndexedField(const DocumentField *f, const IndexSpec *spec) {
+  if (!f->text) {
+    return NULL;
+  }
+  const FieldSpec *fs = IndexSpec_GetField(spec, f->name, strlen(f->name));
+  if (!fs || !FieldSpec_IsIndexable(fs)) {
+    return NULL;
+  }
+  return fs;
+}
+
+uint64_t Document_IndexedFieldsDigest(const Document *doc, const IndexSpec *spec) {
+  uint64_t digest = fnv_64a_buf(&doc->language, sizeof(doc->language), 0);
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    const DocumentField *f = doc->fields + ii;
+    const FieldSpec *fs = getIndexedField(f, spec);
+    if (!fs) {
+      continue;
+    }
+    size_t n;
+    const char *val = RedisModule_StringPtrLen(f->text, &n);
+    uint64_t h = fnv_64a_buf(fs->name, strlen(fs->name) + 1, 0);
+    h = fnv_64a_buf(&n, sizeof(n), h);
+    h = fnv_64a_buf(val, n, h);
+    // Summing keeps the digest independent of the order of the fields
+    digest += h;
+  }
+  return digest;
+}
+
+void Document_DropIndexedFields(Document *doc, const IndexSpec *spec) {
+  size_t kept = 0;
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    DocumentField *f = doc->fields + ii;
+    if (!getIndexedField(f, spec)) {
+      doc->fields[kept++] = *f;
+      continue;
+    }
+    if (doc->flags & DOCUMENT_F_OWNSTRINGS) {
+      rm_free((void *)f->name);
+    }
+    if (doc->flags & (DOCUMENT_F_OWNSTRINGS | DOCUMENT_F_OWNREFS)) {
+      RedisModule_FreeString(RSDummyContext, f->text);
+    }
+  }
+  doc->numFields = kept;
+}
+
 void Document_Free(Document *doc) {
   if (doc->flags & DOCUMENT_F_DEAD) {
     return;
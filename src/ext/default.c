@@ -114,6 +114,16 @@ static inline double tfIdfInternal(const ScoringFunctionArgs *ctx, const RSIndex
   return tfidf;
 }
 
+/* The TF-IDF a term adds to a document, before the document score and slop. TF is normalized by the
+ * document's max frequency, so a term adds at most its weighted IDF - unless the max frequency
+ * overflowed the metadata and the normalization can not be trusted */
+static double tfidfTermBound(const RSIndexResult *term, uint32_t maxFreq,
+                             const RSIndexStats *stats) {
+  double idf = term->term.term ? term->term.term->idf : 0;
+  double bound = term->weight * idf;
+  return maxFreq < (1 << 24) ? bound : bound * maxFreq;
+}
+
 /* Calculate sum(TF-IDF)*document score for each result, where TF is normalized by maximum frequency
  * in this document*/
 static double TFIDFScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *h,
@@ -140,8 +150,8 @@ static double TFIDFNormDocLenScorer(const ScoringFunctionArgs *ctx, const RSInde
 /* recursively calculate score for each token, summing up sub tokens */
 static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
                             const RSDocumentMetadata *dmd, RSScoreExplain *scrExp) {
-  static const float b = 0.5;
-  static const float k1 = 1.2;
+  static const float b = BM25_B;
+  static const float k1 = BM25_K1;
   double f = (double)r->freq;
   double ret = 0;
 
@@ -180,6 +190,15 @@ static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult
   return ret;
 }
 
+/* The BM25 a term adds to a document, before the document score and slop. It grows with the
+ * frequency, so the max frequency bounds it */
+static double bm25TermBound(const RSIndexResult *term, uint32_t maxFreq,
+                            const RSIndexStats *stats) {
+  double idf = term->term.term ? term->term.term->idf : 0;
+  double f = (double)maxFreq;
+  return idf * f / (f + BM25_K1 * (1.0f - BM25_B + BM25_B * stats->avgDocLen));
+}
+
 /* BM25 scoring function */
 static double BM25Scorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
                          const RSDocumentMetadata *dmd, double minScore) {
@@ -513,6 +532,16 @@ void DefaultExpanderFree(void *p) {
 }
 
 /* Register the default extension */
+TermScoreBound DefaultScorer_GetTermBound(const char *name) {
+  if (!strcmp(name, DEFAULT_SCORER_NAME)) {
+    return tfidfTermBound;
+  }
+  if (!strcmp(name, BM25_SCORER_NAME)) {
+    return bm25TermBound;
+  }
+  return NULL;
+}
+
 int DefaultExtensionInit(RSExtensionCtx *ctx) {
 
   /* TF-IDF scorer is the default scorer */
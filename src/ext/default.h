@@ -1,6 +1,7 @@
 #ifndef __EXT_DEFAULT_H__
 #define __EXT_DEFAULT_H__
 #include "redisearch.h"
+#include "index.h"
 
 #define PHONETIC_EXPENDER_NAME "PHONETIC"
 #define SYNONYMS_EXPENDER_NAME "SYNONYM"
@@ -13,6 +14,14 @@
 #define DOCSCORE_SCORER "DOCSCORE"
 #define HAMMINGDISTANCE_SCORER "HAMMING"
 
+// BM25 term frequency saturation and document length normalization
+#define BM25_K1 1.2f
+#define BM25_B 0.5f
+
 int DefaultExtensionInit(RSExtensionCtx *ctx);
 
+/* Return the term score bound of a default scorer, or NULL if the scorer has none (see
+ * UI_EnableScorePruning) */
+TermScoreBound DefaultScorer_GetTermBound(const char *name);
+
 #endif
\ No newline at end of file
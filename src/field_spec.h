@@ -46,7 +46,11 @@ typedef enum {
   FieldSpec_NoStemming = 0x02,
   FieldSpec_NotIndexable = 0x04,
   FieldSpec_Phonetics = 0x08,
-  FieldSpec_Dynamic = 0x10
+  FieldSpec_Dynamic = 0x10,
+  FieldSpec_DocValues = 0x20,
+  FieldSpec_SortedRuns = 0x40,
+  // The field was added by FT.ALTER, so documents indexed before it are not in its index
+  FieldSpec_NotReindexed = 0x80
 } FieldSpecOptions;
 
 RS_ENUM_BITWISE_HELPER(FieldSpecOptions)
@@ -69,7 +73,8 @@ typedef struct FieldSpec {
   FieldType types : 8;
   FieldSpecOptions options : 8;
 
-  /** If this field is sortable, the sortable index */
+  /** If this field is sortable, the sortable index. For DOCVALUES fields, the index of their
+   * column in the spec's docValues */
   int16_t sortIdx;
 
   /** Unique field index. Each field has a unique index regardless of its type */
@@ -96,6 +101,9 @@ typedef struct FieldSpec {
 #define FieldSpec_IsSortable(fs) ((fs)->options & FieldSpec_Sortable)
 #define FieldSpec_IsNoStem(fs) ((fs)->options & FieldSpec_NoStemming)
 #define FieldSpec_IsPhonetics(fs) ((fs)->options & FieldSpec_Phonetics)
+#define FieldSpec_HasDocValues(fs) ((fs)->options & FieldSpec_DocValues)
+#define FieldSpec_HasSortedRuns(fs) ((fs)->options & FieldSpec_SortedRuns)
+#define FieldSpec_IsNotReindexed(fs) ((fs)->options & FieldSpec_NotReindexed)
 #define FieldSpec_IsIndexable(fs) (0 == ((fs)->options & FieldSpec_NotIndexable))
 
 void FieldSpec_SetSortable(FieldSpec* fs);
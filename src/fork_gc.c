@@ -5,6 +5,7 @@
 #include "redis_index.h"
 #include "numeric_index.h"
 #include "tag_index.h"
+#include "numeric_runs.h"
 #include "tests/time_sample.h"
 #include <stdlib.h>
 #include <stdbool.h>
@@ -183,6 +184,7 @@ typedef struct {
 
 typedef struct {
   void *ptr;       // Address of the buffer to free
+  void *skips;     // Address of the block's skip table to free, if any
   uint32_t oldix;  // Old index of deleted block
   uint32_t _pad;   // Uninitialized reads, otherwise
 } MSG_DeletedBlock;
@@ -219,6 +221,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     // Capture the pointer address before the block is cleared; otherwise
     // the pointer might be freed!
     void *bufptr = blk->buf.data;
+    void *skipsptr = blk->skips;
     int nrepaired = IndexBlock_Repair(blk, &sctx->spec->docs, idx->flags, params);
     // We couldn't repair the block - return 0
     if (nrepaired == -1) {
@@ -232,7 +235,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     if (blk->numDocs == 0) {
       // this block should be removed
       MSG_DeletedBlock *delmsg = array_ensure_tail(&deleted, MSG_DeletedBlock);
-      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .oldix = i};
+      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .skips = skipsptr, .oldix = i};
     } else {
       blocklist = array_append(blocklist, *blk);
       MSG_RepairedBlock *fixmsg = array_ensure_tail(&fixed, MSG_RepairedBlock);
@@ -415,6 +418,10 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
   FieldSpec **numericFields = getFieldsByType(sctx->spec, INDEXFLD_T_NUMERIC | INDEXFLD_T_GEO);
 
   for (int i = 0; i < array_len(numericFields); ++i) {
+    if (FieldSpec_HasSortedRuns(numericFields[i])) {
+      // Collected by FGC_childCollectRuns
+      continue;
+    }
     RedisModuleString *keyName =
         IndexSpec_GetFormattedKey(sctx->spec, numericFields[i], INDEXFLD_T_NUMERIC);
     NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &idxKey);
@@ -505,6 +512,29 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
   FGC_sendTerminator(gc);
 }
 
+// Sorted runs are compacted once at least this share of their entries are deleted documents.
+// Compacting rewrites every run, so it is amortized over that many deletions
+#define FGC_RUNS_COMPACT_RATIO 8
+
+static void FGC_childCollectRuns(ForkGC *gc, RedisSearchCtx *sctx) {
+  FieldSpec **numericFields = getFieldsByType(sctx->spec, INDEXFLD_T_NUMERIC);
+  for (int i = 0; i < array_len(numericFields); ++i) {
+    NumericRuns *runs = IndexSpec_GetNumericRuns(sctx->spec, numericFields[i], 0);
+    if (!runs) {
+      continue;
+    }
+    size_t ndeleted = NumericRuns_NumDeleted(runs, &sctx->spec->docs);
+    if (!ndeleted || ndeleted * FGC_RUNS_COMPACT_RATIO < runs->numEntries) {
+      continue;
+    }
+    FGC_sendBuffer(gc, numericFields[i]->name, strlen(numericFields[i]->name));
+  }
+  array_free(numericFields);
+
+  // we are done with sorted runs
+  FGC_sendTerminator(gc);
+}
+
 static void FGC_childScanIndexes(ForkGC *gc) {
   RedisSearchCtx *sctx = FGC_getSctx(gc, gc->ctx);
   if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
@@ -515,6 +545,7 @@ static void FGC_childScanIndexes(ForkGC *gc) {
   FGC_childCollectTerms(gc, sctx);
   FGC_childCollectNumeric(gc, sctx);
   FGC_childCollectTags(gc, sctx);
+  FGC_childCollectRuns(gc, sctx);
 
   SearchCtx_Free(sctx);
 }
@@ -540,6 +571,8 @@ FGC_recvRepairedBlock(ForkGC *gc, MSG_RepairedBlock *binfo) {
     return REDISMODULE_ERR;
   }
   b->cap = b->offset;
+  // the skip table was allocated by the child; it is rebuilt when the block is applied
+  binfo->blk.skips = NULL;
   return REDISMODULE_OK;
 }
 
@@ -650,6 +683,9 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
     // Blocks that were deleted entirely:
     MSG_DeletedBlock *delinfo = idxData->delBlocks + i;
     rm_free(delinfo->ptr);
+    if (delinfo->skips) {
+      array_free(delinfo->skips);
+    }
   }
   rm_free(idxData->delBlocks);
 
@@ -704,10 +740,14 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
   for (size_t i = 0; i < info->nblocksRepaired; ++i) {
     MSG_RepairedBlock *blockModified = idxData->changedBlocks + i;
     idx->blocks[blockModified->newix] = blockModified->blk;
+    IndexBlock_UpdateSkips(&idx->blocks[blockModified->newix], idx->flags);
+    // the child's uid is not unique in the parent, and readers must see the block as rewritten
+    IndexBlock_NewUid(&idx->blocks[blockModified->newix]);
   }
 
   idx->numDocs -= info->ndocsCollected;
   idx->gcMarker++;
+  InvertedIndex_DropBitmap(idx);
 }
 
 static FGCError FGC_parentHandleTerms(ForkGC *gc, RedisModuleCtx *rctx) {
@@ -1043,6 +1083,45 @@ static FGCError FGC_parentHandleTags(ForkGC *gc, RedisModuleCtx *rctx) {
   return status;
 }
 
+static FGCError FGC_parentHandleRuns(ForkGC *gc, RedisModuleCtx *rctx) {
+  FGCError status = FGC_COLLECTED;
+  size_t fieldNameLen;
+  char *fieldName = NULL;
+  if (FGC_recvBuffer(gc, (void **)&fieldName, &fieldNameLen) != REDISMODULE_OK) {
+    return FGC_CHILD_ERROR;
+  }
+  if (fieldName == RECV_BUFFER_EMPTY) {
+    return FGC_DONE;
+  }
+
+  if (!FGC_lock(gc, rctx)) {
+    rm_free(fieldName);
+    return FGC_PARENT_ERROR;
+  }
+
+  RedisSearchCtx *sctx = FGC_getSctx(gc, rctx);
+  if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+    status = FGC_PARENT_ERROR;
+    goto cleanup;
+  }
+
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, fieldName, fieldNameLen);
+  NumericRuns *runs = fs ? IndexSpec_GetNumericRuns(sctx->spec, fs, 0) : NULL;
+  if (runs) {
+    // The runs may have changed since the fork, their entries are checked again
+    size_t nremoved = NumericRuns_Compact(runs, &sctx->spec->docs);
+    FGC_updateStats(sctx, gc, nremoved, nremoved * sizeof(NumericRunEntry));
+  }
+
+cleanup:
+  if (sctx) {
+    SearchCtx_Free(sctx);
+  }
+  FGC_unlock(gc, rctx);
+  rm_free(fieldName);
+  return status;
+}
+
 int FGC_parentHandleFromChild(ForkGC *gc) {
   FGCError status = FGC_COLLECTED;
 
@@ -1056,6 +1135,7 @@ int FGC_parentHandleFromChild(ForkGC *gc) {
   COLLECT_FROM_CHILD(FGC_parentHandleTerms(gc, gc->ctx));
   COLLECT_FROM_CHILD(FGC_parentHandleNumeric(gc, gc->ctx));
   COLLECT_FROM_CHILD(FGC_parentHandleTags(gc, gc->ctx));
+  COLLECT_FROM_CHILD(FGC_parentHandleRuns(gc, gc->ctx));
   return REDISMODULE_OK;
 }
 
@@ -1,9 +1,17 @@
 #include "index.h"
 #include "geo_index.h"
+#include "geo_polygon.h"
 #include "rmutil/util.h"
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
 
+// The earth radius used by geohash distances
+#define GEO_EARTH_RADIUS_METERS 6372797.560856
+// Slack added to the bounding box, in degrees, against rounding errors
+#define GEO_BBOX_EPSILON 1e-6
+// Relative slack added to the radius of the circle covering a box
+#define GEO_COVER_SLACK 1e-3
+
 static double extractUnitFactor(GeoDistance unit);
 
 /* Parse a geo filter from redis arguments. We assume the filter args start at argv[0], and FILTER
@@ -52,8 +60,95 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
   return REDISMODULE_OK;
 }
 
+static int parseProperty(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  int rv;
+  if ((rv = AC_GetString(ac, &gf->property, NULL, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<geo property>", rv);
+    return REDISMODULE_ERR;
+  }
+  gf->property = rm_strdup(gf->property);
+  return REDISMODULE_OK;
+}
+
+/* Read a lon/lat pair, making sure it is in range */
+static int parseLonLat(ArgsCursor *ac, double *lonlat, QueryError *status) {
+  int rv;
+  if ((rv = AC_GetDouble(ac, lonlat, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<lon>", rv);
+    return REDISMODULE_ERR;
+  }
+  if ((rv = AC_GetDouble(ac, lonlat + 1, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<lat>", rv);
+    return REDISMODULE_ERR;
+  }
+  if (lonlat[0] < -180 || lonlat[0] > 180 || lonlat[1] < -90 || lonlat[1] > 90) {
+    QERR_MKBADARGS_FMT(status, "Invalid lon/lat %f,%f", lonlat[0], lonlat[1]);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+int GeoFilter_ParseBox(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->shape = GEO_SHAPE_BOX;
+  if (AC_NumRemaining(ac) < 5) {
+    QERR_MKBADARGS_FMT(status, "GEOBOX requires 5 arguments");
+    return REDISMODULE_ERR;
+  }
+  if (parseProperty(gf, ac, status) != REDISMODULE_OK ||
+      parseLonLat(ac, gf->bbox, status) != REDISMODULE_OK ||
+      parseLonLat(ac, gf->bbox + 2, status) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  if (gf->bbox[0] > gf->bbox[2] || gf->bbox[1] > gf->bbox[3]) {
+    QERR_MKBADARGS_FMT(status, "GEOBOX minimum must not be above its maximum");
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+int GeoFilter_ParsePolygon(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->shape = GEO_SHAPE_POLYGON;
+  unsigned long long n;
+  int rv;
+  if (parseProperty(gf, ac, status) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  if ((rv = AC_GetUnsignedLongLong(ac, &n, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<num_vertices>", rv);
+    return REDISMODULE_ERR;
+  }
+  if (n < 3) {
+    QERR_MKBADARGS_FMT(status, "GEOPOLYGON requires at least 3 vertices");
+    return REDISMODULE_ERR;
+  }
+  if (n > GEO_POLYGON_MAX_VERTICES) {
+    QERR_MKBADARGS_FMT(status, "GEOPOLYGON supports at most %d vertices", GEO_POLYGON_MAX_VERTICES);
+    return REDISMODULE_ERR;
+  }
+  // n is checked before it is multiplied, so a huge count can not wrap around
+  if (n > AC_NumRemaining(ac) / 2) {
+    QERR_MKBADARGS_FMT(status, "GEOPOLYGON expects %llu lon/lat pairs", n);
+    return REDISMODULE_ERR;
+  }
+
+  double *lonlat = rm_malloc(2 * n * sizeof(*lonlat));
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (parseLonLat(ac, lonlat + 2 * ii, status) != REDISMODULE_OK) {
+      rm_free(lonlat);
+      return REDISMODULE_ERR;
+    }
+  }
+  gf->polygon = NewGeoPolygon(lonlat, n);
+  memcpy(gf->bbox, gf->polygon->bbox, sizeof(gf->bbox));
+  rm_free(lonlat);
+  return REDISMODULE_OK;
+}
+
 void GeoFilter_Free(GeoFilter *gf) {
   if (gf->property) rm_free((char *)gf->property);
+  if (gf->polygon) {
+    GeoPolygon_Free(gf->polygon);
+  }
   if (gf->numericFilters) {
     for (int i = 0; i < GEO_RANGE_COUNT; ++i) {
       if (gf->numericFilters[i])
@@ -103,40 +198,100 @@ done:
   return docIds;
 }
 
-IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
+static int cmpRanges(const void *p1, const void *p2) {
+  const GeoHashRange *r1 = p1, *r2 = p2;
+  return r1->min < r2->min ? -1 : (r1->min > r2->min ? 1 : 0);
+}
+
+/* Compute the bounding box of the search circle. Points farther than the radius in latitude, or in
+ * longitude at the circle's widest, cannot be within it. When the circle reaches a pole or crosses
+ * the antimeridian, only the latitude is bounded */
+static void setBoundingBox(GeoFilter *gf) {
+  double r = gf->radiusMeters / GEO_EARTH_RADIUS_METERS;
+  double dlat = r * 180 / M_PI + GEO_BBOX_EPSILON;
+  gf->bbox[0] = -180;
+  gf->bbox[1] = gf->lat - dlat;
+  gf->bbox[2] = 180;
+  gf->bbox[3] = gf->lat + dlat;
+
+  double cosLat = cos(gf->lat * M_PI / 180);
+  if (gf->bbox[1] <= -90 || gf->bbox[3] >= 90 || sin(r) >= cosLat) {
+    return;
+  }
+  double dlon = asin(sin(r) / cosLat) * 180 / M_PI + GEO_BBOX_EPSILON;
+  if (gf->lon - dlon <= -180 || gf->lon + dlon >= 180) {
+    return;
+  }
+  gf->bbox[0] = gf->lon - dlon;
+  gf->bbox[2] = gf->lon + dlon;
+}
+
+/* Boxes and polygons are looked up with the cells covering the circle around their bounding box */
+static void coverBoundingBox(const GeoFilter *gf, double *lon, double *lat, double *radius) {
+  // Points can only be indexed within the geohash latitude limits
+  *lon = (gf->bbox[0] + gf->bbox[2]) / 2;
+  *lat = MIN(MAX((gf->bbox[1] + gf->bbox[3]) / 2, GEO_LAT_MIN), GEO_LAT_MAX);
+  *radius = 0;
+  for (size_t ii = 0; ii < 4; ++ii) {
+    double d = geohashGetDistance(*lon, *lat, gf->bbox[ii & 1 ? 2 : 0], gf->bbox[ii & 2 ? 3 : 1]);
+    *radius = MAX(*radius, d);
+  }
+  // A degenerate box still needs a cell around it
+  *radius = MAX(*radius * (1 + GEO_COVER_SLACK), 1);
+}
+
+/* Create the numeric filters of the geohash ranges covering the filter's shape */
+static void createCellFilters(GeoFilter *gf) {
+  double lon = gf->lon, lat = gf->lat, radius;
+  if (gf->shape == GEO_SHAPE_RADIUS) {
+    gf->radiusMeters = gf->radius * extractUnitFactor(gf->unitType);
+    setBoundingBox(gf);
+    radius = gf->radiusMeters;
+  } else {
+    coverBoundingBox(gf, &lon, &lat, &radius);
+  }
+
   GeoHashRange ranges[GEO_RANGE_COUNT] = {0};
-  double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
-  calcRanges(gf->lon, gf->lat, radius_meter, ranges);
+  calcRanges(lon, lat, radius, ranges);
 
-  IndexIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
-  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
-  size_t itersCount = 0;
+  // Neighboring cells are often adjacent on the curve, and with huge radii some of them are the
+  // same cell. Merge them so that each part of the tree is looked up once
+  size_t nranges = 0;
   for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
     if (ranges[ii].min != ranges[ii].max) {
-      NumericFilter *filt = gf->numericFilters[ii] =
-              NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1);
-      filt->fieldName = rm_strdup(gf->property);
-      filt->geoFilter = gf;
-      struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO);
-      if (numIter != NULL) {
-        iters[itersCount++] = numIter;
-      }
+      ranges[nranges++] = ranges[ii];
     }
   }
+  qsort(ranges, nranges, sizeof(*ranges), cmpRanges);
+  size_t nmerged = 0;
+  for (size_t ii = 0; ii < nranges; ++ii) {
+    if (nmerged && ranges[ii].min <= ranges[nmerged - 1].max) {
+      ranges[nmerged - 1].max = MAX(ranges[nmerged - 1].max, ranges[ii].max);
+    } else {
+      ranges[nmerged++] = ranges[ii];
+    }
+  }
+
+  gf->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
+  for (size_t ii = 0; ii < nmerged; ++ii) {
+    NumericFilter *filt = gf->numericFilters[ii] =
+        NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1);
+    filt->fieldName = rm_strdup(gf->property);
+    filt->geoFilter = gf;
+  }
+}
 
-  if (itersCount == 0) {
-    rm_free(iters);
-    return NULL;
-  } else if (itersCount == 1) {
-    IndexIterator *it = iters[0];
-    rm_free(iters);
-    return it;
+IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
+  // The filters are kept by the readers, so they are created once and shared by every iterator
+  // evaluated from the query
+  if (!gf->numericFilters) {
+    createCellFilters((GeoFilter *)gf);
   }
-  IndexIterator *it = NewUnionIterator(iters, itersCount, NULL, 1, 1);
-  if (!it) {
-    return NULL;
+  size_t n = 0;
+  while (n < GEO_RANGE_COUNT && gf->numericFilters[n]) {
+    ++n;
   }
-  return it;
+  return n ? NewGeoCellsIterator(ctx, gf->numericFilters, n) : NULL;
 }
 
 GeoDistance GeoDistance_Parse(const char *s) {
@@ -257,9 +412,29 @@ static int populateRange(const GeoFilter *gf, GeoHashRange *ranges) {
 int isWithinRadius(const GeoFilter *gf, double d, double *distance) {
   double xy[2];
   decodeGeo(d, xy);
-  double radius_meters = gf->radius * extractUnitFactor(gf->unitType);
-  int rv = isWithinRadiusLonLat(gf->lon, gf->lat, xy[0], xy[1], radius_meters, distance);
-  return rv;
+  if (xy[0] < gf->bbox[0] || xy[0] > gf->bbox[2] || xy[1] < gf->bbox[1] || xy[1] > gf->bbox[3]) {
+    return 0;
+  }
+  return isWithinRadiusLonLat(gf->lon, gf->lat, xy[0], xy[1], gf->radiusMeters, distance);
+}
+
+int GeoFilter_Match(const GeoFilter *gf, double d) {
+  if (gf->shape == GEO_SHAPE_RADIUS) {
+    return isWithinRadius(gf, d, NULL);
+  }
+  double xy[2];
+  decodeGeo(d, xy);
+  if (gf->shape == GEO_SHAPE_POLYGON) {
+    return GeoPolygon_Contains(gf->polygon, xy[0], xy[1]);
+  }
+  return xy[0] >= gf->bbox[0] && xy[0] <= gf->bbox[2] && xy[1] >= gf->bbox[1] &&
+         xy[1] <= gf->bbox[3];
+}
+
+double GeoFilter_Distance(const GeoFilter *gf, double d) {
+  double xy[2];
+  decodeGeo(d, xy);
+  return geohashGetDistance(gf->lon, gf->lat, xy[0], xy[1]) / extractUnitFactor(gf->unitType);
 }
 
 static int checkResult(const GeoFilter *gf, const RSIndexResult *cur) {
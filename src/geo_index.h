@@ -17,6 +17,10 @@ typedef struct geoIndex {
 
 #define GEOINDEX_KEY_FMT "geo:%s/%s"
 
+/* The property holding the distance of each result from the center of the query's geo filter. It
+ * is hidden from the output unless returned explicitly */
+#define GEO_DISTANCE_PROPERTY "__distance"
+
 typedef enum {  // Placeholder for bad/invalid unit
   GEO_DISTANCE_INVALID = -1,
 #define X_GEO_DISTANCE(X) \
@@ -30,13 +34,35 @@ typedef enum {  // Placeholder for bad/invalid unit
 #undef X
 } GeoDistance;
 
+typedef enum {
+  // Within a radius of lon/lat
+  GEO_SHAPE_RADIUS,
+  // Within a lon/lat box (GEOBOX)
+  GEO_SHAPE_BOX,
+  // Within a polygon (GEOPOLYGON)
+  GEO_SHAPE_POLYGON,
+} GeoShape;
+
+struct GeoPolygon;
+
+// Largest number of vertices a GEOPOLYGON filter may have
+#define GEO_POLYGON_MAX_VERTICES 4096
+
 typedef struct GeoFilter {
   const char *property;
+  GeoShape shape;
   double lat;
   double lon;
   double radius;
   GeoDistance unitType;
   NumericFilter **numericFilters;
+  // The radius in meters, and the bounding box of the search circle in degrees (min lon, min lat,
+  // max lon, max lat). Both are set when the filter's iterator is created, so that records outside
+  // of the box are rejected without computing their distance
+  double radiusMeters;
+  double bbox[4];
+  // The polygon of GEO_SHAPE_POLYGON filters. Boxes are matched against bbox alone
+  struct GeoPolygon *polygon;
 } GeoFilter;
 
 /* Create a geo filter from parsed strings and numbers */
@@ -51,6 +77,12 @@ int GeoFilter_Validate(GeoFilter *f, QueryError *status);
 
 /* Parse a geo filter from redis arguments. We assume the filter args start at argv[0] */
 int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
+
+/* Parse a GEOBOX filter: <property> MIN_LON MIN_LAT MAX_LON MAX_LAT */
+int GeoFilter_ParseBox(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
+
+/* Parse a GEOPOLYGON filter: <property> NUM_VERTICES LON LAT ... */
+int GeoFilter_ParsePolygon(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
 void GeoFilter_Free(GeoFilter *gf);
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf);
 
@@ -60,4 +92,10 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf);
 double calcGeoHash(double lon, double lat);
 int isWithinRadius(const GeoFilter *gf, double d, double *distance);
 
+/* Checks if the geohash encoded point d matches the filter, whatever its shape */
+int GeoFilter_Match(const GeoFilter *gf, double d);
+
+/* The distance of a geohash encoded point from the center of the filter, in the filter's unit */
+double GeoFilter_Distance(const GeoFilter *gf, double d);
+
 #endif
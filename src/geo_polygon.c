@@ -0,0 +1,104 @@
+#include "geo_polygon.h"
+#include "rmalloc.h"
+
+#include <math.h>
+#include <string.h>
+
+// Aim for this many edges per band, up to GEO_POLYGON_MAX_BANDS bands
+#define GEO_POLYGON_EDGES_PER_BAND 4
+#define GEO_POLYGON_MAX_BANDS 1024
+
+static inline size_t bandOf(const GeoPolygon *poly, double lat) {
+  double b = floor((lat - poly->bbox[1]) / poly->bandHeight);
+  if (b < 0) {
+    return 0;
+  }
+  return b >= poly->nbands ? poly->nbands - 1 : (size_t)b;
+}
+
+GeoPolygon *NewGeoPolygon(const double *lonlat, size_t n) {
+  GeoPolygon *poly = rm_calloc(1, sizeof(*poly));
+  poly->bbox[0] = poly->bbox[2] = lonlat[0];
+  poly->bbox[1] = poly->bbox[3] = lonlat[1];
+  for (size_t ii = 1; ii < n; ++ii) {
+    poly->bbox[0] = fmin(poly->bbox[0], lonlat[2 * ii]);
+    poly->bbox[1] = fmin(poly->bbox[1], lonlat[2 * ii + 1]);
+    poly->bbox[2] = fmax(poly->bbox[2], lonlat[2 * ii]);
+    poly->bbox[3] = fmax(poly->bbox[3], lonlat[2 * ii + 1]);
+  }
+
+  poly->nbands = n / GEO_POLYGON_EDGES_PER_BAND;
+  if (poly->nbands > GEO_POLYGON_MAX_BANDS) {
+    poly->nbands = GEO_POLYGON_MAX_BANDS;
+  }
+  if (!poly->nbands || poly->bbox[3] == poly->bbox[1]) {
+    poly->nbands = 1;
+  }
+  poly->bandHeight =
+      poly->bbox[3] > poly->bbox[1] ? (poly->bbox[3] - poly->bbox[1]) / poly->nbands : 1;
+
+  // Count the edges of every band, then lay them out band after band. Horizontal edges are
+  // dropped, they can never be crossed
+  poly->bandStart = rm_calloc(poly->nbands + 1, sizeof(*poly->bandStart));
+  size_t total = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    double ya = lonlat[2 * ii + 1], yb = lonlat[2 * ((ii + 1) % n) + 1];
+    if (ya == yb) {
+      continue;
+    }
+    size_t b0 = bandOf(poly, fmin(ya, yb)), b1 = bandOf(poly, fmax(ya, yb));
+    for (size_t b = b0; b <= b1; ++b) {
+      poly->bandStart[b + 1]++;
+    }
+    total += b1 - b0 + 1;
+  }
+  for (size_t b = 0; b < poly->nbands; ++b) {
+    poly->bandStart[b + 1] += poly->bandStart[b];
+  }
+
+  double *edges = rm_malloc((total ? total : 1) * 4 * sizeof(*edges));
+  poly->x1 = edges;
+  poly->y1 = edges + total;
+  poly->y2 = edges + 2 * total;
+  poly->slope = edges + 3 * total;
+
+  uint32_t *fill = rm_malloc(poly->nbands * sizeof(*fill));
+  memcpy(fill, poly->bandStart, poly->nbands * sizeof(*fill));
+  for (size_t ii = 0; ii < n; ++ii) {
+    double xa = lonlat[2 * ii], ya = lonlat[2 * ii + 1];
+    double xb = lonlat[2 * ((ii + 1) % n)], yb = lonlat[2 * ((ii + 1) % n) + 1];
+    if (ya == yb) {
+      continue;
+    }
+    size_t b0 = bandOf(poly, fmin(ya, yb)), b1 = bandOf(poly, fmax(ya, yb));
+    for (size_t b = b0; b <= b1; ++b) {
+      uint32_t e = fill[b]++;
+      poly->x1[e] = xa;
+      poly->y1[e] = ya;
+      poly->y2[e] = yb;
+      poly->slope[e] = (xb - xa) / (yb - ya);
+    }
+  }
+  rm_free(fill);
+  return poly;
+}
+
+int GeoPolygon_Contains(const GeoPolygon *poly, double lon, double lat) {
+  if (lon < poly->bbox[0] || lon > poly->bbox[2] || lat < poly->bbox[1] || lat > poly->bbox[3]) {
+    return 0;
+  }
+  size_t b = bandOf(poly, lat);
+  const double *x1 = poly->x1, *y1 = poly->y1, *y2 = poly->y2, *slope = poly->slope;
+  int inside = 0;
+  // Count the edges crossed by a ray going east from the point
+  for (uint32_t e = poly->bandStart[b]; e < poly->bandStart[b + 1]; ++e) {
+    inside ^= ((y1[e] > lat) != (y2[e] > lat)) & (lon < x1[e] + (lat - y1[e]) * slope[e]);
+  }
+  return inside;
+}
+
+void GeoPolygon_Free(GeoPolygon *poly) {
+  rm_free(poly->x1);
+  rm_free(poly->bandStart);
+  rm_free(poly);
+}
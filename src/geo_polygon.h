@@ -0,0 +1,42 @@
+#ifndef RS_GEO_POLYGON_H_
+#define RS_GEO_POLYGON_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A polygon of lon/lat vertices, prepared for point-in-polygon tests. Edges are straight lines in
+ * lon/lat coordinates, and the polygon may not cross the antimeridian.
+ *
+ * The edges are bucketed by the latitude bands they span, so a test only looks at the edges of the
+ * point's band - a handful even for polygons with thousands of vertices. Each band keeps its edges
+ * as contiguous arrays and the crossing test is branch free, so the loop over them vectorizes */
+typedef struct GeoPolygon {
+  // min lon, min lat, max lon, max lat
+  double bbox[4];
+  size_t nbands;
+  double bandHeight;
+  // The edges of band i are [bandStart[i], bandStart[i + 1]) in the edge arrays
+  uint32_t *bandStart;
+  // An edge crosses latitude y at longitude x1 + (y - y1) * slope, if y is between y1 and y2
+  double *x1;
+  double *y1;
+  double *y2;
+  double *slope;
+} GeoPolygon;
+
+/* Create a polygon from n lon/lat pairs. The last vertex is connected to the first */
+GeoPolygon *NewGeoPolygon(const double *lonlat, size_t n);
+
+/* Return 1 if the point is inside the polygon, 0 otherwise */
+int GeoPolygon_Contains(const GeoPolygon *poly, double lon, double lat);
+
+void GeoPolygon_Free(GeoPolygon *poly);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
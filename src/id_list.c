@@ -156,16 +156,11 @@ void IL_Rewind(void *p) {
   il->offset = 0;
 }
 
-IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
-
-  // first sort the ids, so the caller will not have to deal with it
-  qsort(ids, (size_t)num, sizeof(t_docId), cmp_docids);
-
+IndexIterator *NewSortedIdListIterator(t_docId *ids, t_offset num, double weight) {
   IdListIterator *it = rm_new(IdListIterator);
 
   it->size = num;
-  it->docIds = rm_calloc(num, sizeof(t_docId));
-  if (num > 0) memcpy(it->docIds, ids, num * sizeof(t_docId));
+  it->docIds = ids;
   setEof(it, 0);
   it->lastDocId = 0;
   it->base.current = NewVirtualResult(weight);
@@ -190,3 +185,13 @@ IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
   ret->GetCurrent = NULL;
   return ret;
 }
+
+IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
+
+  // first sort the ids, so the caller will not have to deal with it
+  qsort(ids, (size_t)num, sizeof(t_docId), cmp_docids);
+
+  t_docId *copy = rm_calloc(num, sizeof(t_docId));
+  if (num > 0) memcpy(copy, ids, num * sizeof(t_docId));
+  return NewSortedIdListIterator(copy, num, weight);
+}
@@ -1,5 +1,6 @@
 #include "forward_index.h"
 #include "index.h"
+#include "inverted_index.h"
 #include "varint.h"
 #include "spec.h"
 #include <math.h>
@@ -9,6 +10,7 @@
 #include <sys/param.h>
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
+#include "util/heap.h"
 
 static int UI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit);
 static inline int UI_ReadUnsorted(void *ctx, RSIndexResult **hit);
@@ -16,6 +18,9 @@ static int UI_ReadSorted(void *ctx, RSIndexResult **hit);
 static size_t UI_NumEstimated(void *ctx);
 static IndexCriteriaTester *UI_GetCriteriaTester(void *ctx);
 static size_t UI_Len(void *ctx);
+static int UI_ReadSortedHeap(void *ctx, RSIndexResult **hit);
+static int UI_SkipToHeap(void *ctx, t_docId docId, RSIndexResult **hit);
+static int UI_ReadPruned(void *ctx, RSIndexResult **hit);
 
 static int II_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit);
 static int II_ReadUnsorted(void *ctx, RSIndexResult **hit);
@@ -27,6 +32,26 @@ static t_docId II_LastDocId(void *ctx);
 
 #define CURRENT_RECORD(ii) (ii)->base.current
 
+// Relative slack for the score bounds of pruning unions, against rounding errors
+#define UNION_PRUNE_SLACK 1e-9
+
+typedef struct {
+  IndexIterator *it;
+  // position in the original iterator list, so that children on the same id are merged in the
+  // same order as the linear iteration does
+  uint32_t pos;
+} UnionHeapEntry;
+
+/* A child of a union which skips documents by score */
+typedef struct {
+  IndexIterator *it;
+  // The most the child's records can add to the score of a document
+  double bound;
+  // Set if the child reads a term, so its bounds can be narrowed down by block
+  int isTerm;
+  int eof;
+} UnionPruneChild;
+
 typedef struct {
   IndexIterator base;
   /**
@@ -48,6 +73,27 @@ typedef struct {
   size_t nexpected;
   double weight;
   uint64_t len;
+
+  /**
+   * Unions with many children (see minUnionIterHeap) keep the active children in a heap, ordered
+   * by their current id. Children which were taken off the heap to build the current result are
+   * kept in `pending` until the next read or skip moves them forward.
+   */
+  heap_t *heap;
+  UnionHeapEntry *heapEntries;
+  UnionHeapEntry **pending;
+  uint32_t npending;
+
+  /**
+   * Unions which skip documents by score (see UI_EnableScorePruning) keep their children in
+   * `prune`, in their original order, and `pruneOrder` lists them by increasing bound.
+   */
+  UnionPruneChild *prune;
+  uint32_t *pruneOrder;
+  const double *minScore;
+  TermScoreBound termBound;
+  RSIndexStats stats;
+  double pruneScale;
 } UnionIterator;
 
 static inline t_docId UI_LastDocId(void *ctx) {
@@ -89,6 +135,24 @@ static void UI_Abort(void *ctx) {
   }
 }
 
+static int UI_CmpHeapEntries(const void *p1, const void *p2, const void *udata) {
+  const UnionHeapEntry *e1 = p1, *e2 = p2;
+  if (e1->it->minId != e2->it->minId) {
+    return e1->it->minId < e2->it->minId ? 1 : -1;
+  }
+  return e1->pos < e2->pos ? 1 : (e1->pos > e2->pos ? -1 : 0);
+}
+
+/* Reset the heap. All the children are pending, so the next read positions them */
+static void UI_HeapInit(UnionIterator *ui) {
+  heap_init(ui->heap, UI_CmpHeapEntries, NULL, ui->norig);
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    ui->heapEntries[i] = (UnionHeapEntry){.it = ui->origits[i], .pos = i};
+    ui->pending[i] = ui->heapEntries + i;
+  }
+  ui->npending = ui->norig;
+}
+
 static void UI_Rewind(void *ctx) {
   UnionIterator *ui = ctx;
   IITER_CLEAR_EOF(&ui->base);
@@ -102,6 +166,12 @@ static void UI_Rewind(void *ctx) {
     ui->its[i]->minId = 0;
     ui->its[i]->Rewind(ui->its[i]->ctx);
   }
+  if (ui->heap) {
+    UI_HeapInit(ui);
+  }
+  for (size_t i = 0; ui->prune && i < ui->norig; i++) {
+    ui->prune[i].eof = 0;
+  }
 }
 
 IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *dt, int quickExit,
@@ -165,6 +235,15 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *dt, int
     }
   }
 
+  if (it->mode == MODE_SORTED && ctx->norig >= RSGlobalConfig.minUnionIterHeap) {
+    ctx->heap = rm_malloc(heap_sizeof(ctx->norig));
+    ctx->heapEntries = rm_malloc(ctx->norig * sizeof(*ctx->heapEntries));
+    ctx->pending = rm_malloc(ctx->norig * sizeof(*ctx->pending));
+    UI_HeapInit(ctx);
+    it->Read = UI_ReadSortedHeap;
+    it->SkipTo = UI_SkipToHeap;
+  }
+
   return it;
 }
 
@@ -406,6 +485,297 @@ static int UI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   return INDEXREAD_NOTFOUND;
 }
 
+/**
+ * Move a child which is behind docId forward, and put it back on the heap unless it is exhausted.
+ * When seeking we use the child's SkipTo, otherwise we read until we pass the union's last id,
+ * like UI_ReadSorted does.
+ */
+static void UI_HeapAdvanceChild(UnionIterator *ui, UnionHeapEntry *e, t_docId docId, int seek) {
+  IndexIterator *it = e->it;
+  RSIndexResult *res = NULL;
+  int rc = INDEXREAD_OK;
+  if (seek) {
+    if (it->minId < docId) {
+      rc = it->SkipTo(it->ctx, docId, &res);
+      if (rc != INDEXREAD_EOF && res) {
+        it->minId = res->docId;
+      }
+    }
+  } else {
+    while (it->minId < docId && rc != INDEXREAD_EOF) {
+      rc = INDEXREAD_NOTFOUND;
+      // read while we're not at the end and perhaps the flags do not match
+      while (rc == INDEXREAD_NOTFOUND) {
+        rc = it->Read(it->ctx, &res);
+        if (res) {
+          it->minId = res->docId;
+        }
+      }
+    }
+  }
+  if (rc != INDEXREAD_EOF) {
+    heap_offerx(ui->heap, e);
+  }
+}
+
+/* Move all the children which are behind docId forward */
+static void UI_HeapAdvance(UnionIterator *ui, t_docId docId, int seek) {
+  for (uint32_t i = 0; i < ui->npending; ++i) {
+    UI_HeapAdvanceChild(ui, ui->pending[i], docId, seek);
+  }
+  ui->npending = 0;
+
+  UnionHeapEntry *e;
+  while ((e = heap_peek(ui->heap)) && e->it->minId < docId) {
+    heap_poll(ui->heap);
+    UI_HeapAdvanceChild(ui, e, docId, seek);
+  }
+}
+
+/**
+ * Take the children positioned on the minimal id off the heap, and put their records into the
+ * aggregate. Only the first one is taken if `all` is not set
+ */
+static void UI_HeapCollect(UnionIterator *ui, int all) {
+  AggregateResult_Reset(CURRENT_RECORD(ui));
+  CURRENT_RECORD(ui)->weight = ui->weight;
+
+  UnionHeapEntry *e = heap_poll(ui->heap);
+  t_docId docId = e->it->minId;
+  while (1) {
+    AggregateResult_AddChild(CURRENT_RECORD(ui), IITER_CURRENT_RECORD(e->it));
+    ui->pending[ui->npending++] = e;
+    if (!all || !(e = heap_peek(ui->heap)) || e->it->minId != docId) {
+      break;
+    }
+    heap_poll(ui->heap);
+  }
+  ui->minDocId = docId;
+}
+
+static int UI_ReadSortedHeap(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+
+  UI_HeapAdvance(ui, ui->minDocId + 1, 0);
+  if (!heap_count(ui->heap)) {
+    IITER_SET_EOF(&ui->base);
+    return INDEXREAD_EOF;
+  }
+
+  UI_HeapCollect(ui, !ui->quickExit);
+  ui->len++;
+  *hit = CURRENT_RECORD(ui);
+  return INDEXREAD_OK;
+}
+
+static int UI_SkipToHeap(void *ctx, t_docId docId, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (docId == 0) {
+    return UI_ReadSortedHeap(ctx, hit);
+  }
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+
+  UI_HeapAdvance(ui, docId, 1);
+  UnionHeapEntry *top = heap_peek(ui->heap);
+  if (!top) {
+    IITER_SET_EOF(&ui->base);
+    return INDEXREAD_EOF;
+  }
+
+  if (top->it->minId == docId) {
+    UI_HeapCollect(ui, !ui->quickExit);
+    *hit = CURRENT_RECORD(ui);
+    return INDEXREAD_OK;
+  }
+
+  // not found - return the first record after docId, like UI_SkipTo does
+  UI_HeapCollect(ui, 0);
+  *hit = IITER_CURRENT_RECORD(top->it);
+  return INDEXREAD_NOTFOUND;
+}
+
+/* The most a child can add to the score of a document, or a negative value if it can't be bounded */
+static double UI_ChildScoreBound(IndexIterator *it, TermScoreBound bound,
+                                 const RSIndexStats *stats) {
+  if (it->Read == IR_Read) {
+    const RSIndexResult *rec = IITER_CURRENT_RECORD(it);
+    if (rec->type != RSResultType_Term || !rec->term.term) {
+      return -1;
+    }
+    uint32_t maxFreq = IR_MaxFreq(it->ctx, 0);
+    return maxFreq ? bound(rec, maxFreq, stats) : 0;
+  }
+  if (it->Free == UnionIterator_Free) {
+    const UnionIterator *ui = it->ctx;
+    double sum = 0;
+    for (uint32_t i = 0; i < ui->norig; i++) {
+      double b = UI_ChildScoreBound(ui->origits[i], bound, stats);
+      if (b < 0) {
+        return -1;
+      }
+      sum += b;
+    }
+    return ui->weight * sum;
+  }
+  return -1;
+}
+
+int UI_EnableScorePruning(IndexIterator *it, const double *minScore, TermScoreBound bound,
+                          const RSIndexStats *stats, double scale) {
+  if (!it || it->Free != UnionIterator_Free) {
+    return 0;
+  }
+  UnionIterator *ui = it->ctx;
+  if (it->Read != UI_ReadSorted || ui->quickExit || !ui->norig || ui->prune ||
+      !(scale * ui->weight > 0)) {
+    return 0;
+  }
+
+  UnionPruneChild *children = rm_calloc(ui->norig, sizeof(*children));
+  for (uint32_t i = 0; i < ui->norig; i++) {
+    children[i].it = ui->origits[i];
+    children[i].isTerm = ui->origits[i]->Read == IR_Read;
+    children[i].bound = UI_ChildScoreBound(ui->origits[i], bound, stats);
+    if (!(children[i].bound >= 0)) {
+      rm_free(children);
+      return 0;
+    }
+  }
+
+  // Unions are small, so a simple insertion sort will do
+  uint32_t *order = rm_malloc(ui->norig * sizeof(*order));
+  for (uint32_t i = 0; i < ui->norig; i++) {
+    uint32_t j = i;
+    for (; j > 0 && children[order[j - 1]].bound > children[i].bound; j--) {
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
+  }
+
+  ui->prune = children;
+  ui->pruneOrder = order;
+  ui->minScore = minScore;
+  ui->termBound = bound;
+  ui->stats = *stats;
+  ui->pruneScale = scale * ui->weight;
+  it->Read = UI_ReadPruned;
+  return 1;
+}
+
+/* Move a pruning union's child to docId, seeking or reading like UI_HeapAdvanceChild */
+static void UI_PruneAdvance(UnionPruneChild *c, t_docId docId, int seek) {
+  IndexIterator *it = c->it;
+  RSIndexResult *res = NULL;
+  int rc = INDEXREAD_OK;
+  if (seek) {
+    rc = it->SkipTo(it->ctx, docId, &res);
+    if (rc != INDEXREAD_EOF && res) {
+      it->minId = res->docId;
+    }
+  } else {
+    while (it->minId < docId && rc != INDEXREAD_EOF) {
+      rc = INDEXREAD_NOTFOUND;
+      while (rc == INDEXREAD_NOTFOUND) {
+        rc = it->Read(it->ctx, &res);
+        if (res) {
+          it->minId = res->docId;
+        }
+      }
+    }
+  }
+  if (rc == INDEXREAD_EOF) {
+    c->eof = 1;
+  }
+}
+
+/* The most a child can add to the score of docId, given where it is positioned */
+static double UI_PruneChildBound(const UnionIterator *ui, const UnionPruneChild *c,
+                                 t_docId docId) {
+  if (c->eof || c->it->minId > docId) {
+    // the child is past docId, so it does not have it
+    return 0;
+  }
+  if (!c->isTerm) {
+    return c->bound;
+  }
+  const RSIndexResult *rec = IITER_CURRENT_RECORD(c->it);
+  if (c->it->minId == docId) {
+    return ui->termBound(rec, rec->freq, &ui->stats);
+  }
+  uint32_t maxFreq = IR_MaxFreq(c->it->ctx, docId);
+  return maxFreq ? ui->termBound(rec, maxFreq, &ui->stats) : 0;
+}
+
+static int UI_ReadPruned(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  double threshold = *ui->minScore;
+  // Until the sorter is full, every document may make it
+  if (threshold <= 0) {
+    return UI_ReadSorted(ctx, hit);
+  }
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+
+  // The children with the lowest bounds, which together can not reach the threshold, are not
+  // essential: documents are only taken from the other children, and looked up in these
+  double limit = threshold / (ui->pruneScale * (1 + UNION_PRUNE_SLACK));
+  uint32_t nonEssential = 0;
+  double sum = 0;
+  while (nonEssential < ui->norig && sum + ui->prune[ui->pruneOrder[nonEssential]].bound < limit) {
+    sum += ui->prune[ui->pruneOrder[nonEssential++]].bound;
+  }
+
+  t_docId lastId = ui->minDocId;
+  while (1) {
+    t_docId candidate = 0;
+    for (uint32_t j = nonEssential; j < ui->norig; j++) {
+      UnionPruneChild *c = ui->prune + ui->pruneOrder[j];
+      if (!c->eof && c->it->minId <= lastId) {
+        UI_PruneAdvance(c, lastId + 1, 0);
+      }
+      if (!c->eof && (!candidate || c->it->minId < candidate)) {
+        candidate = c->it->minId;
+      }
+    }
+    if (!candidate) {
+      IITER_SET_EOF(&ui->base);
+      return INDEXREAD_EOF;
+    }
+
+    // Check the candidate against the bounds of the blocks holding it before collecting it
+    double bound = 0;
+    for (uint32_t i = 0; i < ui->norig; i++) {
+      bound += UI_PruneChildBound(ui, ui->prune + i, candidate);
+    }
+    if (bound < limit) {
+      lastId = candidate;
+      continue;
+    }
+
+    AggregateResult_Reset(CURRENT_RECORD(ui));
+    CURRENT_RECORD(ui)->weight = ui->weight;
+    for (uint32_t i = 0; i < ui->norig; i++) {
+      UnionPruneChild *c = ui->prune + i;
+      if (!c->eof && c->it->minId < candidate) {
+        UI_PruneAdvance(c, candidate, 1);
+      }
+      if (!c->eof && c->it->minId == candidate) {
+        AggregateResult_AddChild(CURRENT_RECORD(ui), IITER_CURRENT_RECORD(c->it));
+      }
+    }
+    ui->minDocId = candidate;
+    ui->len++;
+    *hit = CURRENT_RECORD(ui);
+    return INDEXREAD_OK;
+  }
+}
+
 void UnionIterator_Free(IndexIterator *itbase) {
   if (itbase == NULL) return;
 
@@ -420,6 +790,11 @@ void UnionIterator_Free(IndexIterator *itbase) {
   IndexResult_Free(CURRENT_RECORD(ui));
   rm_free(ui->its);
   rm_free(ui->origits);
+  rm_free(ui->heap);
+  rm_free(ui->heapEntries);
+  rm_free(ui->pending);
+  rm_free(ui->prune);
+  rm_free(ui->pruneOrder);
   rm_free(ui);
 }
 
@@ -435,6 +810,11 @@ typedef struct {
   IndexIterator *bestIt;
   IndexCriteriaTester **testers;
   t_docId *docIds;
+  // the records the children are currently positioned on
+  RSIndexResult **hits;
+  // the order in which the children are advanced. Starts with the rarest child first, and
+  // children that reject candidates are moved towards the front as we go
+  uint32_t *order;
   int *rcs;
   unsigned num;
   size_t len;
@@ -472,6 +852,8 @@ void IntersectIterator_Free(IndexIterator *it) {
   }
 
   rm_free(ui->docIds);
+  rm_free(ui->hits);
+  rm_free(ui->order);
   rm_free(ui->its);
   IndexResult_Free(it->current);
   array_free(ui->testers);
@@ -572,6 +954,24 @@ static void II_SortChildren(IntersectIterator *ctx) {
   array_free(unsortedIts);
 }
 
+/* Order the children by their estimated number of results, so that the rarest one drives the
+ * intersection */
+static void II_RankChildren(IntersectIterator *ctx) {
+  ctx->order = rm_malloc(sizeof(*ctx->order) * ctx->num);
+  ctx->hits = rm_calloc(ctx->num, sizeof(*ctx->hits));
+  size_t *estimates = rm_malloc(sizeof(*estimates) * ctx->num);
+  for (uint32_t i = 0; i < ctx->num; ++i) {
+    IndexIterator *it = ctx->its[i];
+    estimates[i] = it ? IITER_NUM_ESTIMATED(it) : 0;
+    uint32_t j = i;
+    for (; j > 0 && estimates[ctx->order[j - 1]] > estimates[i]; --j) {
+      ctx->order[j] = ctx->order[j - 1];
+    }
+    ctx->order[j] = i;
+  }
+  rm_free(estimates);
+}
+
 IndexIterator *NewIntersecIterator(IndexIterator **its_, size_t num, DocTable *dt,
                                    t_fieldMask fieldMask, int maxSlop, int inOrder, double weight) {
   // printf("Creating new intersection iterator with fieldMask=%llx\n", fieldMask);
@@ -608,6 +1008,7 @@ IndexIterator *NewIntersecIterator(IndexIterator **its_, size_t num, DocTable *d
   it->HasNext = NULL;
   it->mode = MODE_SORTED;
   II_SortChildren(ctx);
+  II_RankChildren(ctx);
   return it;
 }
 
@@ -764,13 +1165,12 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
   if (ic->num == 0) return INDEXREAD_EOF;
 
   int nh = 0;
-  int i = 0;
 
   do {
     nh = 0;
-    AggregateResult_Reset(ic->base.current);
 
-    for (i = 0; i < ic->num; i++) {
+    for (uint32_t k = 0; k < ic->num; k++) {
+      uint32_t i = ic->order[k];
       IndexIterator *it = ic->its[i];
 
       if (!it) goto eof;
@@ -780,7 +1180,7 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
       int rc = INDEXREAD_OK;
       if (ic->docIds[i] != ic->lastDocId || ic->lastDocId == 0) {
 
-        if (i == 0 && ic->docIds[i] >= ic->lastDocId) {
+        if (k == 0 && ic->docIds[i] >= ic->lastDocId) {
           rc = it->Read(it->ctx, &h);
         } else {
           rc = it->SkipTo(it->ctx, ic->lastDocId, &h);
@@ -794,17 +1194,28 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
 
       if (ic->docIds[i] > ic->lastDocId) {
         ic->lastDocId = ic->docIds[i];
+        if (k > 0) {
+          // this child rejected the candidate; check it earlier next time
+          ic->order[k] = ic->order[k - 1];
+          ic->order[k - 1] = i;
+        }
         break;
       }
       if (rc == INDEXREAD_OK) {
         ++nh;
-        AggregateResult_AddChild(ic->base.current, h);
+        ic->hits[i] = h;
       } else {
         ic->lastDocId++;
       }
     }
 
     if (nh == ic->num) {
+      // the aggregate keeps the original order of the children, as slop and order checks
+      // depend on it
+      AggregateResult_Reset(ic->base.current);
+      for (uint32_t i = 0; i < ic->num; i++) {
+        AggregateResult_AddChild(ic->base.current, ic->hits[i]);
+      }
       // printf("II %p HIT @ %d\n", ic, ic->current->docId);
       // sum up all hits
       if (hit != NULL) {
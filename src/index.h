@@ -39,6 +39,23 @@ It will return each document of the underlying iterators, exactly once */
 IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *t, int quickExit,
                                 double weight);
 
+/* Bounds the score a term record adds to a document, given an upper bound on the record's
+ * frequency. Scorers which have such a bound let ranked queries skip documents which can not make
+ * it into the top results */
+typedef double (*TermScoreBound)(const RSIndexResult *term, uint32_t maxFreq,
+                                 const RSIndexStats *stats);
+
+/* Let a union skip documents which can not score at least *minScore, which the sorter raises as it
+ * finds better results. The children's records are bounded with `bound`, and `scale` bounds what
+ * the scorer multiplies their sum by (the document score). Documents which only appear in children
+ * whose bounds add up to less than the threshold are never visited (MaxScore), and candidates are
+ * checked against the bounds of the index blocks holding them before they are collected.
+ *
+ * Skipped documents are not counted in the query's total. Only sorted unions of terms and unions of
+ * terms are supported; returns 0 if the union can not be pruned */
+int UI_EnableScorePruning(IndexIterator *it, const double *minScore, TermScoreBound bound,
+                          const RSIndexStats *stats, double scale);
+
 /* Create a new intersect iterator over the given list of child iterators. If maxSlop is not a
  * negative number, we will allow at most maxSlop intervening positions between the terms. If
  * maxSlop is set and inOrder is 1, we assert that the terms are in
@@ -64,6 +81,10 @@ IndexIterator *NewWildcardIterator(t_docId maxId);
  * the end and assumed to be allocated using rm_malloc */
 IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight);
 
+/* Like NewIdListIterator, for ids which are already sorted and unique. The iterator takes ownership
+ * of the array, which must be allocated using rm_malloc */
+IndexIterator *NewSortedIdListIterator(t_docId *ids, t_offset num, double weight);
+
 /** Create a new iterator which returns no results */
 IndexIterator *NewEmptyIterator(void);
 
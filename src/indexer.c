@@ -6,6 +6,7 @@
 #include "index.h"
 #include "redis_index.h"
 #include "rmutil/rm_assert.h"
+#include "doc_values.h"
 
 #include <unistd.h>
 static void Indexer_FreeInternal(DocumentIndexer *indexer);
@@ -247,6 +248,7 @@ static int makeDocumentId(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, int repl
     if (dmd) {
       // decrease the number of documents in the index stats only if the document was there
       --spec->stats.numDocuments;
+      IndexSpec_ClearDocValues(spec, dmd->id);
       aCtx->oldMd = dmd;
       if (sctx->spec->gc) {
         GCContext_OnDelete(sctx->spec->gc);
@@ -268,6 +270,17 @@ static int makeDocumentId(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, int repl
   return 0;
 }
 
+/* Write the document's DOCVALUES fields to their columns, once it has its id */
+static void setDocValues(RSAddDocumentCtx *aCtx, IndexSpec *spec) {
+  for (size_t ii = 0; ii < aCtx->doc.numFields; ++ii) {
+    const FieldSpec *fs = aCtx->fspecs + ii;
+    if (fs->name && FieldSpec_HasDocValues(fs)) {
+      NumericColumn *col = IndexSpec_GetNumericColumn(spec, fs->sortIdx);
+      NumericColumn_Set(col, aCtx->doc.docId, aCtx->fdatas[ii].numeric);
+    }
+  }
+}
+
 /**
  * Performs bulk document ID assignment to all items in the queue.
  * If one item cannot be assigned an ID, it is marked as being errored.
@@ -291,6 +304,11 @@ static void doAssignIds(RSAddDocumentCtx *cur, RedisSearchCtx *ctx) {
     RSDocumentMetadata *md = DocTable_Get(&spec->docs, cur->doc.docId);
     md->maxFreq = cur->fwIdx->maxFreq;
     md->len = cur->fwIdx->totalFreq;
+    md->fieldsDigest = Document_IndexedFieldsDigest(&cur->doc, spec);
+
+    if (spec->docValues) {
+      setDocValues(cur, spec);
+    }
 
     if (cur->sv) {
       DocTable_SetSortingVector(&spec->docs, cur->doc.docId, cur->sv);
@@ -30,6 +30,10 @@ static int renderIndexOptions(RedisModuleCtx *ctx, IndexSpec *sp) {
     RedisModule_ReplyWithSimpleString(ctx, SPEC_SCHEMA_EXPANDABLE_STR);
     n++;
   }
+  if (sp->flags & Index_LargeBlocks) {
+    RedisModule_ReplyWithSimpleString(ctx, SPEC_LARGEBLOCKS_STR);
+    n++;
+  }
   RedisModule_ReplySetArrayLength(ctx, n);
   return 2;
 }
@@ -93,6 +97,14 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       RedisModule_ReplyWithSimpleString(ctx, SPEC_SORTABLE_STR);
       ++nn;
     }
+    if (FieldSpec_HasDocValues(fs)) {
+      RedisModule_ReplyWithSimpleString(ctx, SPEC_DOCVALUES_STR);
+      ++nn;
+    }
+    if (FieldSpec_HasSortedRuns(fs)) {
+      RedisModule_ReplyWithSimpleString(ctx, SPEC_SORTEDRUNS_STR);
+      ++nn;
+    }
     if (FieldSpec_IsNoStem(fs)) {
       RedisModule_ReplyWithSimpleString(ctx, SPEC_NOSTEM_STR);
       ++nn;
@@ -122,8 +134,9 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   REPLY_KVNUM(n, "doc_table_size_mb", sp->docs.memsize / (float)0x100000);
   REPLY_KVNUM(n, "sortable_values_size_mb", sp->docs.sortablesSize / (float)0x100000);
+  REPLY_KVNUM(n, "doc_values_size_mb", IndexSpec_DocValuesMemUsage(sp) / (float)0x100000);
 
-  REPLY_KVNUM(n, "key_table_size_mb", TrieMap_MemUsage(sp->docs.dim.tm) / (float)0x100000);
+  REPLY_KVNUM(n, "key_table_size_mb", DocIdMap_MemUsage(&sp->docs.dim) / (float)0x100000);
   REPLY_KVNUM(n, "records_per_doc_avg",
               (float)sp->stats.numRecords / (float)sp->stats.numDocuments);
   REPLY_KVNUM(n, "bytes_per_record_avg",
@@ -133,6 +146,10 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   REPLY_KVNUM(n, "offset_bits_per_record_avg",
               8.0F * (float)sp->stats.offsetVecsSize / (float)sp->stats.offsetVecRecords);
 
+  REPLY_KVNUM(n, "indexing", !!sp->scanner);
+  REPLY_KVNUM(n, "percent_indexed", IndexesScanner_IndexedPercent(sp->scanner));
+  REPLY_KVNUM(n, "indexing_keys_per_sec", IndexesScanner_KeysPerSec(sp->scanner));
+
   if (sp->gc) {
     RedisModule_ReplyWithSimpleString(ctx, "gc_stats");
     GCContext_RenderStats(sp->gc, ctx);
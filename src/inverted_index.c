@@ -12,12 +12,20 @@
 #include "redismodule.h"
 #include "rmutil/rm_assert.h"
 #include "geo_index.h"
+#include "util/arr.h"
+#include "docid_bitmap.h"
 
 uint64_t TotalIIBlocks = 0;
 
 // The number of entries in each index block. A new block will be created after every N entries
 #define INDEX_BLOCK_SIZE 100
 
+// The number of entries in each block of an index created with LARGEBLOCKS
+#define INDEX_LARGE_BLOCK_SIZE 1024
+
+// Number of records between two skip table checkpoints in a large block
+#define INDEX_BLOCK_SKIP_INTERVAL 64
+
 // Initial capacity (in bytes) of a new block
 #define INDEX_BLOCK_INITIAL_CAP 6
 
@@ -26,6 +34,7 @@ uint64_t TotalIIBlocks = 0;
 
 // pointer to the current block while reading the index
 #define IR_CURRENT_BLOCK(ir) (ir->idx->blocks[ir->currentBlock])
+#define BLOCK_MATCHES(blk, docId) ((blk).firstId <= docId && docId <= (blk).lastId)
 
 static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *idx,
                                           IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx,
@@ -48,6 +57,7 @@ IndexBlock *InvertedIndex_AddBlock(InvertedIndex *idx, t_docId firstId) {
   IndexBlock *last = idx->blocks + (idx->size - 1);
   memset(last, 0, sizeof(*last));  // for msan
   last->firstId = last->lastId = firstId;
+  IndexBlock_NewUid(last);
   Buffer_Init(&INDEX_LAST_BLOCK(idx).buf, INDEX_BLOCK_INITIAL_CAP);
   return &INDEX_LAST_BLOCK(idx);
 }
@@ -60,14 +70,24 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
   idx->gcMarker = 0;
   idx->flags = flags;
   idx->numDocs = 0;
+  idx->bitmap = NULL;
   if (initBlock) {
     InvertedIndex_AddBlock(idx, 0);
   }
   return idx;
 }
 
+void IndexBlock_NewUid(IndexBlock *blk) {
+  static uint32_t lastUid = 0;
+  blk->uid = ++lastUid;
+}
+
 void indexBlock_Free(IndexBlock *blk) {
   Buffer_Free(&blk->buf);
+  if (blk->skips) {
+    array_free(blk->skips);
+    blk->skips = NULL;
+  }
 }
 
 void InvertedIndex_Free(void *ctx) {
@@ -77,9 +97,17 @@ void InvertedIndex_Free(void *ctx) {
     indexBlock_Free(&idx->blocks[i]);
   }
   rm_free(idx->blocks);
+  InvertedIndex_DropBitmap(idx);
   rm_free(idx);
 }
 
+void InvertedIndex_DropBitmap(InvertedIndex *idx) {
+  if (idx->bitmap) {
+    DocIdBitmap_Unref(idx->bitmap);
+    idx->bitmap = NULL;
+  }
+}
+
 static void IR_SetAtEnd(IndexReader *r, int value) {
   if (r->isValidP) {
     *r->isValidP = !value;
@@ -103,27 +131,50 @@ void IndexReader_OnReopen(RedisModuleKey *k, void *privdata) {
 
   // If the key is valid, we just reset the reader's buffer reader to the current block pointer
   ir->idx = RedisModule_ModuleTypeGetValue(k);
+  IndexReader_Resume(ir);
+}
+
+static void IR_SetBlock(IndexReader *ir, uint32_t i) {
+  ir->currentBlock = i;
+  ir->blockUid = IR_CURRENT_BLOCK(ir).uid;
+  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+}
+
+void IndexReader_Resume(IndexReader *ir) {
+  InvertedIndex *idx = ir->idx;
+  size_t offset = ir->br.pos;
 
   // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
-  if (ir->gcMarker == ir->idx->gcMarker) {
-    // no GC - we just go to the same offset we were at
-    size_t offset = ir->br.pos;
-    ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-    ir->br.pos = offset;
-  } else {
-    // if there has been a GC cycle on this key while we were asleep, the offset might not be valid
-    // anymore. This means that we need to seek to last docId we were at
-
-    // reset the state of the reader
-    t_docId lastId = ir->lastId;
-    ir->currentBlock = 0;
-    ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-    ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
-
-    // seek to the previous last id
-    RSIndexResult *dummy = NULL;
-    IR_SkipTo(ir, lastId, &dummy);
+  if (ir->gcMarker != idx->gcMarker) {
+    ir->gcMarker = idx->gcMarker;
+
+    // GC only removes blocks, so our block can only have moved towards the start. Find the block
+    // holding our last id, and check that it is still the one we were reading
+    uint32_t bottom = 0, top = MIN(ir->currentBlock, idx->size - 1), found = 0;
+    while (bottom < top) {
+      uint32_t mid = (bottom + top + 1) / 2;
+      if (idx->blocks[mid].firstId <= ir->lastId) {
+        bottom = mid;
+      } else {
+        top = mid - 1;
+      }
+    }
+    const IndexBlock *blk = idx->blocks + bottom;
+    if (blk->uid != ir->blockUid || !BLOCK_MATCHES(*blk, ir->lastId)) {
+      // our block was rewritten or removed, so the offset is meaningless. Seek to the last id
+      t_docId lastId = ir->lastId;
+      IR_SetBlock(ir, 0);
+      RSIndexResult *dummy = NULL;
+      IR_SkipTo(ir, lastId, &dummy);
+      return;
+    }
+    ir->currentBlock = bottom;
   }
+
+  // the block's buffer may have been reallocated by writes, but our offset is still valid
+  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  ir->br.pos = offset;
 }
 
 /******************************************************************************
@@ -424,9 +475,10 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
 
   t_docId delta = 0;
   IndexBlock *blk = &INDEX_LAST_BLOCK(idx);
+  int largeBlocks = idx->flags & Index_LargeBlocks;
 
   // see if we need to grow the current block
-  if (blk->numDocs >= INDEX_BLOCK_SIZE) {
+  if (blk->numDocs >= (largeBlocks ? INDEX_LARGE_BLOCK_SIZE : INDEX_BLOCK_SIZE)) {
     blk = InvertedIndex_AddBlock(idx, docId);
   } else if (blk->numDocs == 0) {
     blk->firstId = blk->lastId = docId;
@@ -438,16 +490,34 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
     delta = 0;
   }
 
+  size_t ret = 0;
+  if (largeBlocks && blk->numDocs && blk->numDocs % INDEX_BLOCK_SKIP_INTERVAL == 0) {
+    if (!blk->skips) {
+      blk->skips = array_new(IndexBlockSkip, INDEX_LARGE_BLOCK_SIZE / INDEX_BLOCK_SKIP_INTERVAL);
+    }
+    IndexBlockSkip skip = {.lastId = blk->lastId, .offset = blk->buf.offset};
+    blk->skips = array_append(blk->skips, skip);
+    ret += sizeof(skip);
+  }
+
   BufferWriter bw = NewBufferWriter(&blk->buf);
 
   // printf("Writing docId %llu, delta %llu, flags %x\n", docId, delta, (int)idx->flags);
-  size_t ret = encoder(&bw, delta, entry);
+  ret += encoder(&bw, delta, entry);
+  if ((idx->flags & Index_StoreFreqs) && entry->freq > blk->maxFreq) {
+    blk->maxFreq = entry->freq;
+  }
 
   idx->lastId = docId;
   blk->lastId = docId;
   ++blk->numDocs;
   ++idx->numDocs;
 
+  if (idx->bitmap && !DocIdBitmap_Add(idx->bitmap, docId)) {
+    // the bitmap is in use by running queries and cannot grow - it will be rebuilt when needed
+    InvertedIndex_DropBitmap(idx);
+  }
+
   return ret;
 }
 
@@ -479,10 +549,57 @@ size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double
   return InvertedIndex_WriteEntryGeneric(idx, encodeNumeric, docId, &rec);
 }
 
+void IndexBlock_UpdateSkips(IndexBlock *blk, IndexFlags flags) {
+  if (blk->skips) {
+    array_free(blk->skips);
+    blk->skips = NULL;
+  }
+  if (!(flags & Index_LargeBlocks) || blk->numDocs <= INDEX_BLOCK_SKIP_INTERVAL) {
+    return;
+  }
+
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(flags & INDEX_STORAGE_MASK);
+  if (!decoders.decoder) {
+    return;
+  }
+  static const IndexDecoderCtx empty = {0};
+  RSIndexResult *res = NewTokenRecord(NULL, 1);
+  BufferReader br = NewBufferReader(&blk->buf);
+  t_docId lastId = blk->firstId;
+  blk->skips = array_new(IndexBlockSkip, blk->numDocs / INDEX_BLOCK_SKIP_INTERVAL);
+
+  for (size_t n = 0; !BufferReader_AtEnd(&br); ++n) {
+    if (n && n % INDEX_BLOCK_SKIP_INTERVAL == 0) {
+      IndexBlockSkip skip = {.lastId = lastId, .offset = br.pos};
+      blk->skips = array_append(blk->skips, skip);
+    }
+    size_t pos = br.pos;
+    decoders.decoder(&br, &empty, res);
+    lastId = calculateId(lastId, *(uint32_t *)&res->docId, pos == 0);
+  }
+  IndexResult_Free(res);
+}
+
+/* Use the block's skip table to jump to the last checkpoint which is still below docId */
+static void IndexReader_SkipInBlock(IndexReader *ir, t_docId docId) {
+  IndexBlockSkip *skips = IR_CURRENT_BLOCK(ir).skips;
+  uint32_t bottom = 0, top = array_len(skips);
+  while (bottom < top) {
+    uint32_t i = (bottom + top) / 2;
+    if (skips[i].lastId < docId) {
+      bottom = i + 1;
+    } else {
+      top = i;
+    }
+  }
+  if (bottom && skips[bottom - 1].offset > ir->br.pos) {
+    ir->br.pos = skips[bottom - 1].offset;
+    ir->lastId = skips[bottom - 1].lastId;
+  }
+}
+
 static void IndexReader_AdvanceBlock(IndexReader *ir) {
-  ir->currentBlock++;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  IR_SetBlock(ir, ir->currentBlock + 1);
 }
 
 /******************************************************************************
@@ -516,6 +633,37 @@ DECODER(readFreqsFlags) {
   CHECK_FLAGS(ctx, res);
 }
 
+SKIPPER(seekFreqsFlags) {
+  uint32_t did = 0, freq = 0;
+  t_fieldMask fm = 0;
+  t_docId lastId = ir->lastId;
+  t_fieldMask num = ctx->num;
+  int rc = 0;
+
+  while (!BufferReader_AtEnd(br)) {
+    size_t oldpos = br->pos;
+    qint_decode3(br, &did, &freq, (uint32_t *)&fm);
+    if (oldpos == 0 && did != 0) {
+      // Old RDB: Delta is not 0, but the docid itself
+      lastId = did;
+    } else {
+      lastId = (did += lastId);
+    }
+    if ((num & fm) && did >= expid) {
+      rc = 1;
+      break;
+    }
+  }
+
+  res->docId = did;
+  res->freq = freq;
+  res->fieldMask = fm;
+
+  // sync back!
+  ir->lastId = lastId;
+  return rc;
+}
+
 DECODER(readFreqsFlagsWide) {
   uint32_t maskSz;
   qint_decode2(br, (uint32_t *)&res->docId, &res->freq);
@@ -644,7 +792,7 @@ DECODER(readNumeric) {
       // printf("Checking against filter: %d\n", rv);
       return rv;
     } else {
-      return isWithinRadius(f->geoFilter, res->num.value, NULL);
+      return GeoFilter_Match(f->geoFilter, res->num.value);
     }
   }
   // printf("Field matches.. hurray!\n");
@@ -705,6 +853,37 @@ DECODER(readDocIdsOnly) {
   return 1;  // Don't care about field mask
 }
 
+/**
+ * Doc-ids-only records are plain varint deltas, so the whole block can be walked in a tight
+ * loop without going through the decoder for every record. Tag indexes use this encoding.
+ */
+SKIPPER(seekDocIdsOnly) {
+  t_docId lastId = ir->lastId;
+  int rc = 0;
+
+  while (!BufferReader_AtEnd(br)) {
+    size_t oldpos = br->pos;
+    uint32_t delta = ReadVarint(br);
+    if (oldpos == 0 && delta != 0) {
+      // Old RDB: Delta is not 0, but the docid itself
+      lastId = delta;
+    } else {
+      lastId += delta;
+    }
+    if (lastId >= expid) {
+      rc = 1;
+      break;
+    }
+  }
+
+  res->docId = lastId;
+  res->freq = 1;
+
+  // sync back!
+  ir->lastId = lastId;
+  return rc;
+}
+
 IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
 #define RETURN_DECODERS(reader, seeker_) \
   procs.decoder = reader;                \
@@ -737,7 +916,7 @@ IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
 
     // ()
     case Index_DocIdsOnly:
-      RETURN_DECODERS(readDocIdsOnly, NULL);
+      RETURN_DECODERS(readDocIdsOnly, seekDocIdsOnly);
 
     // (freqs, offsets)
     case Index_StoreFreqs | Index_StoreTermOffsets:
@@ -745,7 +924,7 @@ IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
 
     // (freqs, fields)
     case Index_StoreFreqs | Index_StoreFieldFlags:
-      RETURN_DECODERS(readFreqsFlags, NULL);
+      RETURN_DECODERS(readFreqsFlags, seekFreqsFlags);
 
     case Index_StoreFreqs | Index_StoreFieldFlags | Index_WideSchema:
       RETURN_DECODERS(readFreqsFlagsWide, NULL);
@@ -924,8 +1103,6 @@ eof:
   return INDEXREAD_EOF;
 }
 
-#define BLOCK_MATCHES(blk, docId) ((blk).firstId <= docId && docId <= (blk).lastId)
-
 static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
   int rc = 0;
   InvertedIndex *idx = ir->idx;
@@ -937,6 +1114,17 @@ static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
 
   uint32_t top = idx->size - 1;
   uint32_t bottom = ir->currentBlock + 1;
+
+  // Gallop ahead until we find a block which starts after docId, so that short skips only look at
+  // the next few blocks. The binary search then only covers the range we've found.
+  uint32_t probe = bottom, step = 1;
+  while (probe < top && idx->blocks[probe].firstId <= docId) {
+    bottom = probe;
+    probe = MIN(probe + step, top);
+    step <<= 1;
+  }
+  top = probe;
+
   uint32_t i = bottom;  //(bottom + top) / 2;
   while (bottom <= top) {
     const IndexBlock *blk = idx->blocks + i;
@@ -957,8 +1145,7 @@ static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
   ir->currentBlock = i;
 
 new_block:
-  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  IR_SetBlock(ir, ir->currentBlock);
   return rc;
 }
 
@@ -987,6 +1174,10 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     }
   }
 
+  if (IR_CURRENT_BLOCK(ir).skips) {
+    IndexReader_SkipInBlock(ir, docId);
+  }
+
   /**
    * We need to replicate the effects of IR_Read() without actually calling it
    * continuously.
@@ -1057,14 +1248,12 @@ size_t IR_NumDocs(void *ctx) {
 static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedIndex *idx,
                              IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx,
                              RSIndexResult *record, double weight) {
-  ret->currentBlock = 0;
   ret->idx = idx;
   ret->gcMarker = idx->gcMarker;
   ret->record = record;
   ret->len = 0;
   ret->weight = weight;
-  ret->lastId = IR_CURRENT_BLOCK(ret).firstId;
-  ret->br = NewBufferReader(&IR_CURRENT_BLOCK(ret).buf);
+  IR_SetBlock(ret, 0);
   ret->decoders = decoder;
   ret->decoderCtx = decoderCtx;
   ret->isValidP = NULL;
@@ -1080,6 +1269,43 @@ static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *id
   return ret;
 }
 
+uint32_t IR_MaxFreq(const IndexReader *ir, t_docId docId) {
+  const InvertedIndex *idx = ir->idx;
+  if (!(idx->flags & Index_StoreFreqs)) {
+    return UINT32_MAX;
+  }
+  uint32_t maxFreq = 0;
+  if (!docId) {
+    for (uint32_t i = 0; i < idx->size; ++i) {
+      if (idx->blocks[i].numDocs && !idx->blocks[i].maxFreq) {
+        return UINT32_MAX;
+      }
+      maxFreq = MAX(maxFreq, idx->blocks[i].maxFreq);
+    }
+    return maxFreq;
+  }
+
+  // Find the last block starting at or before docId. Emptied blocks keep their first id, so the
+  // search still works. The whole index is searched, as GC may have moved the reader's block
+  uint32_t lo = 0, hi = idx->size;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (idx->blocks[mid].firstId <= docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (!lo) {
+    return 0;
+  }
+  const IndexBlock *blk = idx->blocks + lo - 1;
+  if (!blk->numDocs || blk->lastId < docId) {
+    return 0;
+  }
+  return blk->maxFreq ? blk->maxFreq : UINT32_MAX;
+}
+
 IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask fieldMask,
                                 RSQueryTerm *term, double weight) {
   if (term && sp) {
@@ -1102,6 +1328,21 @@ IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask f
   return NewIndexReaderGeneric(sp, idx, decoder, dctx, record, weight);
 }
 
+DocIdBitmap *InvertedIndex_GetBitmap(InvertedIndex *idx) {
+  if (idx->bitmap) {
+    return idx->bitmap;
+  }
+  DocIdBitmap *bm = NewDocIdBitmap(idx->lastId);
+  IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *res;
+  while (IR_Read(ir, &res) == INDEXREAD_OK) {
+    DocIdBitmap_Add(bm, res->docId);
+  }
+  IR_Free(ir);
+  idx->bitmap = bm;
+  return bm;
+}
+
 void IR_Free(IndexReader *ir) {
 
   IndexResult_Free(ir->record);
@@ -1130,10 +1371,8 @@ void IR_Rewind(void *ctx) {
 
   IndexReader *ir = ctx;
   IR_SetAtEnd(ir, 0);
-  ir->currentBlock = 0;
   ir->gcMarker = ir->idx->gcMarker;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  IR_SetBlock(ir, 0);
 }
 
 typedef struct {
@@ -1252,6 +1491,8 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     Buffer_Free(&blk->buf);
     blk->buf = repair;
     Buffer_ShrinkToSize(&blk->buf);
+    IndexBlock_UpdateSkips(blk, flags);
+    IndexBlock_NewUid(blk);
   }
   if (blk->numDocs == 0) {
     // if we left with no elements we do need to keep the
@@ -1285,6 +1526,7 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
       // Record the number of records removed for gc stats
       params->docsCollected += repaired;
       idx->numDocs -= repaired;
+      InvertedIndex_DropBitmap(idx);
 
       // Increase the GC marker so other queries can tell that we did something
       ++idx->gcMarker;
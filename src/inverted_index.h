@@ -18,12 +18,28 @@ extern "C" {
 
 extern uint64_t TotalIIBlocks;
 
+/* A checkpoint inside a block: the record at `offset` is delta-encoded against `lastId` */
+typedef struct {
+  t_docId lastId;
+  uint32_t offset;
+} IndexBlockSkip;
+
 /* A single block of data in the index. The index is basically a list of blocks we iterate */
 typedef struct {
   t_docId firstId;
   t_docId lastId;
   Buffer buf;
+  /* Checkpoints into buf, every INDEX_BLOCK_SKIP_INTERVAL records. Only kept for indexes with
+   * Index_LargeBlocks, NULL otherwise */
+  IndexBlockSkip *skips;
   uint16_t numDocs;
+  /* The highest frequency of the block's records, for indexes with Index_StoreFreqs. It bounds the
+   * scores of the records in ranked queries. GC only removes records, so it stays an upper bound.
+   * 0 if unknown - blocks loaded from RDB do not keep it */
+  uint32_t maxFreq;
+  /* Identifies the block's contents. It changes whenever GC rewrites the block, so that readers can
+   * tell whether their position in it is still valid */
+  uint32_t uid;
 } IndexBlock;
 
 typedef struct InvertedIndex {
@@ -33,6 +49,8 @@ typedef struct InvertedIndex {
   t_docId lastId;
   uint32_t numDocs;
   uint32_t gcMarker;
+  /* Materialized doc ids, built on demand for dense doc-ids-only indexes. NULL if not built */
+  struct DocIdBitmap *bitmap;
 } InvertedIndex;
 
 struct indexReadCtx;
@@ -69,8 +87,23 @@ typedef struct {
 InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock);
 IndexBlock *InvertedIndex_AddBlock(InvertedIndex *idx, t_docId firstId);
 void indexBlock_Free(IndexBlock *blk);
+
+/* Rebuild the in-block skip table from the block's data. Should be called whenever the block's
+ * buffer is rewritten. Does nothing for indexes without Index_LargeBlocks */
+void IndexBlock_UpdateSkips(IndexBlock *blk, IndexFlags flags);
 void InvertedIndex_Free(void *idx);
 
+/* Assign a new unique id to the block. Must be called when a block is created or rewritten */
+void IndexBlock_NewUid(IndexBlock *blk);
+
+/* Return the doc id bitmap of the index, materializing it on first use. The bitmap is kept up to
+ * date by writes until it is dropped. The returned bitmap is owned by the index - callers that keep
+ * it must take their own reference */
+struct DocIdBitmap *InvertedIndex_GetBitmap(InvertedIndex *idx);
+
+/* Release the index's bitmap, if any. Called whenever records are removed from the index */
+void InvertedIndex_DropBitmap(InvertedIndex *idx);
+
 #define IndexBlock_DataBuf(b) (b)->buf.data
 #define IndexBlock_DataLen(b) (b)->buf.offset
 
@@ -120,6 +153,8 @@ typedef struct IndexReader {
   // last docId, used for delta encoding/decoding
   t_docId lastId;
   uint32_t currentBlock;
+  // the uid of the current block, used to find our position again after GC
+  uint32_t blockUid;
 
   /* The decoder's filtering context. It may be a number or a pointer. The number is used for
    * filtering field masks, the pointer for numeric filtering */
@@ -150,6 +185,11 @@ typedef struct IndexReader {
 
 void IndexReader_OnReopen(RedisModuleKey *k, void *privdata);
 
+/* Restore the reader's position after it was suspended, e.g. between cursor reads. Writes only
+ * append, and GC replaces the blocks it rewrites, so the reader continues at the same offset unless
+ * GC changed its current block - in which case it seeks back to its last id */
+void IndexReader_Resume(IndexReader *ir);
+
 /* An index encoder is a callback that writes records to the index. It accepts a pre-calculated
  * delta for encoding */
 typedef size_t (*IndexEncoder)(BufferWriter *bw, uint32_t delta, RSIndexResult *record);
@@ -191,6 +231,11 @@ int IR_GenericRead(IndexReader *ir, RSIndexResult *res);
 /* Read an entry from an inverted index into RSIndexResult */
 int IR_Read(void *ctx, RSIndexResult **e);
 
+/* An upper bound on the frequency of the reader's record at docId, or of any of its records if
+ * docId is 0. Returns 0 if the reader has no record at docId, and UINT32_MAX if the frequencies
+ * are not known */
+uint32_t IR_MaxFreq(const IndexReader *ir, t_docId docId);
+
 /* Move to the next entry in an inverted index, without reading the whole entry
  */
 int IR_Next(void *ctx);
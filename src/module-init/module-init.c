@@ -135,6 +135,7 @@ int RediSearch_Init(RedisModuleCtx *ctx, int mode) {
   if (RSGlobalConfig.concurrentMode) {
     ConcurrentSearch_ThreadPoolStart();
   }
+  ConcurrentSearch_QueryPoolStart();
 
   GC_ThreadPoolStart();
 
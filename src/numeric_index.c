@@ -4,6 +4,7 @@
 #include "rmutil/vector.h"
 #include "rmutil/util.h"
 #include "index.h"
+#include "numeric_runs.h"
 #include "util/arr.h"
 #include <math.h>
 #include "redismodule.h"
@@ -13,6 +14,8 @@
 #define NR_MAXRANGE_CARD 2500
 #define NR_MAXRANGE_SIZE 10000
 #define NR_MAX_DEPTH 2
+// The tree is rebuilt when it becomes this many times higher than a balanced tree of its leaves
+#define NR_MAX_HEIGHT_RATIO 1.5
 
 typedef struct {
   IndexIterator *it;
@@ -139,6 +142,18 @@ NumericRangeNode *NewLeafNode(size_t cap, double min, double max, size_t splitCa
   return n;
 }
 
+static void NumericRangeNode_FreeRange(NumericRangeNode *n) {
+  InvertedIndex_Free(n->range->entries);
+  array_free(n->range->values);
+  rm_free(n->range);
+  n->range = NULL;
+}
+
+/* Set an inner node's depth to the height of its subtree, leaves being at depth 0 */
+static void NumericRangeNode_UpdateDepth(NumericRangeNode *n) {
+  n->maxDepth = 1 + MAX(n->left->maxDepth, n->right->maxDepth);
+}
+
 NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value) {
   NRN_AddRv rv = {.sz = 0, .changed = 0};
   if (!NumericRangeNode_IsLeaf(n)) {
@@ -157,16 +172,6 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
     rv = NumericRangeNode_Add(child, docId, value);
 
     if (rv.changed) {
-      // if there was a split it means our max depth has increased.
-      // we are too deep - we don't retain this node's range anymore.
-      // this keeps memory footprint in check
-      if (++n->maxDepth > NR_MAX_DEPTH && n->range) {
-        InvertedIndex_Free(n->range->entries);
-        array_free(n->range->values);
-        rm_free(n->range);
-        n->range = NULL;
-      }
-
       // check if we need to rebalance the child.
       // To ease the rebalance we don't rebalance the root
       // nor do we rebalance nodes that are with ranges (n->maxDepth > NR_MAX_DEPTH)
@@ -174,16 +179,26 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
         NumericRangeNode *right = child->right;
         child->right = right->left;
         right->left = child;
-        --child->maxDepth;
+        NumericRangeNode_UpdateDepth(child);
+        NumericRangeNode_UpdateDepth(right);
         *childP = right;  // replace the child with the new child
       } else if ((child->left->maxDepth - child->right->maxDepth) >
                  NR_MAX_DEPTH) {  // role to the right
         NumericRangeNode *left = child->left;
         child->left = left->right;
         left->right = child;
-        --child->maxDepth;
+        NumericRangeNode_UpdateDepth(child);
+        NumericRangeNode_UpdateDepth(left);
         *childP = left;  // replace the child with the new child
       }
+
+      // if there was a split our max depth may have increased.
+      // if we are too deep - we don't retain this node's range anymore.
+      // this keeps memory footprint in check
+      NumericRangeNode_UpdateDepth(n);
+      if (n->maxDepth > NR_MAX_DEPTH && n->range) {
+        NumericRangeNode_FreeRange(n);
+      }
     }
     // return 1 or 0 to our called, so this is done recursively
     return rv;
@@ -260,10 +275,7 @@ Vector *NumericRangeNode_FindRange(NumericRangeNode *n, double min, double max)
 void NumericRangeNode_Free(NumericRangeNode *n) {
   if (!n) return;
   if (n->range) {
-    InvertedIndex_Free(n->range->entries);
-    array_free(n->range->values);
-    rm_free(n->range);
-    n->range = NULL;
+    NumericRangeNode_FreeRange(n);
   }
 
   NumericRangeNode_Free(n->left);
@@ -288,6 +300,64 @@ NumericRangeTree *NewNumericRangeTree() {
   return ret;
 }
 
+typedef struct {
+  // the leaves in order, and the lowest value routed to each of them
+  NumericRangeNode **leaves;
+  double *lowerBounds;
+  // the inner nodes, reused for the new tree
+  NumericRangeNode **inner;
+} rebalanceCtx;
+
+static void collectNodes(NumericRangeNode *n, double lowerBound, rebalanceCtx *ctx) {
+  if (NumericRangeNode_IsLeaf(n)) {
+    ctx->leaves = array_append(ctx->leaves, n);
+    ctx->lowerBounds = array_append(ctx->lowerBounds, lowerBound);
+    return;
+  }
+  collectNodes(n->left, lowerBound, ctx);
+  collectNodes(n->right, n->value, ctx);
+  ctx->inner = array_append(ctx->inner, n);
+}
+
+/* Build a balanced tree over the leaves [lo, hi) */
+static NumericRangeNode *buildBalanced(rebalanceCtx *ctx, size_t lo, size_t hi) {
+  if (hi - lo == 1) {
+    return ctx->leaves[lo];
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  NumericRangeNode *n = array_pop(ctx->inner);
+  // an inner node's range holds the records of its whole subtree, which is about to change
+  if (n->range) {
+    NumericRangeNode_FreeRange(n);
+  }
+  n->left = buildBalanced(ctx, lo, mid);
+  n->right = buildBalanced(ctx, mid, hi);
+  n->value = ctx->lowerBounds[mid];
+  NumericRangeNode_UpdateDepth(n);
+  return n;
+}
+
+/* Rebuild the inner nodes of the tree as a balanced tree over the same leaves. The nodes themselves
+ * are reused rather than reallocated, since the fork GC refers to them by address */
+static void NumericRangeTree_Rebalance(NumericRangeTree *t) {
+  rebalanceCtx ctx = {.leaves = array_new(NumericRangeNode *, t->numRanges),
+                      .lowerBounds = array_new(double, t->numRanges),
+                      .inner = array_new(NumericRangeNode *, t->numRanges)};
+  collectNodes(t->root, NF_NEGATIVE_INFINITY, &ctx);
+  t->root = buildBalanced(&ctx, 0, array_len(ctx.leaves));
+  array_free(ctx.leaves);
+  array_free(ctx.lowerBounds);
+  array_free(ctx.inner);
+}
+
+/* Whether the tree has grown too high for its number of leaves, which happens when values are
+ * added in increasing order, e.g. timestamps */
+static int NumericRangeTree_NeedsRebalance(const NumericRangeTree *t) {
+  size_t balanced = 1 + (size_t)ceil(log2(t->numRanges));
+  // the root's depth is the number of levels below it
+  return 1 + (size_t)t->root->maxDepth > balanced * NR_MAX_HEIGHT_RATIO;
+}
+
 size_t NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value) {
 
   // Do not allow duplicate entries. This might happen due to indexer bugs and we need to protect
@@ -307,6 +377,10 @@ size_t NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value) {
   t->numRanges += rv.changed;
   t->numEntries++;
 
+  if (rv.changed && NumericRangeTree_NeedsRebalance(t)) {
+    NumericRangeTree_Rebalance(t);
+  }
+
   return rv.sz;
 }
 
@@ -332,6 +406,32 @@ void NumericRangeTree_Free(NumericRangeTree *t) {
   rm_free(t);
 }
 
+static void collectStats(NumericRangeNode *n, size_t depth, NumericRangeTreeStats *stats) {
+  if (!NumericRangeNode_IsLeaf(n)) {
+    collectStats(n->left, depth + 1, stats);
+    collectStats(n->right, depth + 1, stats);
+    return;
+  }
+  stats->numLeaves++;
+  stats->height = MAX(stats->height, depth + 1);
+  ++*array_ensure_at(&stats->leafDepths, depth, size_t);
+
+  size_t numDocs = n->range->entries->numDocs;
+  size_t bucket = numDocs > 1 ? 63 - __builtin_clzll(numDocs) : 0;
+  ++*array_ensure_at(&stats->leafSizes, bucket, size_t);
+}
+
+void NumericRangeTree_GetStats(NumericRangeTree *t, NumericRangeTreeStats *stats) {
+  *stats = (NumericRangeTreeStats){.leafDepths = array_new(size_t, 8),
+                                   .leafSizes = array_new(size_t, 8)};
+  collectStats(t->root, 0, stats);
+}
+
+void NumericRangeTreeStats_Free(NumericRangeTreeStats *stats) {
+  array_free(stats->leafDepths);
+  array_free(stats->leafSizes);
+}
+
 IndexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
                                        const NumericFilter *f) {
 
@@ -389,6 +489,42 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
   return it;
 }
 
+size_t NumericRangeTree_Count(NumericRangeTree *t, const NumericFilter *f, const DocTable *dt) {
+  Vector *v = NumericRangeTree_Find(t, f->min, f->max);
+  // Ids are never reused, so a table with no gaps has never had a document deleted - which means
+  // every record in the tree belongs to a live document
+  int allLive = dt->size == dt->maxDocId + 1;
+  size_t count = 0;
+
+  for (size_t i = 0; i < Vector_Size(v); i++) {
+    NumericRange *rng;
+    Vector_Get(v, i, &rng);
+    if (!rng) {
+      continue;
+    }
+    int contained = NumericFilter_Match(f, rng->minVal) && NumericFilter_Match(f, rng->maxVal);
+    if (contained && allLive) {
+      count += rng->entries->numDocs;
+      continue;
+    }
+
+    RSIndexResult *res = NULL;
+    IndexReader *ir = NewNumericReader(NULL, rng->entries, contained ? NULL : f);
+    while (INDEXREAD_OK == IR_Read(ir, &res)) {
+      if (!allLive) {
+        const RSDocumentMetadata *dmd = DocTable_Get(dt, res->docId);
+        if (!dmd || (dmd->flags & Document_Deleted)) {
+          continue;
+        }
+      }
+      ++count;
+    }
+    IR_Free(ir);
+  }
+  Vector_Free(v);
+  return count;
+}
+
 RedisModuleType *NumericIndexType = NULL;
 #define NUMERICINDEX_KEY_FMT "nm:%s/%s"
 
@@ -413,26 +549,49 @@ static NumericRangeTree *openNumericKeysDict(RedisSearchCtx *ctx, RedisModuleStr
   return kdv->p;
 }
 
-struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
-                                               ConcurrentSearchCtx *csx, FieldType forType) {
+/* Open the tree of the filter's field for reading. Returns NULL if the field has no tree */
+static NumericRangeTree *openFilterTree(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                        FieldType forType, RedisModuleString **keyName,
+                                        RedisModuleKey **idxKey) {
   RedisModuleString *s =
       IndexSpec_GetFormattedKeyByName(ctx->spec, flt->fieldName, forType);
   if (!s) {
     return NULL;
   }
-  RedisModuleKey *key = NULL;
-  NumericRangeTree *t = NULL;
-  if (!ctx->spec->keysDict) {
-    key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
-    if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
-      return NULL;
-    }
+  *keyName = s;
+  if (ctx->spec->keysDict) {
+    return openNumericKeysDict(ctx, s, 0);
+  }
 
-    t = RedisModule_ModuleTypeGetValue(key);
-  } else {
-    t = openNumericKeysDict(ctx, s, 0);
+  RedisModuleKey *key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
+  *idxKey = key;
+  if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
+    return NULL;
+  }
+  return RedisModule_ModuleTypeGetValue(key);
+}
+
+/* Get the sorted runs index of the filter's field, or NULL if the field is indexed in a tree */
+static NumericRuns *openFilterRuns(RedisSearchCtx *ctx, const NumericFilter *flt, int *isRuns) {
+  const FieldSpec *fs = IndexSpec_GetField(ctx->spec, flt->fieldName, strlen(flt->fieldName));
+  *isRuns = fs && FIELD_IS(fs, INDEXFLD_T_NUMERIC) && FieldSpec_HasSortedRuns(fs);
+  return *isRuns ? IndexSpec_GetNumericRuns(ctx->spec, fs, 0) : NULL;
+}
+
+struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                               ConcurrentSearchCtx *csx, FieldType forType) {
+  if (forType == INDEXFLD_T_NUMERIC) {
+    int isRuns;
+    NumericRuns *runs = openFilterRuns(ctx, flt, &isRuns);
+    if (isRuns) {
+      // The matching ids are copied out, so there is nothing to reopen after a context switch
+      return runs ? NewNumericRunsIterator(runs, flt) : NULL;
+    }
   }
 
+  RedisModuleString *s = NULL;
+  RedisModuleKey *key = NULL;
+  NumericRangeTree *t = openFilterTree(ctx, flt, forType, &s, &key);
   if (!t) {
     return NULL;
   }
@@ -452,6 +611,72 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
   return it;
 }
 
+static int cmpRangePtrs(const void *p1, const void *p2) {
+  uintptr_t r1 = (uintptr_t) * (NumericRange **)p1, r2 = (uintptr_t) * (NumericRange **)p2;
+  return r1 < r2 ? -1 : (r1 > r2 ? 1 : 0);
+}
+
+struct indexIterator *NewGeoCellsIterator(RedisSearchCtx *ctx, NumericFilter **flts, size_t n) {
+  RedisModuleString *s = NULL;
+  RedisModuleKey *key = NULL;
+  NumericRangeTree *t = openFilterTree(ctx, flts[0], INDEXFLD_T_GEO, &s, &key);
+  if (!t) {
+    return NULL;
+  }
+
+  NumericRange **ranges = array_new(NumericRange *, 8);
+  for (size_t ii = 0; ii < n; ++ii) {
+    Vector *v = NumericRangeTree_Find(t, flts[ii]->min, flts[ii]->max);
+    for (size_t jj = 0; jj < Vector_Size(v); ++jj) {
+      NumericRange *rng;
+      Vector_Get(v, jj, &rng);
+      if (rng) {
+        ranges = array_append(ranges, rng);
+      }
+    }
+    Vector_Free(v);
+  }
+
+  // Drop the leaves found by more than one range
+  size_t nranges = 0;
+  qsort(ranges, array_len(ranges), sizeof(*ranges), cmpRangePtrs);
+  for (size_t ii = 0; ii < array_len(ranges); ++ii) {
+    if (!nranges || ranges[nranges - 1] != ranges[ii]) {
+      ranges[nranges++] = ranges[ii];
+    }
+  }
+
+  IndexIterator *it = NULL;
+  if (nranges == 1) {
+    it = NewNumericRangeIterator(ctx->spec, ranges[0], flts[0]);
+  } else if (nranges > 1) {
+    IndexIterator **its = rm_calloc(nranges, sizeof(*its));
+    for (size_t ii = 0; ii < nranges; ++ii) {
+      its[ii] = NewNumericRangeIterator(ctx->spec, ranges[ii], flts[0]);
+    }
+    it = NewUnionIterator(its, nranges, NULL, 1, 1);
+  }
+  array_free(ranges);
+  return it;
+}
+
+size_t NumericFilter_Count(RedisSearchCtx *ctx, const NumericFilter *flt) {
+  int isRuns;
+  NumericRuns *runs = openFilterRuns(ctx, flt, &isRuns);
+  if (isRuns) {
+    return runs ? NumericRuns_Count(runs, flt, &ctx->spec->docs) : 0;
+  }
+
+  RedisModuleString *s = NULL;
+  RedisModuleKey *key = NULL;
+  NumericRangeTree *t = openFilterTree(ctx, flt, INDEXFLD_T_NUMERIC, &s, &key);
+  size_t count = t ? NumericRangeTree_Count(t, flt, &ctx->spec->docs) : 0;
+  if (key) {
+    RedisModule_CloseKey(key);
+  }
+  return count;
+}
+
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey) {
 
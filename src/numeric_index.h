@@ -77,12 +77,35 @@ typedef struct {
 
 #define NumericRangeNode_IsLeaf(n) (n->left == NULL && n->right == NULL)
 
+/* The shape of a tree, as reported by FT.DEBUG */
+typedef struct {
+  size_t height;
+  size_t numLeaves;
+  // Number of leaves at each depth, the root being at depth 0
+  size_t *leafDepths;
+  // Number of leaves by number of records: entry i counts the leaves holding [2^i, 2^(i+1))
+  // records. Empty leaves are counted in entry 0
+  size_t *leafSizes;
+} NumericRangeTreeStats;
+
+void NumericRangeTree_GetStats(NumericRangeTree *t, NumericRangeTreeStats *stats);
+void NumericRangeTreeStats_Free(NumericRangeTreeStats *stats);
+
 struct indexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
                                               const NumericFilter *f);
 
 struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
                                                ConcurrentSearchCtx *csx, FieldType forType);
 
+/* Create an iterator over the records of a geo field within a set of geohash ranges, given as
+ * filters sharing the same geo filter. Records are only matched against the geo filter, so a leaf
+ * of the tree overlapping several ranges is read once */
+struct indexIterator *NewGeoCellsIterator(RedisSearchCtx *ctx, NumericFilter **flts, size_t n);
+
+/* Count the documents of a numeric field matching the filter, without iterating them through the
+ * query pipeline. Returns 0 if the field has no index */
+size_t NumericFilter_Count(RedisSearchCtx *ctx, const NumericFilter *flt);
+
 /* Add an entry to a numeric range node. Returns the cardinality of the range after the
  * inserstion.
  * No deduplication is done */
@@ -115,6 +138,11 @@ size_t NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value);
  * Returns a vector with range node pointers. */
 Vector *NumericRangeTree_Find(NumericRangeTree *t, double min, double max);
 
+/* Count the records in the tree matching the filter, skipping deleted documents. Ranges that lie
+ * entirely within the filter are counted from their size when the doc table has no deleted
+ * documents; other ranges are read, testing the filter only on those it cuts through */
+size_t NumericRangeTree_Count(NumericRangeTree *t, const NumericFilter *f, const DocTable *dt);
+
 /* Free the tree and all nodes */
 void NumericRangeTree_Free(NumericRangeTree *t);
 
@@ -0,0 +1,324 @@
+#include "numeric_runs.h"
+#include "index.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Number of entries appended before they are sorted into a run
+#define NUMERIC_RUNS_TAIL_SIZE 1024
+
+NumericRuns *NewNumericRuns() {
+  NumericRuns *r = rm_calloc(1, sizeof(*r));
+  r->runs = array_new(NumericRun, 8);
+  return r;
+}
+
+static int cmpEntries(const void *p1, const void *p2) {
+  const NumericRunEntry *e1 = p1, *e2 = p2;
+  if (e1->value != e2->value) {
+    return e1->value < e2->value ? -1 : 1;
+  }
+  return e1->docId < e2->docId ? -1 : (e1->docId > e2->docId ? 1 : 0);
+}
+
+static inline int isLive(const DocTable *dt, t_docId docId) {
+  if (!dt) {
+    return 1;
+  }
+  const RSDocumentMetadata *dmd = DocTable_Get(dt, docId);
+  return dmd && !(dmd->flags & Document_Deleted);
+}
+
+/* Merge run i with the newer run after it, dropping deleted documents */
+static void mergeRuns(NumericRuns *r, size_t i, const DocTable *dt) {
+  size_t n = array_len(r->runs);
+  NumericRun *older = r->runs + i, *newer = r->runs + i + 1;
+  NumericRunEntry *merged = rm_malloc((older->len + newer->len) * sizeof(*merged));
+  size_t a = 0, b = 0, len = 0;
+
+  while (a < older->len || b < newer->len) {
+    const NumericRunEntry *e;
+    if (b == newer->len ||
+        (a < older->len && cmpEntries(older->entries + a, newer->entries + b) <= 0)) {
+      e = older->entries + a++;
+    } else {
+      e = newer->entries + b++;
+    }
+    if (isLive(dt, e->docId)) {
+      merged[len++] = *e;
+    }
+  }
+
+  r->numEntries -= older->len + newer->len - len;
+  rm_free(older->entries);
+  rm_free(newer->entries);
+  older->entries = rm_realloc(merged, (len ? len : 1) * sizeof(*merged));
+  older->len = len;
+  memmove(newer, newer + 1, (n - i - 2) * sizeof(*newer));
+  r->runs = array_trimm_len(r->runs, n - 1);
+}
+
+/* Sort the tail into a new run, then merge runs for as long as the newest one is at least as large
+ * as the one before it. Like a binary counter, this keeps runs of decreasing sizes and merges every
+ * entry O(log N) times */
+static void sealTail(NumericRuns *r, const DocTable *dt) {
+  NumericRunEntry *entries = r->tail;
+  size_t len = r->tailLen;
+
+  // Values that arrive in order need no sorting
+  for (size_t i = 1; i < len; ++i) {
+    if (cmpEntries(entries + i - 1, entries + i) > 0) {
+      qsort(entries, len, sizeof(*entries), cmpEntries);
+      break;
+    }
+  }
+
+  NumericRun run = {.entries = entries, .len = len};
+  r->runs = array_append(r->runs, run);
+  r->tail = NULL;
+  r->tailLen = 0;
+
+  size_t n;
+  while ((n = array_len(r->runs)) > 1 && r->runs[n - 2].len <= r->runs[n - 1].len) {
+    mergeRuns(r, n - 2, dt);
+  }
+}
+
+long NumericRuns_Add(NumericRuns *r, t_docId docId, double value, const DocTable *dt) {
+  if (docId <= r->lastDocId) {
+    return 0;
+  }
+  size_t before = r->numEntries;
+  if (!r->tail) {
+    r->tail = rm_malloc(NUMERIC_RUNS_TAIL_SIZE * sizeof(*r->tail));
+  }
+  r->tail[r->tailLen++] = (NumericRunEntry){.value = value, .docId = docId};
+  r->lastDocId = docId;
+  r->numEntries++;
+
+  if (r->tailLen == NUMERIC_RUNS_TAIL_SIZE) {
+    sealTail(r, dt);
+  }
+  return (long)r->numEntries - (long)before;
+}
+
+size_t NumericRuns_NumDeleted(const NumericRuns *r, const DocTable *dt) {
+  // Ids are never reused, so a table with no gaps has never had a document deleted
+  if (dt->size == dt->maxDocId + 1) {
+    return 0;
+  }
+  size_t n = 0;
+  for (size_t i = 0; i < array_len(r->runs); ++i) {
+    for (size_t j = 0; j < r->runs[i].len; ++j) {
+      n += !isLive(dt, r->runs[i].entries[j].docId);
+    }
+  }
+  for (size_t j = 0; j < r->tailLen; ++j) {
+    n += !isLive(dt, r->tail[j].docId);
+  }
+  return n;
+}
+
+/* Drop the deleted documents from the entries, in place. Returns the number of entries kept */
+static size_t compactEntries(NumericRunEntry *entries, size_t len, const DocTable *dt) {
+  size_t kept = 0;
+  for (size_t j = 0; j < len; ++j) {
+    if (isLive(dt, entries[j].docId)) {
+      entries[kept++] = entries[j];
+    }
+  }
+  return kept;
+}
+
+size_t NumericRuns_Compact(NumericRuns *r, const DocTable *dt) {
+  size_t before = r->numEntries;
+  size_t n = 0;
+  for (size_t i = 0; i < array_len(r->runs); ++i) {
+    NumericRun run = r->runs[i];
+    run.len = compactEntries(run.entries, run.len, dt);
+    if (!run.len) {
+      rm_free(run.entries);
+      continue;
+    }
+    if (run.len < r->runs[i].len) {
+      run.entries = rm_realloc(run.entries, run.len * sizeof(*run.entries));
+    }
+    r->runs[n++] = run;
+  }
+  r->runs = array_trimm_len(r->runs, n);
+  r->tailLen = compactEntries(r->tail, r->tailLen, dt);
+
+  // Shrunk runs may now be smaller than newer ones. Merging from the newest pair down restores the
+  // decreasing sizes in one pass, since a merged run is larger than every run after it
+  for (size_t i = array_len(r->runs); i-- > 1;) {
+    if (r->runs[i - 1].len <= r->runs[i].len) {
+      mergeRuns(r, i - 1, dt);
+    }
+  }
+
+  r->numEntries = r->tailLen;
+  for (size_t i = 0; i < array_len(r->runs); ++i) {
+    r->numEntries += r->runs[i].len;
+  }
+  return before - r->numEntries;
+}
+
+/* Find the slice [*begin, *end) of the run's entries matching the filter */
+static void findSlice(const NumericRun *run, const NumericFilter *f, size_t *begin, size_t *end) {
+  // First entry above the minimum
+  size_t lo = 0, hi = run->len;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    double v = run->entries[mid].value;
+    if (f->inclusiveMin ? v < f->min : v <= f->min) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *begin = lo;
+
+  // First entry above the maximum
+  hi = run->len;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    double v = run->entries[mid].value;
+    if (f->inclusiveMax ? v <= f->max : v < f->max) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *end = lo;
+}
+
+size_t NumericRuns_Count(const NumericRuns *r, const NumericFilter *f, const DocTable *dt) {
+  // Ids are never reused, so a table with no gaps has never had a document deleted
+  if (dt && dt->size == dt->maxDocId + 1) {
+    dt = NULL;
+  }
+  size_t count = 0;
+  for (size_t i = 0; i < array_len(r->runs); ++i) {
+    const NumericRun *run = r->runs + i;
+    size_t begin, end;
+    findSlice(run, f, &begin, &end);
+    if (!dt) {
+      count += end - begin;
+      continue;
+    }
+    for (size_t j = begin; j < end; ++j) {
+      count += isLive(dt, run->entries[j].docId);
+    }
+  }
+  for (size_t j = 0; j < r->tailLen; ++j) {
+    count += NumericFilter_Match(f, r->tail[j].value) && isLive(dt, r->tail[j].docId);
+  }
+  return count;
+}
+
+/* A sorted stretch [pos, end) of the matching ids, read by the merge */
+typedef struct {
+  size_t pos;
+  size_t end;
+} idStretch;
+
+static inline void siftDown(idStretch *heap, size_t n, size_t i, const t_docId *ids) {
+  for (;;) {
+    size_t min = i, l = 2 * i + 1, r = l + 1;
+    if (l < n && ids[heap[l].pos] < ids[heap[min].pos]) min = l;
+    if (r < n && ids[heap[r].pos] < ids[heap[min].pos]) min = r;
+    if (min == i) {
+      return;
+    }
+    idStretch tmp = heap[i];
+    heap[i] = heap[min];
+    heap[min] = tmp;
+    i = min;
+  }
+}
+
+IndexIterator *NewNumericRunsIterator(const NumericRuns *r, const NumericFilter *f) {
+  size_t nruns = array_len(r->runs);
+  size_t *slices = rm_malloc((nruns ? nruns : 1) * 2 * sizeof(*slices));
+  size_t total = 0;
+  for (size_t i = 0; i < nruns; ++i) {
+    findSlice(r->runs + i, f, slices + 2 * i, slices + 2 * i + 1);
+    total += slices[2 * i + 1] - slices[2 * i];
+  }
+  for (size_t j = 0; j < r->tailLen; ++j) {
+    total += NumericFilter_Match(f, r->tail[j].value);
+  }
+  if (!total) {
+    rm_free(slices);
+    return NULL;
+  }
+
+  // Collect the ids slice by slice, noting where each stretch of increasing ids starts. A slice is
+  // sorted by value, so it is a single stretch when the values arrived in order, and the tail's
+  // matches always are one
+  t_docId *ids = rm_malloc(total * sizeof(*ids));
+  idStretch *heap = array_new(idStretch, nruns + 1);
+  size_t n = 0;
+  for (size_t i = 0; i < nruns; ++i) {
+    for (size_t j = slices[2 * i]; j < slices[2 * i + 1]; ++j) {
+      if (j == slices[2 * i] || r->runs[i].entries[j].docId < ids[n - 1]) {
+        heap = array_append(heap, ((idStretch){.pos = n}));
+      }
+      ids[n++] = r->runs[i].entries[j].docId;
+      array_tail(heap).end = n;
+    }
+  }
+  size_t tailStart = n;
+  for (size_t j = 0; j < r->tailLen; ++j) {
+    if (NumericFilter_Match(f, r->tail[j].value)) {
+      ids[n++] = r->tail[j].docId;
+    }
+  }
+  if (n > tailStart) {
+    heap = array_append(heap, ((idStretch){.pos = tailStart, .end = n}));
+  }
+  rm_free(slices);
+
+  // k-way merge of the stretches, in O(n log k)
+  size_t k = array_len(heap);
+  t_docId *merged = ids;
+  if (k > 1) {
+    merged = rm_malloc(n * sizeof(*merged));
+    for (size_t i = k / 2; i-- > 0;) {
+      siftDown(heap, k, i, ids);
+    }
+    for (size_t m = 0; m < n; ++m) {
+      merged[m] = ids[heap[0].pos++];
+      if (heap[0].pos == heap[0].end) {
+        heap[0] = heap[--k];
+      }
+      siftDown(heap, k, 0, ids);
+    }
+    rm_free(ids);
+  }
+  array_free(heap);
+
+  return NewSortedIdListIterator(merged, n, 1);
+}
+
+size_t NumericRuns_MemUsage(const NumericRuns *r) {
+  size_t sz = sizeof(*r) + array_len(r->runs) * sizeof(NumericRun);
+  for (size_t i = 0; i < array_len(r->runs); ++i) {
+    sz += r->runs[i].len * sizeof(NumericRunEntry);
+  }
+  if (r->tail) {
+    sz += NUMERIC_RUNS_TAIL_SIZE * sizeof(NumericRunEntry);
+  }
+  return sz;
+}
+
+void NumericRuns_Free(NumericRuns *r) {
+  for (size_t i = 0; i < array_len(r->runs); ++i) {
+    rm_free(r->runs[i].entries);
+  }
+  array_free(r->runs);
+  rm_free(r->tail);
+  rm_free(r);
+}
@@ -0,0 +1,72 @@
+#ifndef RS_NUMERIC_RUNS_H_
+#define RS_NUMERIC_RUNS_H_
+
+#include "redisearch.h"
+#include "doc_table.h"
+#include "index_iterator.h"
+#include "numeric_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  double value;
+  t_docId docId;
+} NumericRunEntry;
+
+/* A run of entries sorted by value */
+typedef struct {
+  NumericRunEntry *entries;
+  size_t len;
+} NumericRun;
+
+/* An append-only numeric index, kept for numeric fields declared with SORTEDRUNS. It suits values
+ * that mostly arrive in increasing order, such as event timestamps, where the range tree spends
+ * most of its ingest time tracking cardinality and splitting ranges.
+ *
+ * New entries are appended to a fixed size tail. A full tail is sorted by value and sealed into a
+ * run, and runs of similar size are then merged, so the index is kept in O(log N) runs. Merges drop
+ * the entries of deleted documents, and the GC compacts the runs once enough deleted documents are
+ * left in them. A range query binary-searches each run for the matching slice, and only the tail is
+ * scanned */
+typedef struct NumericRuns {
+  // Sealed runs, oldest (and largest) first
+  NumericRun *runs;
+  NumericRunEntry *tail;
+  size_t tailLen;
+  size_t numEntries;
+  t_docId lastDocId;
+} NumericRuns;
+
+NumericRuns *NewNumericRuns();
+
+/* Append an entry. Ids must be increasing, an entry for an id not above the last one is ignored.
+ * If dt is given, merges triggered by the entry skip deleted documents. Returns the change in the
+ * number of entries: 1 if the entry was added and 0 if it was ignored, less if merges dropped
+ * deleted documents */
+long NumericRuns_Add(NumericRuns *r, t_docId docId, double value, const DocTable *dt);
+
+/* Count the entries of documents deleted from dt */
+size_t NumericRuns_NumDeleted(const NumericRuns *r, const DocTable *dt);
+
+/* Drop the entries of documents deleted from dt from every run and the tail, merging runs as needed
+ * to keep their sizes decreasing. Returns the number of entries removed */
+size_t NumericRuns_Compact(NumericRuns *r, const DocTable *dt);
+
+/* Count the entries matching the filter, skipping documents deleted from dt */
+size_t NumericRuns_Count(const NumericRuns *r, const NumericFilter *f, const DocTable *dt);
+
+/* Create an iterator over the documents matching the filter. The matching ids are collected when
+ * the iterator is created, merging the sorted stretches of each run's slice, so it does not refer to
+ * the index afterwards. Returns NULL if no entry matches */
+IndexIterator *NewNumericRunsIterator(const NumericRuns *r, const NumericFilter *f);
+
+size_t NumericRuns_MemUsage(const NumericRuns *r);
+
+void NumericRuns_Free(NumericRuns *r);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
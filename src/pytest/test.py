@@ -730,6 +730,87 @@ def testSortBy(env):
         env.assertListEqual([100L, 'doc99', '$hello099 world', 'doc98', '$hello098 world', 'doc97', '$hello097 world', 'doc96',
                               '$hello096 world', 'doc95', '$hello095 world'], res)
 
+def testSortByDocValues(env):
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 'bar', 'numeric', 'docvalues').ok()
+    env.expect('ft.create', 'idx2', 'ON', 'HASH', 'schema', 'foo', 'text', 'docvalues').error()
+    info = env.cmd('ft.info', 'idx')
+    env.assertEqual(['bar', 'type', 'NUMERIC', 'DOCVALUES'], info[info.index('fields') + 1][1])
+
+    N = 100
+    for i in range(N):
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields',
+                             'foo', 'hello%03d world' % i, 'bar', 100 - i))
+    # documents without a value sort as the lowest value
+    env.assertOk(env.cmd('ft.add', 'idx', 'nobar', 1.0, 'fields', 'foo', 'world'))
+    for _ in env.retry_with_rdb_reload():
+        res = env.cmd('ft.search', 'idx', 'world', 'nocontent', 'sortby', 'bar', 'desc')
+        env.assertEqual([101L, 'doc0', 'doc1', 'doc2', 'doc3',
+                         'doc4', 'doc5', 'doc6', 'doc7', 'doc8', 'doc9'], res)
+        res = env.cmd('ft.search', 'idx', 'world', 'nocontent', 'sortby', 'bar', 'asc', 'limit', 0, 3)
+        env.assertEqual([101L, 'nobar', 'doc99', 'doc98'], res)
+        res = env.cmd('ft.search', 'idx', 'world', 'nocontent', 'sortby', 'bar', 'desc', 'limit', 99, 5)
+        env.assertEqual([101L, 'doc99', 'nobar'], res)
+
+    # partial updates of the value are seen by the sorter
+    env.assertOk(env.cmd('ft.add', 'idx', 'doc99', 1.0, 'replace', 'partial', 'fields', 'bar', 1000))
+    res = env.cmd('ft.search', 'idx', 'world', 'nocontent', 'sortby', 'bar', 'desc',
+                  'withsortkeys', 'limit', 0, 2)
+    env.assertEqual([101L, 'doc99', '#1000', 'doc0', '#100'], res)
+
+    # aggregations read the value from the column as well
+    res = env.cmd('ft.aggregate', 'idx', 'hello001', 'apply', '@bar * 2', 'as', 'double')
+    env.assertEqual([1L, ['double', '198']], res)
+    res = env.cmd('ft.aggregate', 'idx', 'hello00*', 'filter', '@bar > 95',
+                  'groupby', 1, '@bar', 'sortby', 2, '@bar', 'asc')
+    env.assertEqual([5L, ['bar', '96'], ['bar', '97'], ['bar', '98'], ['bar', '99'], ['bar', '100']], res)
+
+    # deleted documents no longer have a value
+    env.assertEqual(1, env.cmd('ft.del', 'idx', 'doc0'))
+    res = env.cmd('ft.search', 'idx', 'world', 'nocontent', 'sortby', 'bar', 'desc',
+                  'withsortkeys', 'limit', 0, 2)
+    env.assertEqual([100L, 'doc99', '#1000', 'doc1', '#99'], res)
+
+def testSortByDocValuesTopK(env):
+    # once the sorter's heap is full, worse documents are dropped before they reach it
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 'bar', 'numeric', 'docvalues').ok()
+    N = 1000
+    values = {}
+    for i in range(N):
+        values['doc%d' % i] = (i * 7919) % 97
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields',
+                             'foo', 'hello world', 'bar', values['doc%d' % i]))
+    byValue = sorted(values, key=lambda k: (values[k], int(k[3:])))
+    for asc in (True, False):
+        res = env.cmd('ft.search', 'idx', 'world', 'nocontent', 'sortby', 'bar',
+                      'asc' if asc else 'desc', 'limit', 0, 25)
+        env.assertEqual(N, res[0])
+        env.assertEqual(25, len(res) - 1)
+        got = [values[k] for k in res[1:]]
+        expected = [values[k] for k in (byValue if asc else byValue[::-1])[:25]]
+        env.assertEqual(expected, got)
+
+def testPruneScores(env):
+    # skipping documents by score must not change the top results
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text').ok()
+    N = 2000
+    for i in range(N):
+        words = ['common'] * (1 + i % 5)
+        if i % 7 == 0:
+            words += ['rare'] * (1 + i % 3)
+        if i % 3 == 0:
+            words.append('other')
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1.0 + (i % 11) / 10.0, 'fields',
+                             'foo', ' '.join(words)))
+    for scorer in ('TFIDF', 'BM25'):
+        for q in ('common|rare', 'common|rare|other', 'rare|other'):
+            args = ['ft.search', 'idx', q, 'nocontent', 'withscores', 'scorer', scorer,
+                    'limit', 0, 10]
+            full = env.cmd(*args)
+            pruned = env.cmd(*(args + ['prunescores']))
+            env.assertEqual(full[1:], pruned[1:])
+            env.assertLessEqual(pruned[0], full[0])
+            env.assertGreaterEqual(pruned[0], 10)
+
 def testNot(env):
     r = env
     env.assertOk(r.execute_command(
@@ -992,6 +1073,79 @@ def testGeo(env):
             'heathrow', -0.44155, 51.45865, '5', 'km')
         env.assertListEqual(sorted(res), sorted(res2))
 
+def testGeoDistance(env):
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'name', 'text', 'location', 'geo').ok()
+    for i, hotel in enumerate(hotels):
+        env.assertOk(env.cmd('ft.add', 'idx', 'hotel{}'.format(i), 1.0, 'fields', 'name',
+                             hotel[0], 'location', '{},{}'.format(hotel[2], hotel[1])))
+
+    # the distance is only sent when returned explicitly
+    res = env.cmd('ft.search', 'idx', 'heathrow', 'geofilter', 'location', -0.44155, 51.45865, 10, 'km')
+    env.assertEqual(5, res[0])
+    for fields in res[2::2]:
+        env.assertNotIn('__distance', fields)
+
+    res = env.cmd('ft.search', 'idx', 'heathrow', 'geofilter', 'location', -0.44155, 51.45865, 10, 'km',
+                  'sortby', '__distance', 'return', 1, '__distance')
+    env.assertEqual(5, res[0])
+    env.assertEqual('hotel94', res[1])
+    distances = [float(fields[1]) for fields in res[2::2]]
+    env.assertEqual(sorted(distances), distances)
+    env.assertLess(distances[0], 0.01)
+    env.assertLess(distances[-1], 10)
+
+    res = env.cmd('ft.aggregate', 'idx', '@location:[-0.44155 51.45865 10000 m]',
+                  'apply', '@__distance', 'as', 'dist', 'sortby', 2, '@dist', 'desc')
+    env.assertEqual(5, len(res) - 1)
+    distances = [float(row[1]) for row in res[1:]]
+    env.assertEqual(sorted(distances, reverse=True), distances)
+    env.assertGreater(distances[0], 1000)
+    env.assertLess(distances[0], 10000)
+
+def testGeoBoxPolygon(env):
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'name', 'text', 'location', 'geo').ok()
+    for i, hotel in enumerate(hotels):
+        env.assertOk(env.cmd('ft.add', 'idx', 'hotel{}'.format(i), 1.0, 'fields', 'name',
+                             hotel[0], 'location', '{},{}'.format(hotel[2], hotel[1])))
+
+    def search(*args):
+        res = env.cmd('ft.search', 'idx', 'hilton', 'nocontent', 'limit', 0, 1000, *args)
+        env.assertEqual(res[0], len(res) - 1)
+        return sorted(res[1:])
+
+    def inPolygon(lon, lat, poly):
+        inside = False
+        for (xi, yi), (xj, yj) in zip(poly, poly[-1:] + poly[:-1]):
+            if (yi > lat) != (yj > lat) and lon < xi + (lat - yi) * (xj - xi) / (yj - yi):
+                inside = not inside
+        return inside
+
+    box = (-0.3, 51.45, -0.1, 51.55)
+    expected = sorted('hotel{}'.format(i) for i, hotel in enumerate(hotels)
+                      if box[0] <= float(hotel[2]) <= box[2] and box[1] <= float(hotel[1]) <= box[3])
+    env.assertGreater(len(expected), 0)
+    for _ in env.retry_with_rdb_reload():
+        env.assertEqual(expected, search('geobox', 'location', *box))
+
+    triangle = [(-0.5, 51.4), (-0.05, 51.45), (-0.2, 51.6)]
+    expected = sorted('hotel{}'.format(i) for i, hotel in enumerate(hotels)
+                      if inPolygon(float(hotel[2]), float(hotel[1]), triangle))
+    env.assertGreater(len(expected), 0)
+    env.assertEqual(expected, search('geopolygon', 'location', 3, *[c for v in triangle for c in v]))
+
+    # combined with a radius filter
+    res = search(*(('geobox', 'location') + box + ('geofilter', 'location', -0.1757, 51.5156, 1, 'km')))
+    env.assertEqual(sorted(['hotel2', 'hotel21', 'hotel79']), res)
+
+    env.expect('ft.search', 'idx', 'hilton', 'geobox', 'location', 1, 1, 0, 0).error()
+    env.expect('ft.search', 'idx', 'hilton', 'geopolygon', 'location', 2, 0, 0, 1, 1).error()
+    env.expect('ft.search', 'idx', 'hilton', 'geopolygon', 'location', 3, 0, 0, 1, 1).error()
+    # vertex counts which would overflow the argument check, or are too large
+    env.expect('ft.search', 'idx', 'hilton', 'geopolygon', 'location', 9223372036854775808, 0, 0, 1, 1).error()
+    env.expect('ft.search', 'idx', 'hilton', 'geopolygon', 'location', 4097, *([0, 0] * 4097)).error()
+    env.expect('ft.search', 'idx', 'hilton', 'geobox', 'location', 0, 0, 1, 1,
+               'geobox', 'location', 0, 0, 1, 1).error()
+
 def testTagErrors(env):
     env.expect("ft.create", "test", 'ON', 'HASH',
                 "SCHEMA",  "tags", "TAG").equal('OK')
@@ -1289,6 +1443,71 @@ def testNumericRange(env):
             'ft.search', 'idx', 'hello kitty @score:[-inf +inf]', "nocontent")
         env.assertEqual(100, res[0])
 
+def testNumericRangeCount(env):
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'title', 'text', 'score', 'numeric').ok()
+    for i in xrange(1000):
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1, 'fields',
+                             'title', 'hello kitty', 'score', i))
+
+    def count(q):
+        return env.cmd('ft.search', 'idx', q, 'limit', 0, 0)
+
+    env.assertEqual([1000L], count('@score:[-inf +inf]'))
+    env.assertEqual([501L], count('@score:[0 500]'))
+    env.assertEqual([499L], count('@score:[(0 (500]'))
+    env.assertEqual([0L], count('@score:[2000 3000]'))
+
+    # deleted documents are not counted, also before they are garbage collected
+    for i in xrange(0, 1000, 2):
+        env.assertEqual(1, env.cmd('ft.del', 'idx', 'doc%d' % i))
+    env.assertEqual([500L], count('@score:[-inf +inf]'))
+    env.assertEqual([250L], count('@score:[0 500]'))
+    env.assertEqual([250L], count('@score:[(0 (500]'))
+    env.assertEqual(250, env.cmd('ft.search', 'idx', '@score:[0 500]', 'nocontent')[0])
+
+def testSortedRuns(env):
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'title', 'text', 'ts', 'numeric', 'sortedruns').ok()
+    env.expect('ft.create', 'idx2', 'ON', 'HASH', 'schema', 'title', 'text', 'sortedruns').error()
+    for i in xrange(3000):
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1, 'fields',
+                             'title', 'hello kitty', 'ts', 10000 + i - (i % 7) * 3))
+
+    env.assertEqual([3000L], env.cmd('ft.search', 'idx', '@ts:[-inf +inf]', 'limit', 0, 0))
+    res = env.cmd('ft.search', 'idx', '@ts:[11000 (11100]', 'nocontent', 'limit', 0, 1000)
+    expected = [i for i in xrange(3000) if 11000 <= 10000 + i - (i % 7) * 3 < 11100]
+    env.assertEqual(len(expected), res[0])
+    env.assertEqual(sorted('doc%d' % i for i in expected), sorted(res[1:]))
+    res = env.cmd('ft.search', 'idx', 'hello @ts:[12990 +inf]', 'nocontent', 'limit', 0, 1000)
+    env.assertEqual(len([i for i in xrange(3000) if 10000 + i - (i % 7) * 3 >= 12990]), res[0])
+
+    for i in xrange(0, 3000, 2):
+        env.assertEqual(1, env.cmd('ft.del', 'idx', 'doc%d' % i))
+    env.assertEqual([1500L], env.cmd('ft.search', 'idx', '@ts:[-inf +inf]', 'limit', 0, 0))
+    env.assertEqual(1500, env.cmd('ft.search', 'idx', '@ts:[-inf +inf]', 'nocontent')[0])
+    info = env.cmd('ft.info', 'idx')
+    env.assertIn('SORTEDRUNS', info[info.index('fields') + 1][1])
+
+def testSortedRunsGC(env):
+    if env.is_cluster():
+        raise unittest.SkipTest()
+
+    def numRecords():
+        res = env.cmd('ft.info', 'idx')
+        return int(res[res.index('num_records') + 1])
+
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'ts', 'numeric', 'sortedruns').ok()
+    for i in xrange(3000):
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1, 'fields', 'ts', 10000 + i))
+    env.assertEqual(3000, numRecords())
+
+    # deleted entries left in old runs are reclaimed by the gc
+    for i in xrange(0, 3000, 2):
+        env.assertEqual(1, env.cmd('ft.del', 'idx', 'doc%d' % i))
+    env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx')
+    env.assertEqual(1500, numRecords())
+    res = env.cmd('ft.search', 'idx', '@ts:[10000 10009]', 'nocontent', 'sortby', 'ts')
+    env.assertEqual([5L, 'doc1', 'doc3', 'doc5', 'doc7', 'doc9'], res)
+
 def testSuggestions(env):
     r = env
     env.assertEqual(1, r.execute_command(
@@ -2510,6 +2729,44 @@ def testLoadError(env):
     env.expect('ft.aggregate', 'idx', '*', 'LOAD', '2', 'test').error()
     env.expect('ft.aggregate', 'idx', '*', 'LOAD', '2', '@test').error()
 
+def testLoadChunkedFields(env):
+    # a document's fields are read in several calls once there are more than fit in one
+    fields = ['f%d' % i for i in range(6)]
+    schema = []
+    for f in fields:
+        schema += [f, 'TEXT']
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', *schema).ok()
+    N = 300
+    expected = []
+    for i in range(N):
+        doc = ['n', str(i)]
+        for j, f in enumerate(fields):
+            # leave some fields out
+            if (i + j) % 5:
+                doc += [f, 'v%d_%d' % (i, j)]
+        env.expect('ft.add', 'idx', 'doc%d' % i, '1.0', 'FIELDS', *doc).ok()
+        expected.append(doc)
+
+    loadArgs = ['LOAD', str(len(fields) + 1), '@n'] + ['@' + f for f in fields]
+    res = env.cmd('ft.aggregate', 'idx', '*', 'SORTBY', '2', '@n', 'ASC', 'MAX', str(N), *loadArgs)
+    env.assertEqual(N, len(res) - 1)
+    for i, row in enumerate(res[1:]):
+        env.assertEqual(to_dict(expected[i]), to_dict(row))
+
+    # a limit after the load only gets what it asks for
+    res = env.cmd('ft.aggregate', 'idx', '*', 'SORTBY', '2', '@n', 'ASC', 'MAX', str(N),
+                  *(loadArgs + ['LIMIT', '0', '3']))
+    env.assertEqual(3, len(res) - 1)
+    for i, row in enumerate(res[1:]):
+        env.assertEqual(to_dict(expected[i]), to_dict(row))
+
+    res = env.cmd('ft.search', 'idx', '*', 'SORTBY', 'n', 'ASC', 'LIMIT', '0', str(N),
+                  'RETURN', str(len(fields)), *fields)
+    env.assertEqual(N, res[0])
+    for i in range(N):
+        env.assertEqual('doc%d' % i, res[1 + 2 * i])
+        env.assertEqual(to_dict(expected[i][2:]), to_dict(res[2 + 2 * i]))
+
 def testMissingArgsError(env):
     env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'test', 'TEXT').equal('OK')
     env.expect('ft.add', 'idx', 'doc1', '1.0', 'FIELDS', 'test', 'foo').equal('OK')
@@ -2923,3 +3180,21 @@ def testIssue1208(env):
     env.expect('FT.ADD idx doc3 1 REPLACE PARTIAL IF @n>42e3 FIELDS n 100').equal('NOADD')
     env.expect('FT.ADD idx doc3 1 REPLACE PARTIAL IF @n<42e3 FIELDS n 100').ok()
     print env.cmd('FT.SEARCH', 'idx', '@n:[-inf inf]')
+
+def testLargeBlocks(env):
+    env.cmd('FT.CREATE', 'idx', 'LARGEBLOCKS', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT')
+    res = to_dict(env.cmd('FT.INFO', 'idx'))
+    env.assertEqual(res['index_options'], ['LARGEBLOCKS'])
+
+    conn = getConnectionByEnv(env)
+    for i in range(3000):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'common rare' if i % 7 == 0 else 'common')
+    env.expect('FT.SEARCH', 'idx', 'common rare', 'LIMIT', '0', '0').equal([429L])
+    env.expect('FT.SEARCH', 'idx', 'common', 'LIMIT', '0', '0').equal([3000L])
+
+    # make sure the skip tables survive garbage collection
+    for i in range(0, 3000, 2):
+        conn.execute_command('DEL', 'doc%d' % i)
+    env.cmd('FT.DEBUG', 'GC_FORCEINVOKE', 'idx')
+    env.expect('FT.SEARCH', 'idx', 'common rare', 'LIMIT', '0', '0').equal([214L])
+    env.expect('FT.SEARCH', 'idx', 'common', 'LIMIT', '0', '0').equal([1500L])
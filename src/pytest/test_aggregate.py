@@ -473,3 +473,98 @@ def testGroupbyNoReduce(env):
     for row in rv[1:]:
         env.assertEqual('primaryName', row[0])
         env.assertTrue('sarah' in row[1])
+
+def testParallelScan():
+    env = Env(moduleArgs='QUERY_WORKERS 4')
+    env.skipOnCluster()
+    conn = env.getConnection()
+    env.cmd('ft.create', 'idx', 'ON', 'HASH',
+            'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE', 'tg', 'TAG')
+
+    N = 10000
+    pl = conn.pipeline()
+    for i in range(1, N + 1):
+        pl.execute_command('hset', 'doc%d' % i, 't', 'hello' if i % 3 else 'world',
+                           'n', i, 'tg', 'even' if i % 2 == 0 else 'odd')
+        if i % 1000 == 0:
+            pl.execute()
+    pl.execute()
+    for i in range(1, N + 1, 7):
+        conn.execute_command('del', 'doc%d' % i)
+    live = [i for i in range(1, N + 1) if (i - 1) % 7]
+
+    def count(q):
+        res = env.cmd('ft.aggregate', 'idx', q, 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'c')
+        return int(res[1][1])
+
+    env.assertEqual(len(live), count('*'))
+    env.assertEqual(len([i for i in live if i % 3]), count('hello'))
+    env.assertEqual(len([i for i in live if i % 3 == 0]), count('-hello'))
+    env.assertEqual(len([i for i in live if i % 2 == 0 and i % 3 == 0]), count('@tg:{even} world'))
+    env.assertEqual(len([i for i in live if 2000 <= i <= 7000]), count('@n:[2000 7000]'))
+    env.assertEqual(len([i for i in live if i % 3 or 100 <= i <= 200]),
+                    count('hello | @n:[100 200]'))
+
+    # results are still produced in doc id order, including across cursor reads
+    res, cursor = env.cmd('ft.aggregate', 'idx', '@tg:{odd}', 'LOAD', 1, '@n',
+                          'WITHCURSOR', 'COUNT', 1000)
+    rows = res[1:]
+    while cursor:
+        res, cursor = env.cmd('ft.cursor', 'read', 'idx', cursor)
+        rows += res[1:]
+    env.assertEqual([i for i in live if i % 2], [int(row[1]) for row in rows])
+
+def testGroupByTagCount(env):
+    env.skipOnCluster()
+    conn = env.getConnection()
+    env.cmd('ft.create', 'idx', 'ON', 'HASH',
+            'SCHEMA', 't', 'TEXT', 'tg', 'TAG', 'n', 'NUMERIC')
+    for i in range(1, 101):
+        if i % 10:
+            conn.execute_command('hset', 'doc%d' % i, 't', 'hello', 'n', i, 'tg', 'tag%d' % (i % 4))
+        else:
+            conn.execute_command('hset', 'doc%d' % i, 't', 'hello', 'n', i)
+    conn.execute_command('del', 'doc1')
+    live = range(2, 101)
+
+    def groups(q):
+        res = env.cmd('ft.aggregate', 'idx', q, 'GROUPBY', 1, '@tg',
+                      'REDUCE', 'COUNT', 0, 'AS', 'c')
+        return res[0], dict((row[1], int(row[3])) for row in res[1:])
+
+    def expected(ids):
+        ret = {}
+        for i in ids:
+            tag = 'tag%d' % (i % 4) if i % 10 else None
+            ret[tag] = ret.get(tag, 0) + 1
+        return len(ret), ret
+
+    env.assertEqual(expected(live), groups('*'))
+    env.assertEqual(expected([i for i in live if i <= 50]), groups('@n:[0 50]'))
+
+    # Tags which differ from the field values are grouped by the values, as before
+    conn.execute_command('hset', 'doc200', 't', 'hello', 'n', 200, 'tg', 'Tag1')
+    conn.execute_command('hset', 'doc201', 't', 'hello', 'n', 201, 'tg', 'tag1,tag2')
+    total, res = groups('*')
+    env.assertEqual(1, res['Tag1'])
+    env.assertEqual(1, res['tag1,tag2'])
+    env.assertEqual(expected(live)[1]['tag1'], res['tag1'])
+
+def testGroupByTagCountUnindexed(env):
+    env.skipOnCluster()
+    conn = env.getConnection()
+    # A NOINDEX tag field has no tag index, so its values are grouped by loading them
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TAG', 'NOINDEX')
+    for i in range(10):
+        conn.execute_command('hset', 'doc%d' % i, 't', 'tag%d' % (i % 2))
+    res = env.cmd('ft.aggregate', 'idx', '*', 'GROUPBY', 1, '@t', 'REDUCE', 'COUNT', 0, 'AS', 'c')
+    env.assertEqual({'tag0': 5, 'tag1': 5}, dict((row[1], int(row[3])) for row in res[1:]))
+
+    # Documents indexed before FT.ALTER added the field are not in its tag index
+    env.cmd('ft.create', 'idx2', 'ON', 'HASH', 'SCHEMA', 'n', 'NUMERIC')
+    for i in range(10):
+        conn.execute_command('hset', 'alt%d' % i, 'n', i, 'tg', 'tag%d' % (i % 2))
+    env.cmd('ft.alter', 'idx2', 'SCHEMA', 'ADD', 'tg', 'TAG')
+    conn.execute_command('hset', 'alt10', 'n', 10, 'tg', 'tag0')
+    res = env.cmd('ft.aggregate', 'idx2', '*', 'GROUPBY', 1, '@tg', 'REDUCE', 'COUNT', 0, 'AS', 'c')
+    env.assertEqual({'tag0': 6, 'tag1': 5}, dict((row[1], int(row[3])) for row in res[1:]))
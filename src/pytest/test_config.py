@@ -91,6 +91,8 @@ def testAllConfig(env):
     env.assertEqual(res_dict['FORK_GC_RETRY_INTERVAL'][0], '5')
     env.assertEqual(res_dict['CURSOR_MAX_IDLE'][0], '300000')
     env.assertEqual(res_dict['NO_MEM_POOLS'][0], 'false')
+    env.assertEqual(res_dict['UNION_ITERATOR_HEAP'][0], '20')
+    env.assertEqual(res_dict['QUERY_WORKERS'][0], '0')
 
     # skip ctest configured tests
     #env.assertEqual(res_dict['GC_POLICY'][0], 'fork')
@@ -120,6 +122,8 @@ def testInitConfig(env):
     test_arg_num('FORK_GC_CLEAN_THRESHOLD', 3)
     test_arg_num('FORK_GC_RETRY_INTERVAL', 3)
     test_arg_num('_MAX_RESULTS_TO_UNSORTED_MODE', 3)
+    test_arg_num('UNION_ITERATOR_HEAP', 30)
+    test_arg_num('QUERY_WORKERS', 4)
 
     # True/False arguments
     def test_arg_true(arg_name):
@@ -23,7 +23,7 @@ class TestDebugCommands(object):
     def testDebugHelp(self):
         err_msg = "wrong number of arguments for 'FT.DEBUG' command"
         help_list = ['DUMP_INVIDX', 'DUMP_NUMIDX', 'DUMP_TAGIDX', 'INFO_TAGIDX', 'IDTODOCID', 'DOCIDTOID', 'DOCINFO',
-                    'DUMP_PHONETIC_HASH', 'DUMP_TERMS', 'INVIDX_SUMMARY', 'NUMIDX_SUMMARY',
+                    'DUMP_PHONETIC_HASH', 'DUMP_TERMS', 'INVIDX_SUMMARY', 'NUMIDX_SUMMARY', 'NUMIDX_HISTOGRAM',
                     'GC_FORCEINVOKE', 'GC_FORCEBGINVOKE', 'GIT_SHA']
         self.env.expect('FT.DEBUG', 'help').equal(help_list)
 
@@ -162,6 +162,12 @@ class TestDebugCommands(object):
         self.env.expect('FT.DEBUG', 'NUMIDX_SUMMARY', 'idx', 'age').equal(['numRanges', 1L, 'numEntries', 1L,
                                                                            'lastDocId', 1L, 'revisionId', 0L])
 
+    def testNumericIdxHistogram(self):
+        self.env.expect('FT.DEBUG', 'numidx_histogram', 'idx', 'age').equal(['height', 1L, 'numLeaves', 1L,
+                                                                             'leafDepths', [1L], 'leafSizes', [1L]])
+        self.env.expect('FT.DEBUG', 'numidx_histogram', 'idx', 'age1').raiseError()
+        self.env.expect('FT.DEBUG', 'numidx_histogram', 'idx').raiseError()
+
     def testUnexistsNumericIndexSummary(self):
         self.env.expect('FT.DEBUG', 'numidx_summary', 'idx', 'age1').raiseError()
 
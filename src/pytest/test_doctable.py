@@ -1,13 +1,13 @@
 from RLTest import Env
 
 
-# mainly this test adding and removing docs while the doc table size is 100
+# mainly this test adding and removing docs while the (deprecated) doc table size is 100
 # and make sure we are not crashing and not leaking memory (when runs with valgrind).
 def testDocTable():
     env = Env(moduleArgs='MAXDOCTABLESIZE 100')
     env.assertOk(env.execute_command(
         'ft.create', 'idx', 'ON', 'HASH', 'schema', 'title', 'text', 'body', 'text'))
-    # doc table size is 100 so insearting 1000 docs should gives us 10 docs in each bucket
+    # inserting 1000 docs gives us 10 docs for each title
     for i in range(1000):
         env.assertOk(env.execute_command('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields',
                                          'title', 'hello world %d' % (i % 100),
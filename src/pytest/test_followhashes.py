@@ -1,4 +1,5 @@
 import unittest
+from time import sleep
 from includes import *
 
 def getConnectionByEnv(env):
@@ -198,3 +199,67 @@ def testMissingArgs(env):
     env.expect('FT.CREATE', 'idx', 'SCHEMA', 'txt', 'TEXT', 'num', 'NUMERIC').error()
     env.expect('FT.CREATE', 'idx', 'ON', 'SCHEMA', 'txt', 'TEXT', 'num', 'NUMERIC').error()
     env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'FILTER', 'SCHEMA', 'txt', 'TEXT', 'num', 'NUMERIC').error()
+
+def testCreateIndexesExistingKeys(env):
+    conn = getConnectionByEnv(env)
+    for i in range(100):
+        conn.execute_command('hset', 'thing:%d' % i, 'name', 'foo')
+    conn.execute_command('hset', 'other:1', 'name', 'foo')
+
+    env.expect('ft.create', 'things', 'ON', 'HASH',
+               'PREFIX', '1', 'thing:',
+               'SCHEMA', 'name', 'text').ok()
+
+    # the existing keys are indexed in the background
+    for _ in range(100):
+        res = env.cmd('ft.info', 'things')
+        d = {res[i]: res[i + 1] for i in range(0, len(res), 2)}
+        if d['indexing'] == '0':
+            break
+        sleep(0.1)
+    env.assertEqual(d['indexing'], '0')
+    env.assertEqual(d['percent_indexed'], '100')
+    env.expect('ft.search', 'things', 'foo', 'nocontent', 'limit', 0, 0).equal([100L])
+
+def testFilterWithPrefix(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'things', 'ON', 'HASH',
+               'PREFIX', '1', 'thing:',
+               'FILTER', '@age > 16',
+               'SCHEMA', 'name', 'text', 'age', 'numeric').ok()
+
+    conn.execute_command('hset', 'thing:1', 'name', 'foo', 'age', '42')
+    conn.execute_command('hset', 'thing:2', 'name', 'foo', 'age', '8')
+    conn.execute_command('hset', 'thing:3', 'name', 'foo')
+    conn.execute_command('hset', 'object:1', 'name', 'foo', 'age', '42')
+
+    env.expect('ft.search', 'things', 'foo', 'nocontent').equal([1L, 'thing:1'])
+
+    conn.execute_command('del', 'thing:1')
+    env.expect('ft.search', 'things', 'foo', 'nocontent').equal([0L])
+
+def testUpdateUnindexedFieldKeepsDocId(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'things', 'ON', 'HASH',
+               'SCHEMA', 'name', 'text', 'age', 'numeric', 'SORTABLE', 'NOINDEX').ok()
+
+    conn.execute_command('hset', 'thing:1', 'name', 'foo', 'age', '42')
+    env.expect('ft.debug', 'docidtoid', 'things', 'thing:1').equal(1)
+
+    # fields outside of the schema and NOINDEX fields do not require reindexing
+    conn.execute_command('hset', 'thing:1', 'counter', '1')
+    conn.execute_command('hset', 'thing:1', 'age', '43')
+    env.expect('ft.debug', 'docidtoid', 'things', 'thing:1').equal(1)
+    env.expect('ft.search', 'things', 'foo', 'sortby', 'age', 'return', '1', 'age').equal([1L, 'thing:1', ['age', '43']])
+
+    # deleting a NOINDEX sortable field clears its sortable value
+    conn.execute_command('hdel', 'thing:1', 'age')
+    env.expect('ft.debug', 'docidtoid', 'things', 'thing:1').equal(1)
+    env.expect('ft.aggregate', 'things', 'foo', 'groupby', '1', '@age').equal([1L, ['age', None]])
+    conn.execute_command('hset', 'thing:1', 'age', '43')
+
+    # changing an indexed field replaces the document
+    conn.execute_command('hset', 'thing:1', 'name', 'bar')
+    env.expect('ft.debug', 'docidtoid', 'things', 'thing:1').equal(2)
+    env.expect('ft.search', 'things', 'foo', 'nocontent').equal([0L])
+    env.expect('ft.search', 'things', 'bar', 'nocontent').equal([1L, 'thing:1'])
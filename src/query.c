@@ -1018,10 +1018,16 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
       s = doPad(s, depth);
       break;
     case QN_GEO:
-
-      s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", qs->gn.gf->property, qs->gn.gf->lon,
-                       qs->gn.gf->lat, qs->gn.gf->radius,
-                       GeoDistance_ToString(qs->gn.gf->unitType));
+      if (qs->gn.gf->shape == GEO_SHAPE_RADIUS) {
+        s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", qs->gn.gf->property, qs->gn.gf->lon,
+                         qs->gn.gf->lat, qs->gn.gf->radius,
+                         GeoDistance_ToString(qs->gn.gf->unitType));
+      } else {
+        const double *bb = qs->gn.gf->bbox;
+        s = sdscatprintf(s, "GEO%s %s:{%f,%f --> %f,%f",
+                         qs->gn.gf->shape == GEO_SHAPE_BOX ? "BOX" : "POLYGON",
+                         qs->gn.gf->property, bb[0], bb[1], bb[2], bb[3]);
+      }
       break;
     case QN_IDS:
 
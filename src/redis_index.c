@@ -8,6 +8,8 @@
 #include "util/misc.h"
 #include "tag_index.h"
 #include "rmalloc.h"
+#include "util/arr.h"
+#include "docid_bitmap.h"
 #include <stdio.h>
 
 RedisModuleType *InvertedIndexType;
@@ -50,6 +52,8 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
       RedisModule_Free(blk->buf.data);
       blk->buf.data = buf;
     }
+    IndexBlock_UpdateSkips(blk, idx->flags);
+    IndexBlock_NewUid(blk);
   }
   idx->size = actualSize;
   if (idx->size == 0) {
@@ -99,6 +103,12 @@ unsigned long InvertedIndex_MemUsage(const void *value) {
   for (size_t i = 0; i < idx->size; i++) {
     ret += sizeof(IndexBlock);
     ret += IndexBlock_DataLen(&idx->blocks[i]);
+    if (idx->blocks[i].skips) {
+      ret += array_len(idx->blocks[i].skips) * sizeof(IndexBlockSkip);
+    }
+  }
+  if (idx->bitmap) {
+    ret += DocIdBitmap_MemUsage(idx->bitmap);
   }
   return ret;
 }
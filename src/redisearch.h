@@ -62,31 +62,35 @@ typedef enum {
  * Flags is not currently used, but should be used in the future to mark documents as deleted, etc.
  */
 typedef struct RSDocumentMetadata_s {
+  /* The fields read by scorers come first, so they share the start of the metadata's cache line */
   t_docId id;
 
-  /* The actual key of the document, not the internal incremental id */
-  char *keyPtr;
-
   /* The a-priory document score as given by the user on insertion */
   float score;
 
   /* The maximum frequency of any term in the index, used to normalize frequencies */
   uint32_t maxFreq : 24;
 
+  /* Document flags  */
+  RSDocumentFlags flags : 8;
+
   /* The total weighted number of tokens in the document, weighted by field weights */
   uint32_t len : 24;
 
-  /* Document flags  */
-  RSDocumentFlags flags : 8;
+  uint32_t ref_count;
 
-  /* Optional user payload */
+  /* The actual key of the document, not the internal incremental id */
+  char *keyPtr;
+
+  /* Optional user payload, allocated together with its data */
   RSPayload *payload;
 
   struct RSSortingVector *sortVector;
-  /* Offsets of all terms in the document (in bytes). Used by highlighter */
+  /* Offsets of all terms in the document (in bytes), packed. Used by highlighter */
   struct RSByteOffsets *byteOffsets;
-  DLLIST2_node llnode;
-  uint32_t ref_count;
+
+  /* Digest of the indexed fields' values, used to skip reindexing unchanged hashes */
+  uint64_t fieldsDigest;
 } RSDocumentMetadata;
 
 /* Forward declaration of the opaque query object */
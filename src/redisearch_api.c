@@ -36,9 +36,6 @@ IndexSpec* RediSearch_CreateIndex(const char* name, const RSIndexOptions* option
   spec->getValueCtx = options->gvcbData;
   spec->minPrefix = 0;
   spec->maxPrefixExpansions = -1;
-  if (options->flags & RSIDXOPT_DOCTBLSIZE_UNLIMITED) {
-    spec->docs.maxSize = DOCID_MAX;
-  }
   if (options->gcPolicy != GC_POLICY_NONE) {
     IndexSpec_StartGCFromSpec(spec, GC_DEFAULT_HZ, options->gcPolicy);
   }
@@ -154,6 +151,7 @@ int RediSearch_DeleteDocument(IndexSpec* sp, const void* docKey, size_t len) {
     if (DocTable_Delete(&sp->docs, docKey, len)) {
       // Delete returns true/false, not RM_{OK,ERR}
       sp->stats.numDocuments--;
+      IndexSpec_ClearDocValues(sp, id);
     } else {
       rc = REDISMODULE_ERR;
     }
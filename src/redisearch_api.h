@@ -64,6 +64,7 @@ typedef int (*RSGetValueCallback)(void* ctx, const char* fieldName, const void*
 
 MODULE_API_FUNC(int, RediSearch_GetCApiVersion)();
 
+// Kept for compatibility, the document table has no size limit
 #define RSIDXOPT_DOCTBLSIZE_UNLIMITED 0x01
 
 #define GC_POLICY_NONE -1
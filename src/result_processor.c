@@ -4,6 +4,11 @@
 #include <util/minmax_heap.h>
 #include "ext/default.h"
 #include "rmutil/rm_assert.h"
+#include "util/arr.h"
+#include "doc_values.h"
+#include "geo_index.h"
+#include "tag_index.h"
+#include "docid_bitmap.h"
 
 /*******************************************************************************************************************
  *  General Result Processor Helper functions
@@ -61,6 +66,15 @@ typedef struct {
   IndexIterator *iiter;
 } RPIndexIterator;
 
+/* Check a document against the sorter's bound. Missing values are left for the sorter to order */
+static inline int sortBoundAccepts(const QueryIterator *q, t_docId docId) {
+  double d = NumericColumn_Get(q->sortBound.column, docId);
+  if (isnan(d)) {
+    return 1;
+  }
+  return q->sortBound.ascending ? d <= q->sortBound.value : d >= q->sortBound.value;
+}
+
 /* Next implementation */
 static int rpidxNext(ResultProcessor *base, SearchResult *res) {
   RPIndexIterator *self = (RPIndexIterator *)base;
@@ -92,6 +106,9 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
 
     // Increment the total results barring deleted results
     base->parent->totalResults++;
+    if (base->parent->sortBound.column && !sortBoundAccepts(base->parent, r->docId)) {
+      continue;
+    }
     break;
   }
 
@@ -118,6 +135,367 @@ ResultProcessor *RPIndexIterator_New(IndexIterator *root) {
   return &ret->base;
 }
 
+/*******************************************************************************************************************
+ *  Counter - a replacement for the base processor in queries that only ask for the number of results,
+ *  when it was already computed from the index. It adds the count to the total and yields nothing.
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  size_t count;
+} RPCounter;
+
+static int rpcountNext(ResultProcessor *base, SearchResult *res) {
+  RPCounter *self = (RPCounter *)base;
+  base->parent->totalResults += self->count;
+  self->count = 0;
+  return RS_RESULT_EOF;
+}
+
+static void rpcountFree(ResultProcessor *base) {
+  rm_free(base);
+}
+
+ResultProcessor *RPCounter_New(size_t count) {
+  RPCounter *ret = rm_calloc(1, sizeof(*ret));
+  ret->count = count;
+  ret->base.Next = rpcountNext;
+  ret->base.Free = rpcountFree;
+  ret->base.name = "Counter";
+  return &ret->base;
+}
+
+/*******************************************************************************************************************
+ *  Tag Counter - a replacement for the base processor and the grouper in facet-style aggregations,
+ *  which group by a tag field and only count the documents of each group.
+ *
+ * The matching doc ids are collected into a bitmap, and each tag's count is the size of its
+ * intersection with the bitmap, so no document is loaded. The groups are computed on the first
+ * call and yielded one per call.
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  IndexIterator *iiter;
+  const char *field;
+  t_docId maxDocId;
+  const RLookupKey *tagKey;
+  const RLookupKey **countKeys;
+  size_t ncountKeys;
+
+  // The tag of every group (RS_NULL for documents without the field) and its count
+  RSValue **tags;
+  size_t *counts;
+  size_t ngroups;
+  size_t curGroup;
+  int collected;
+} RPTagCounter;
+
+static void rptagcountAddGroup(RPTagCounter *self, RSValue *tag, size_t count) {
+  self->tags = rm_realloc(self->tags, (self->ngroups + 1) * sizeof(*self->tags));
+  self->counts = rm_realloc(self->counts, (self->ngroups + 1) * sizeof(*self->counts));
+  self->tags[self->ngroups] = tag;
+  self->counts[self->ngroups++] = count;
+}
+
+// Number of doc ids read, or tags counted, between checks of the query timeout
+#define TAGCOUNT_TIMEOUT_CHECK 1024
+
+/* Collect the groups. A query which times out stops collecting and keeps the groups counted so far,
+ * which are none if it timed out while reading the matching ids */
+static void rptagcountCollect(RPTagCounter *self) {
+  QueryIterator *q = self->base.parent;
+  RedisSearchCtx *sctx = q->sctx;
+  IndexIterator *it = self->iiter;
+  DocIdBitmap *docs = NewDocIdBitmap(self->maxDocId);
+  RSIndexResult *r;
+  int rc;
+  size_t nread = 0;
+
+  while (it && (rc = it->Read(it->ctx, &r)) != INDEXREAD_EOF) {
+    if (r && rc != INDEXREAD_NOTFOUND) {
+      if (r->docId > self->maxDocId) {
+        break;
+      }
+      RSDocumentMetadata *dmd = DocTable_Get(&sctx->spec->docs, r->docId);
+      if (dmd && !(dmd->flags & Document_Deleted)) {
+        DocIdBitmap_Add(docs, r->docId);
+      }
+    }
+    // Checked once the id is handled, so that stopping here does not drop it
+    if (++nread % TAGCOUNT_TIMEOUT_CHECK == 0 && QITR_CheckTimeout(q)) {
+      break;
+    }
+  }
+
+  size_t tagged = 0;
+  int allTags = q->state != QITR_S_TIMEDOUT;
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, self->field, strlen(self->field));
+  RedisModuleKey *key = NULL;
+  TagIndex *idx = NULL;
+  if (allTags && fs && FIELD_IS(fs, INDEXFLD_T_TAG)) {
+    idx = TagIndex_Open(sctx, IndexSpec_GetFormattedKey(sctx->spec, fs, INDEXFLD_T_TAG), 0, &key);
+  }
+  if (idx) {
+    TrieMapIterator *tmit = TrieMap_Iterate(idx->values, "", 0);
+    char *str;
+    tm_len_t slen;
+    void *ptr;
+    size_t ntags = 0;
+    while (TrieMapIterator_Next(tmit, &str, &slen, &ptr)) {
+      size_t count = TagIndex_CountDocs(ptr, docs);
+      if (count) {
+        rptagcountAddGroup(self, RS_NewCopiedString(str, slen), count);
+        tagged += count;
+      }
+      if (++ntags % TAGCOUNT_TIMEOUT_CHECK == 0 && QITR_CheckTimeout(q)) {
+        allTags = 0;
+        break;
+      }
+    }
+    TrieMapIterator_Free(tmit);
+  }
+  if (key) {
+    RedisModule_CloseKey(key);
+  }
+
+  // Documents of tags left uncounted are not known to be untagged
+  if (allTags && docs->numDocs > tagged) {
+    rptagcountAddGroup(self, RSValue_IncrRef(RS_NullVal()), docs->numDocs - tagged);
+  }
+  DocIdBitmap_Unref(docs);
+}
+
+static int rptagcountNext(ResultProcessor *base, SearchResult *res) {
+  RPTagCounter *self = (RPTagCounter *)base;
+  if (!self->collected) {
+    QueryIterator *q = base->parent;
+    self->collected = 1;
+    rptagcountCollect(self);
+    q->totalResults = self->ngroups;
+    if (q->state == QITR_S_TIMEDOUT && q->timeoutPolicy == TimeoutPolicy_Fail) {
+      QueryError_SetCode(q->err, QUERY_ETIMEDOUT);
+      return RS_RESULT_ERROR;
+    }
+  }
+  if (self->curGroup == self->ngroups) {
+    return RS_RESULT_EOF;
+  }
+
+  size_t ii = self->curGroup++;
+  RLookup_WriteKey(self->tagKey, &res->rowdata, self->tags[ii]);
+  for (size_t jj = 0; jj < self->ncountKeys; ++jj) {
+    RLookup_WriteOwnKey(self->countKeys[jj], &res->rowdata, RS_NumVal(self->counts[ii]));
+  }
+  return RS_RESULT_OK;
+}
+
+static void rptagcountFree(ResultProcessor *base) {
+  RPTagCounter *self = (RPTagCounter *)base;
+  for (size_t ii = 0; ii < self->ngroups; ++ii) {
+    RSValue_Decref(self->tags[ii]);
+  }
+  rm_free(self->tags);
+  rm_free(self->counts);
+  rm_free(self->countKeys);
+  rm_free(self);
+}
+
+ResultProcessor *RPTagCounter_New(IndexIterator *root, const char *field, t_docId maxDocId,
+                                  const RLookupKey *tagKey, const RLookupKey **countKeys,
+                                  size_t ncountKeys) {
+  RPTagCounter *ret = rm_calloc(1, sizeof(*ret));
+  ret->iiter = root;
+  ret->field = field;
+  ret->maxDocId = maxDocId;
+  ret->tagKey = tagKey;
+  ret->countKeys = rm_calloc(ncountKeys ? ncountKeys : 1, sizeof(*ret->countKeys));
+  memcpy(ret->countKeys, countKeys, ncountKeys * sizeof(*countKeys));
+  ret->ncountKeys = ncountKeys;
+  ret->base.Next = rptagcountNext;
+  ret->base.Free = rptagcountFree;
+  ret->base.name = "TagCounter";
+  return &ret->base;
+}
+
+/*******************************************************************************************************************
+ *  Parallel Index Processor - a drop-in replacement for the base processor which splits the doc id
+ *  space into ranges and scans them concurrently on the query thread pool.
+ *
+ * Every worker owns a separate iterator tree, evaluated from the same query. A round hands each
+ * worker the next range in turn, so the workers' trees only ever move forward. The matching ids are
+ * collected while the main thread holds the GIL and waits, so no writes can happen during a round;
+ * the results are then emitted in doc id order, exactly as the base processor would.
+ *
+ * Only ids are collected, so the results carry no index result. This is used for aggregations,
+ * which neither score nor highlight.
+ ********************************************************************************************************************/
+
+// Ranges are sized so that the index is covered in about this many rounds
+#define PARALLEL_SCAN_ROUNDS 4
+#define PARALLEL_SCAN_MAX_RANGE (1 << 16)
+
+typedef struct {
+  IndexIterator *it;
+  t_docId start;
+  t_docId end;
+  // A match read past the end of the previous range, or 0
+  t_docId lookahead;
+  int eof;
+  t_docId *docIds;
+} RangeScan;
+
+typedef struct {
+  RPIndexIterator base;
+  RangeScan *scans;
+  size_t nscans;
+  // The first id of the next round
+  t_docId nextStart;
+  // Position of the range and the id within it which are emitted next
+  size_t curScan;
+  size_t curId;
+} RPParallelIndexIterator;
+
+static void rangeScanPush(RangeScan *scan, t_docId docId) {
+  // Some iterators (e.g. wildcard) return the id they were skipped to again on the next read
+  size_t n = array_len(scan->docIds);
+  if (docId >= scan->start && (!n || docId > scan->docIds[n - 1])) {
+    scan->docIds = array_append(scan->docIds, docId);
+  }
+}
+
+/* Collect the matches of a worker's iterator in [start, end). Runs on the query pool */
+static void rangeScanRun(void *p) {
+  RangeScan *scan = p;
+  IndexIterator *it = scan->it;
+  RSIndexResult *r = NULL;
+  int rc;
+  array_clear(scan->docIds);
+
+  if (scan->eof || scan->lookahead >= scan->end) {
+    return;
+  }
+  if (scan->lookahead >= scan->start) {
+    rangeScanPush(scan, scan->lookahead);
+  } else {
+    rc = it->SkipTo(it->ctx, scan->start, &r);
+    if (rc == INDEXREAD_EOF) {
+      scan->eof = 1;
+      return;
+    }
+    // On NOTFOUND, readers return the next match. Iterators which have nothing to return (e.g. a
+    // negation on a rejected id) leave the requested id in the hit instead
+    if (rc == INDEXREAD_OK || (r && r->docId > scan->start)) {
+      if (r->docId >= scan->end) {
+        scan->lookahead = r->docId;
+        return;
+      }
+      rangeScanPush(scan, r->docId);
+    }
+  }
+  scan->lookahead = 0;
+
+  while (1) {
+    rc = it->Read(it->ctx, &r);
+    if (rc == INDEXREAD_EOF) {
+      scan->eof = 1;
+      return;
+    } else if (!r || rc == INDEXREAD_NOTFOUND) {
+      continue;
+    }
+    if (r->docId >= scan->end) {
+      scan->lookahead = r->docId;
+      return;
+    }
+    rangeScanPush(scan, r->docId);
+  }
+}
+
+/* Hand every worker its next range and wait for all of them. Returns 0 if the scan is done */
+static int rppidxRunRound(RPParallelIndexIterator *self) {
+  t_docId maxDocId = RP_SPEC(&self->base.base)->docs.maxDocId;
+  if (self->nextStart > maxDocId) {
+    return 0;
+  }
+  t_docId range = maxDocId / (self->nscans * PARALLEL_SCAN_ROUNDS);
+  range = MIN(MAX(range, PARALLEL_SCAN_MIN_RANGE), PARALLEL_SCAN_MAX_RANGE);
+  for (size_t ii = 0; ii < self->nscans; ++ii) {
+    RangeScan *scan = self->scans + ii;
+    scan->start = self->nextStart;
+    scan->end = scan->start + range;
+    self->nextStart = scan->end;
+    ConcurrentSearch_ThreadPoolRun(rangeScanRun, scan, CONCURRENT_POOL_QUERY);
+  }
+  ConcurrentSearch_ThreadPoolWait(CONCURRENT_POOL_QUERY);
+  self->curScan = 0;
+  self->curId = 0;
+  return 1;
+}
+
+static int rppidxNext(ResultProcessor *base, SearchResult *res) {
+  RPParallelIndexIterator *self = (RPParallelIndexIterator *)base;
+  RSDocumentMetadata *dmd;
+
+  while (1) {
+    if (self->curScan == self->nscans) {
+      if (!rppidxRunRound(self)) {
+        return RS_RESULT_EOF;
+      }
+    }
+    RangeScan *scan = self->scans + self->curScan;
+    if (self->curId == array_len(scan->docIds)) {
+      ++self->curScan;
+      self->curId = 0;
+      continue;
+    }
+
+    t_docId docId = scan->docIds[self->curId++];
+    dmd = DocTable_Get(&RP_SPEC(base)->docs, docId);
+    if (!dmd || (dmd->flags & Document_Deleted)) {
+      continue;
+    }
+
+    base->parent->totalResults++;
+    res->docId = docId;
+    res->indexResult = NULL;
+    res->score = 0;
+    res->dmd = dmd;
+    res->rowdata.sv = dmd->sortVector;
+    DMD_Incref(dmd);
+    return RS_RESULT_OK;
+  }
+}
+
+static void rppidxFree(ResultProcessor *base) {
+  RPParallelIndexIterator *self = (RPParallelIndexIterator *)base;
+  for (size_t ii = 0; ii < self->nscans; ++ii) {
+    // the first tree is the request's root iterator, which is freed with the request
+    if (ii) {
+      self->scans[ii].it->Free(self->scans[ii].it);
+    }
+    array_free(self->scans[ii].docIds);
+  }
+  rm_free(self->scans);
+  rm_free(self);
+}
+
+ResultProcessor *RPParallelIndexIterator_New(IndexIterator **its, size_t n) {
+  RPParallelIndexIterator *ret = rm_calloc(1, sizeof(*ret));
+  ret->base.iiter = its[0];
+  ret->scans = rm_calloc(n, sizeof(*ret->scans));
+  for (size_t ii = 0; ii < n; ++ii) {
+    ret->scans[ii].it = its[ii];
+    ret->scans[ii].docIds = array_new(t_docId, 64);
+  }
+  ret->nscans = n;
+  ret->nextStart = 1;
+  ret->curScan = n;
+  ret->base.base.Next = rppidxNext;
+  ret->base.base.Free = rppidxFree;
+  ret->base.base.name = "Index";
+  return &ret->base.base;
+}
+
 IndexIterator *QITR_GetRootFilter(QueryIterator *it) {
   return ((RPIndexIterator *)it->rootProc)->iiter;
 }
@@ -133,6 +511,24 @@ void QITR_PushRP(QueryIterator *it, ResultProcessor *rp) {
   it->endProc = rp;
 }
 
+int QITR_CheckTimeout(QueryIterator *it) {
+  if (it->state == QITR_S_TIMEDOUT) {
+    return 1;
+  }
+  if (!it->timeoutMS) {
+    return 0;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long long elapsedMS = (long long)(now.tv_sec - it->startTime.tv_sec) * 1000 +
+                        (now.tv_nsec - it->startTime.tv_nsec) / 1000000;
+  if (elapsedMS < it->timeoutMS) {
+    return 0;
+  }
+  it->state = QITR_S_TIMEDOUT;
+  return 1;
+}
+
 void QITR_FreeChain(QueryIterator *qitr) {
   ResultProcessor *rp = qitr->endProc;
   while (rp) {
@@ -214,6 +610,64 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
   return &ret->base;
 }
 
+/*******************************************************************************************************************
+ *  Geo Distance Processor
+ *
+ * Writes the distance of each result from the center of the query's geo filter into the row. The
+ * distance is computed from the point in the result's geo record, so the document is not loaded.
+ * The query must have no numeric filter, as its records could not be told apart from geo records.
+ ********************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  const GeoFilter *gf;
+  const RLookupKey *key;
+} RPGeoDistance;
+
+/* Find the geo record in a result's tree. Returns NULL if the filter did not match the result */
+static const RSIndexResult *findGeoRecord(const RSIndexResult *r) {
+  if (r->type == RSResultType_Numeric) {
+    return r;
+  }
+  if (r->type & RS_RESULT_AGGREGATE) {
+    for (int ii = 0; ii < r->agg.numChildren; ++ii) {
+      const RSIndexResult *found = findGeoRecord(r->agg.children[ii]);
+      if (found) {
+        return found;
+      }
+    }
+  }
+  return NULL;
+}
+
+static int rpgeodistNext(ResultProcessor *base, SearchResult *res) {
+  RPGeoDistance *self = (RPGeoDistance *)base;
+  int rc = base->upstream->Next(base->upstream, res);
+  if (rc != RS_RESULT_OK || !res->indexResult) {
+    return rc;
+  }
+  const RSIndexResult *rec = findGeoRecord(res->indexResult);
+  if (rec) {
+    RLookup_WriteOwnKey(self->key, &res->rowdata,
+                        RS_NumVal(GeoFilter_Distance(self->gf, rec->num.value)));
+  }
+  return rc;
+}
+
+static void rpgeodistFree(ResultProcessor *base) {
+  rm_free(base);
+}
+
+ResultProcessor *RPGeoDistance_New(const GeoFilter *gf, const RLookupKey *key) {
+  RPGeoDistance *ret = rm_calloc(1, sizeof(*ret));
+  ret->gf = gf;
+  ret->key = key;
+  ret->base.Next = rpgeodistNext;
+  ret->base.Free = rpgeodistFree;
+  ret->base.name = "GeoDistance";
+  return &ret->base;
+}
+
 /*******************************************************************************************************************
  *  Sorting Processor
  *
@@ -234,8 +688,15 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
  * Note: We use a min-max heap to simplify maintaining a max heap where we can pop from the bottom
  * while
  * finding the top N results
+ *
+ * Results are taken from blocks owned by the sorter. A result rejected by the heap, or popped out
+ * of it, is recycled for the next read, so finding the top N out of millions of matches only
+ * allocates the N results it keeps.
  ********************************************************************************************************************/
 
+// Size of the first block of results. Blocks double up to the size of the heap
+#define SORTER_FIRST_BLOCK 16
+
 typedef int (*RPSorterCompareFunc)(const void *e1, const void *e2, const void *udata);
 
 typedef struct {
@@ -260,14 +721,37 @@ typedef struct {
   // pooled result - we recycle it to avoid allocations
   SearchResult *pooledResult;
 
+  // Blocks the results are taken from, and the number of results used in the last one
+  SearchResult **blocks;
+  size_t lastBlockSize;
+  size_t lastBlockUsed;
+  size_t numAllocated;
+
+  // Whether to publish the bound of the first sort key to the index processor
+  int sortBound;
+
   struct {
     const RLookupKey **keys;
     size_t nkeys;
     uint64_t ascendMap;
+    // doc values columns of the keys, if they have one
+    const NumericColumn *columns[SORTASCMAP_MAXFIELDS];
   } fieldcmp;
 
 } RPSorter;
 
+/* Write a document's value from the column of a DOCVALUES key into its row, unless an earlier step
+ * already wrote the key */
+static void writeDocValue(const NumericColumn *col, const RLookupKey *kk, SearchResult *r) {
+  if (!r->dmd || RLookup_GetItem(kk, &r->rowdata)) {
+    return;
+  }
+  double d = NumericColumn_Get(col, r->docId);
+  if (!isnan(d)) {
+    RLookup_WriteOwnKey(kk, &r->rowdata, RS_NumVal(d));
+  }
+}
+
 /* Yield - pops the current top result from the heap */
 static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
@@ -277,8 +761,15 @@ static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
     RLookupRow oldrow = r->rowdata;
     *r = *sr;
 
-    rm_free(sr);
+    // The result's block is freed with the sorter
     RLookupRow_Cleanup(&oldrow);
+
+    // Keys compared from their columns are not in the row yet, but are part of the output
+    for (size_t ii = 0; ii < self->fieldcmp.nkeys && ii < SORTASCMAP_MAXFIELDS; ++ii) {
+      if (self->fieldcmp.columns[ii]) {
+        writeDocValue(self->fieldcmp.columns[ii], self->fieldcmp.keys[ii], r);
+      }
+    }
     return RS_RESULT_OK;
   }
   return RS_RESULT_EOF;
@@ -288,23 +779,71 @@ static void rpsortFree(ResultProcessor *rp) {
   RPSorter *self = (RPSorter *)rp;
   if (self->pooledResult) {
     SearchResult_Destroy(self->pooledResult);
-    rm_free(self->pooledResult);
   }
 
-  // calling mmh_free will free all the remaining results in the heap, if any
+  // calling mmh_free will destroy all the remaining results in the heap, if any
   mmh_free(self->pq);
+  for (size_t ii = 0; ii < array_len(self->blocks); ++ii) {
+    rm_free(self->blocks[ii]);
+  }
+  array_free(self->blocks);
   rm_free(rp);
 }
 
+/* Take a new, empty result from the sorter's blocks */
+static SearchResult *rpsortNewResult(RPSorter *self) {
+  if (!array_len(self->blocks) || self->lastBlockUsed == self->lastBlockSize) {
+    size_t n = self->lastBlockSize ? self->lastBlockSize * 2 : SORTER_FIRST_BLOCK;
+    // No more than the heap's size and the result being read are ever needed
+    if (self->size && self->numAllocated + n > self->size + 1) {
+      n = MAX(self->size + 1, self->numAllocated + 1) - self->numAllocated;
+    }
+    self->numAllocated += n;
+    self->blocks = array_append(self->blocks, rm_calloc(n, sizeof(SearchResult)));
+    self->lastBlockSize = n;
+    self->lastBlockUsed = 0;
+  }
+  return self->blocks[array_len(self->blocks) - 1] + self->lastBlockUsed++;
+}
+
 #define RESULT_QUEUED RS_RESULT_MAX + 1
 
+/* Read a sort key from its doc values column. Returns 0 if the value must be taken from the row
+ * instead - when the row does not come from an indexed document, or an earlier step wrote it */
+static inline int sortKeyFromColumn(const NumericColumn *col, const RLookupKey *kk,
+                                    const SearchResult *h, double *d) {
+  if (!col || !h->dmd) {
+    return 0;
+  }
+  if (h->rowdata.dyn && array_len(h->rowdata.dyn) > kk->dstidx && h->rowdata.dyn[kk->dstidx]) {
+    return 0;
+  }
+  *d = NumericColumn_Get(col, h->docId);
+  return 1;
+}
+
+/* Publish the first sort key of the heap's worst result as the bound for the index processor */
+static void rpsortUpdateBound(RPSorter *self) {
+  const NumericColumn *col = self->fieldcmp.columns[0];
+  if (!self->sortBound || !col) {
+    return;
+  }
+  const SearchResult *minh = mmh_peek_min(self->pq);
+  double d;
+  if (sortKeyFromColumn(col, self->fieldcmp.keys[0], minh, &d) && !isnan(d)) {
+    QueryIterator *q = self->base.parent;
+    q->sortBound.column = col;
+    q->sortBound.value = d;
+    q->sortBound.ascending = !!SORTASCMAP_GETASC(self->fieldcmp.ascendMap, 0);
+  }
+}
+
 static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
 
+  // A recycled result was already cleared when it was rejected
   if (self->pooledResult == NULL) {
-    self->pooledResult = rm_calloc(1, sizeof(*self->pooledResult));
-  } else {
-    RLookupRow_Wipe(&self->pooledResult->rowdata);
+    self->pooledResult = rpsortNewResult(self);
   }
 
   SearchResult *h = self->pooledResult;
@@ -331,6 +870,9 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
     if (h->score < rp->parent->minScore) {
       rp->parent->minScore = h->score;
     }
+    if (self->size && self->pq->count == self->size) {
+      rpsortUpdateBound(self);
+    }
 
   } else {
     // find the min result
@@ -347,6 +889,7 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
       self->pooledResult = mmh_pop_min(self->pq);
       mmh_insert(self->pq, h);
       SearchResult_Clear(self->pooledResult);
+      rpsortUpdateBound(self);
     } else {
       // The current should not enter the pool, so just leave it as is
       self->pooledResult = h;
@@ -356,8 +899,23 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
   return RESULT_QUEUED;
 }
 
+/* Look up the doc values columns of the sort keys. This is done on every accumulation pass, since
+ * the spec may have changed between cursor reads */
+static void rpsortResolveColumns(RPSorter *self) {
+  const IndexSpec *sp = NULL;
+  if (self->base.parent && self->base.parent->sctx) {
+    sp = self->base.parent->sctx->spec;
+  }
+  for (size_t ii = 0; ii < self->fieldcmp.nkeys && ii < SORTASCMAP_MAXFIELDS; ++ii) {
+    const RLookupKey *kk = self->fieldcmp.keys[ii];
+    self->fieldcmp.columns[ii] =
+        sp && (kk->flags & RLOOKUP_F_DVSRC) ? IndexSpec_GetNumericColumn(sp, kk->svidx) : NULL;
+  }
+}
+
 static int rpsortNext_Accum(ResultProcessor *rp, SearchResult *r) {
   int rc;
+  rpsortResolveColumns((RPSorter *)rp);
   while ((rc = rpsortNext_innerLoop(rp, r)) == RESULT_QUEUED) {
     // Do nothing.
   }
@@ -388,10 +946,28 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
   }
 
   for (size_t i = 0; i < self->fieldcmp.nkeys && i < SORTASCMAP_MAXFIELDS; i++) {
-    const RSValue *v1 = RLookup_GetItem(self->fieldcmp.keys[i], &h1->rowdata);
-    const RSValue *v2 = RLookup_GetItem(self->fieldcmp.keys[i], &h2->rowdata);
     // take the ascending bit for this property from the ascending bitmap
     ascending = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, i);
+
+    const RLookupKey *kk = self->fieldcmp.keys[i];
+    const NumericColumn *col = self->fieldcmp.columns[i];
+    double d1, d2;
+    if (sortKeyFromColumn(col, kk, h1, &d1) && sortKeyFromColumn(col, kk, h2, &d2)) {
+      int rc;
+      if (isnan(d1) || isnan(d2)) {
+        // missing values, ordered the same way as below
+        rc = !isnan(d1) ? 1 : !isnan(d2) ? -1 : (h1->docId < h2->docId ? -1 : 1);
+        return ascending ? -rc : rc;
+      }
+      if (d1 != d2) {
+        rc = d1 > d2 ? 1 : -1;
+        return ascending ? -rc : rc;
+      }
+      continue;
+    }
+
+    const RSValue *v1 = RLookup_GetItem(kk, &h1->rowdata);
+    const RSValue *v2 = RLookup_GetItem(kk, &h2->rowdata);
     if (!v1 || !v2) {
       int rc;
       if (v1) {
@@ -421,7 +997,6 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
 static void srDtor(void *p) {
   if (p) {
     SearchResult_Destroy(p);
-    rm_free(p);
   }
 }
 
@@ -438,6 +1013,7 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
   ret->size = maxresults;
   ret->offset = 0;
   ret->pooledResult = NULL;
+  ret->blocks = array_new(SearchResult *, 4);
   ret->base.Next = rpsortNext_Accum;
   ret->base.Free = rpsortFree;
   ret->base.name = "Sorter";
@@ -448,6 +1024,10 @@ ResultProcessor *RPSorter_NewByScore(size_t maxresults) {
   return RPSorter_NewByFields(maxresults, NULL, 0, 0);
 }
 
+void RPSorter_EnableSortBound(ResultProcessor *rp) {
+  ((RPSorter *)rp)->sortBound = 1;
+}
+
 void SortAscMap_Dump(uint64_t tt, size_t n) {
   for (size_t ii = 0; ii < n; ++ii) {
     if (SORTASCMAP_GETASC(tt, ii)) {
@@ -545,7 +1125,6 @@ static int rploaderNext(ResultProcessor *base, SearchResult *r) {
   if (r->dmd == NULL || (r->dmd->flags & Document_Deleted)) {
     return RS_RESULT_OK;
   }
-  RedisSearchCtx *sctx = lc->base.parent->sctx;
 
   QueryError status = {0};
   RLookupLoadOptions loadopts = {.sctx = lc->base.parent->sctx,  // lb
@@ -583,6 +1162,52 @@ ResultProcessor *RPLoader_New(RLookup *lk, const RLookupKey **keys, size_t nkeys
   return &sc->base;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/// Doc Values Loader                                                        ///
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  ResultProcessor base;
+  const RLookupKey **keys;
+  size_t nkeys;
+} RPDocValues;
+
+static int rpdvNext(ResultProcessor *base, SearchResult *r) {
+  RPDocValues *self = (RPDocValues *)base;
+  int rc = base->upstream->Next(base->upstream, r);
+  if (rc != RS_RESULT_OK) {
+    return rc;
+  }
+  // The columns are looked up for every result, since the spec may change between cursor reads
+  const IndexSpec *sp = RP_SPEC(base);
+  for (size_t ii = 0; ii < self->nkeys; ++ii) {
+    const NumericColumn *col = IndexSpec_GetNumericColumn(sp, self->keys[ii]->svidx);
+    if (col) {
+      writeDocValue(col, self->keys[ii], r);
+    }
+  }
+  return RS_RESULT_OK;
+}
+
+static void rpdvFree(ResultProcessor *base) {
+  RPDocValues *self = (RPDocValues *)base;
+  rm_free(self->keys);
+  rm_free(self);
+}
+
+ResultProcessor *RPDocValues_New(const RLookupKey **keys, size_t nkeys) {
+  RPDocValues *ret = rm_calloc(1, sizeof(*ret));
+  ret->nkeys = nkeys;
+  ret->keys = rm_calloc(nkeys, sizeof(*ret->keys));
+  memcpy(ret->keys, keys, sizeof(*keys) * nkeys);
+  ret->base.Next = rpdvNext;
+  ret->base.Free = rpdvFree;
+  ret->base.name = "DocValues";
+  return &ret->base;
+}
+
 void RP_DumpChain(const ResultProcessor *rp) {
   for (; rp; rp = rp->upstream) {
     printf("RP(%s) @%p\n", rp->name, rp);
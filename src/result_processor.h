@@ -11,6 +11,7 @@
 #include "rlookup.h"
 #include "extension.h"
 #include "score_explain.h"
+#include "config.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,7 @@ typedef enum {
 
 struct ResultProcessor;
 struct RLookup;
+struct NumericColumn;
 
 typedef struct {
   // First processor
@@ -63,6 +65,14 @@ typedef struct {
   // the minimal score applicable for a result. It can be used to optimize the scorers
   double minScore;
 
+  // A bound on the first sort key, set by a sorter whose heap is full. Results with a worse key can
+  // not make it into the heap, so the index processor drops them before they are materialized
+  struct {
+    const struct NumericColumn *column;
+    double value;
+    int ascending;
+  } sortBound;
+
   // the total results found in the query, incremented by the root processors and decremented by
   // others who might disqualify results
   uint32_t totalResults;
@@ -74,12 +84,20 @@ typedef struct {
   QITRState state;
 
   struct timespec startTime;
+  // Query timeout in milliseconds from startTime, 0 for none
+  uint32_t timeoutMS;
+  // What to do once the query timed out: return what it has, or fail
+  RSTimeoutPolicy timeoutPolicy;
 } QueryIterator, QueryProcessingCtx;
 
 IndexIterator *QITR_GetRootFilter(QueryIterator *it);
 void QITR_PushRP(QueryIterator *it, struct ResultProcessor *rp);
 void QITR_FreeChain(QueryIterator *qitr);
 
+/* Check whether the query ran past its timeout, moving it to the QITR_S_TIMEDOUT state if it did.
+ * Reads the clock, so long loops should only call it every so many iterations */
+int QITR_CheckTimeout(QueryIterator *it);
+
 /*
  * SearchResult - the object all the processing chain is working on.
  * It has the indexResult which is what the index scan brought - scores, vectors, flags, etc.
@@ -174,9 +192,39 @@ void SearchResult_Destroy(SearchResult *r);
 
 ResultProcessor *RPIndexIterator_New(IndexIterator *itr);
 
+/* Used instead of RPIndexIterator when only the number of results is needed and it is already
+ * known. Reports `count` results without yielding any */
+ResultProcessor *RPCounter_New(size_t count);
+
+/**
+ * Used instead of RPIndexIterator and a grouper for aggregations grouping by a tag field with only
+ * COUNT reducers (see TagIndex::valuesAreTags). Yields a row per tag of `field` found in the
+ * matching documents, with the tag in `tagKey` and its number of documents in each of `countKeys`,
+ * and a row with a NULL tag for documents without the field. Documents after maxDocId are skipped.
+ * The root iterator must be sorted, and remains owned by the caller.
+ */
+ResultProcessor *RPTagCounter_New(IndexIterator *root, const char *field, t_docId maxDocId,
+                                  const RLookupKey *tagKey, const RLookupKey **countKeys,
+                                  size_t ncountKeys);
+
+// Smallest number of doc ids handed to a worker of RPParallelIndexIterator at once
+#define PARALLEL_SCAN_MIN_RANGE 1024
+
+/**
+ * Same as RPIndexIterator, but scans the doc id space in ranges on the query thread pool. Each of
+ * the `n` iterators is a separate tree for the same query, used by a single worker. The first one
+ * is the request's root iterator and remains owned by the caller; the others are freed with the
+ * processor. Results carry no index result.
+ */
+ResultProcessor *RPParallelIndexIterator_New(IndexIterator **its, size_t n);
+
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const ScoringFunctionArgs *fnargs);
 
+/* Writes each result's distance from the center of the geo filter into `key`, in the filter's
+ * unit. Results for which the filter did not match are left without a distance */
+ResultProcessor *RPGeoDistance_New(const struct GeoFilter *gf, const RLookupKey *key);
+
 /** Functions abstracting the sortmap. Hides the bitwise logic */
 #define SORTASCMAP_INIT 0xFFFFFFFFFFFFFFFF
 #define SORTASCMAP_MAXFIELDS 8
@@ -190,6 +238,10 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
 
 ResultProcessor *RPSorter_NewByScore(size_t maxresults);
 
+/* Let the sorter push the bound of its first sort key down to the index processor. Only valid if
+ * nothing between the index and the sorter writes the sort keys */
+void RPSorter_EnableSortBound(ResultProcessor *rp);
+
 ResultProcessor *RPPager_New(size_t offset, size_t limit);
 
 /*******************************************************************************************************************
@@ -203,6 +255,10 @@ ResultProcessor *RPPager_New(size_t offset, size_t limit);
  *******************************************************************************************************************/
 ResultProcessor *RPLoader_New(RLookup *lk, const RLookupKey **keys, size_t nkeys);
 
+/* Write the values of DOCVALUES (RLOOKUP_F_DVSRC) keys from their columns into the results' rows,
+ * for the steps which read them from the row. Keys already written by an earlier step are kept */
+ResultProcessor *RPDocValues_New(const RLookupKey **keys, size_t nkeys);
+
 /** Creates a new Highlight processor */
 ResultProcessor *RPHighlighter_New(const RSSearchOptions *searchopts, const FieldList *fields,
                                    const RLookup *lookup);
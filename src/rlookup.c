@@ -52,6 +52,9 @@ static RLookupKey *genKeyFromSpec(RLookup *lookup, const char *name, int flags)
   if (FieldSpec_IsSortable(fs)) {
     ret->flags |= RLOOKUP_F_SVSRC;
     ret->svidx = fs->sortIdx;
+  } else if (FieldSpec_HasDocValues(fs)) {
+    ret->flags |= RLOOKUP_F_DVSRC;
+    ret->svidx = fs->sortIdx;
   }
   ret->flags |= RLOOKUP_F_DOCSRC;
   if (fs->types == INDEXFLD_T_NUMERIC) {
@@ -214,6 +217,9 @@ void RLookupRow_Dump(const RLookupRow *rr) {
 }
 
 void RLookupKey_FreeInternal(RLookupKey *k) {
+  if (k->hname) {
+    RedisModule_FreeString(RSDummyContext, k->hname);
+  }
   if (k->flags & RLOOKUP_F_NAMEALLOC) {
     rm_free((void *)k->name);
   }
@@ -284,53 +290,114 @@ static RSValue *replyElemToValue(RedisModuleCallReply *rep, RLookupCoerceType ot
   }
 }
 
-static int getKeyCommon(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOptions *options,
-                        RedisModuleKey **keyobj) {
-  if (!options->noSortables && (kk->flags & RLOOKUP_F_SVSRC)) {
-    // No need to "write" this key. It's always implicitly loaded!
+// Most fields fetched from a hash by a single HashGet call
+#define LOAD_FIELDS_PER_CALL 4
+
+static int openDocumentKey(RLookupLoadOptions *options, RedisModuleKey **keyobj) {
+  RedisModuleCtx *ctx = options->sctx->redisCtx;
+  RedisModuleString *keyName =
+      RedisModule_CreateString(ctx, options->dmd->keyPtr, strlen(options->dmd->keyPtr));
+  *keyobj = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ);
+  RedisModule_FreeString(ctx, keyName);
+  if (!*keyobj) {
+    QueryError_SetCode(options->status, QUERY_ENODOC);
+    return REDISMODULE_ERR;
+  }
+  if (RedisModule_KeyType(*keyobj) != REDISMODULE_KEYTYPE_HASH) {
+    QueryError_SetCode(options->status, QUERY_EREDISKEYTYPE);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+/* The field name as a Redis string. It is kept with the key, so every document of the query is
+ * read with the same string */
+static RedisModuleString *keyHashName(const RLookupKey *kk) {
+  if (!kk->hname) {
+    RedisModuleString *hname = RedisModule_CreateString(RSDummyContext, kk->name, strlen(kk->name));
+    ((RLookupKey *)kk)->hname = hname;
+  }
+  return kk->hname;
+}
+
+/* Fields of a document waiting to be read from its hash */
+typedef struct {
+  const RLookupKey *keys[LOAD_FIELDS_PER_CALL];
+  size_t n;
+  // Opened with the first read, closed by the caller
+  RedisModuleKey *keyobj;
+} PendingLoad;
+
+/* Read the pending fields of the document with a single HashGet call */
+static int flushPendingLoad(PendingLoad *pl, RLookupRow *dst, RLookupLoadOptions *options) {
+  size_t n = pl->n;
+  pl->n = 0;
+  if (!n) {
     return REDISMODULE_OK;
   }
+  if (!pl->keyobj && openDocumentKey(options, &pl->keyobj) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
 
-  // In this case, the flag must be obtained via HGET
-  if (!*keyobj) {
-    RedisModuleCtx *ctx = options->sctx->redisCtx;
-    RedisModuleString *keyName =
-        RedisModule_CreateString(ctx, options->dmd->keyPtr, strlen(options->dmd->keyPtr));
-    *keyobj = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ);
-    RedisModule_FreeString(ctx, keyName);
-    if (!*keyobj) {
-      QueryError_SetCode(options->status, QUERY_ENODOC);
-      return REDISMODULE_ERR;
+  RedisModuleString *f[LOAD_FIELDS_PER_CALL], *v[LOAD_FIELDS_PER_CALL] = {NULL};
+  for (size_t ii = 0; ii < n; ++ii) {
+    f[ii] = keyHashName(pl->keys[ii]);
+  }
+  RedisModuleKey *kobj = pl->keyobj;
+  int rc;
+  switch (n) {
+    case 1:
+      rc = RedisModule_HashGet(kobj, REDISMODULE_HASH_NONE, f[0], &v[0], NULL);
+      break;
+    case 2:
+      rc = RedisModule_HashGet(kobj, REDISMODULE_HASH_NONE, f[0], &v[0], f[1], &v[1], NULL);
+      break;
+    case 3:
+      rc = RedisModule_HashGet(kobj, REDISMODULE_HASH_NONE, f[0], &v[0], f[1], &v[1], f[2], &v[2],
+                               NULL);
+      break;
+    default:
+      rc = RedisModule_HashGet(kobj, REDISMODULE_HASH_NONE, f[0], &v[0], f[1], &v[1], f[2], &v[2],
+                               f[3], &v[3], NULL);
+      break;
+  }
+
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (!v[ii]) {
+      continue;
     }
-    if (RedisModule_KeyType(*keyobj) != REDISMODULE_KEYTYPE_HASH) {
-      QueryError_SetCode(options->status, QUERY_EREDISKEYTYPE);
-      return REDISMODULE_ERR;
+    if (rc == REDISMODULE_OK) {
+      // Value has a reference count of 1
+      RSValue *rsv = hvalToValue(v[ii], pl->keys[ii]->fieldtype);
+      RLookup_WriteKey(pl->keys[ii], dst, rsv);
+      RSValue_Decref(rsv);
     }
+    RedisModule_FreeString(RSDummyContext, v[ii]);
   }
+  return REDISMODULE_OK;
+}
 
-  // Get the actual hash value
-  RedisModuleString *val = NULL;
-  int rc = RedisModule_HashGet(*keyobj, REDISMODULE_HASH_CFIELDS, kk->name, &val, NULL);
-  if (rc != REDISMODULE_OK || val == NULL) {
+static int addPendingLoad(PendingLoad *pl, const RLookupKey *kk, RLookupRow *dst,
+                          RLookupLoadOptions *options) {
+  if (!options->noSortables && (kk->flags & RLOOKUP_F_SVSRC)) {
+    // No need to "write" this key. It's always implicitly loaded!
     return REDISMODULE_OK;
   }
-
-  // Value has a reference count of 1
-  RSValue *rsv = hvalToValue(val, kk->fieldtype);
-  RedisModule_FreeString(RSDummyContext, val);
-  RLookup_WriteKey(kk, dst, rsv);
-  RSValue_Decref(rsv);
+  pl->keys[pl->n++] = kk;
+  if (pl->n == LOAD_FIELDS_PER_CALL) {
+    return flushPendingLoad(pl, dst, options);
+  }
   return REDISMODULE_OK;
 }
 
 static int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options) {
   // Load the document from the schema. This should be simple enough...
-  RedisModuleKey *key = NULL;  // This is populated by getKeyCommon; we free it at the end
+  PendingLoad pl = {.n = 0};  // The key is opened by the first read; we free it at the end
   int rc = REDISMODULE_ERR;
   if (options->nkeys) {
     for (size_t ii = 0; ii < options->nkeys; ++ii) {
       const RLookupKey *kk = options->keys[ii];
-      if (getKeyCommon(kk, dst, options, &key) != REDISMODULE_OK) {
+      if (addPendingLoad(&pl, kk, dst, options) != REDISMODULE_OK) {
         goto done;
       }
     }
@@ -346,16 +413,19 @@ static int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *
           continue;
         }
       }
-      if (getKeyCommon(kk, dst, options, &key) != REDISMODULE_OK) {
+      if (addPendingLoad(&pl, kk, dst, options) != REDISMODULE_OK) {
         goto done;
       }
     }
   }
+  if (flushPendingLoad(&pl, dst, options) != REDISMODULE_OK) {
+    goto done;
+  }
   rc = REDISMODULE_OK;
 
 done:
-  if (key) {
-    RedisModule_CloseKey(key);
+  if (pl.keyobj) {
+    RedisModule_CloseKey(pl.keyobj);
   }
   return rc;
 }
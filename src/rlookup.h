@@ -61,7 +61,8 @@ typedef struct RLookupKey {
 
   /**
    * If the source of this value points to a sort vector, then this is the
-   * index within the sort vector that the value is located
+   * index within the sort vector that the value is located. For F_DVSRC keys,
+   * this is the index of the field's doc values column instead
    */
   uint16_t svidx;
 
@@ -79,6 +80,9 @@ typedef struct RLookupKey {
   /** Name of this field */
   const char *name;
 
+  /** The name as a Redis string, created the first time the field is read from a hash */
+  RedisModuleString *hname;
+
   /** Pointer to next field in the list */
   struct RLookupKey *next;
 } RLookupKey;
@@ -175,6 +179,14 @@ typedef struct {
  */
 #define RLOOKUP_F_EXPLICITRETURN 0x400
 
+/**
+ * The field has a doc values column, see IndexSpec_GetNumericColumn(). Its
+ * values are not in the sorting vector, so readers which can not use the
+ * column have to load it into the row first, as they would for any other
+ * F_DOCSRC key
+ */
+#define RLOOKUP_F_DVSRC 0x800
+
 /**
  * These flags do not persist to the key, they are just options to GetKey()
  */
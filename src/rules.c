@@ -1,5 +1,6 @@
 #include "rules.h"
 #include "aggregate/expr/expression.h"
+#include "aggregate/expr/exprprog.h"
 #include "spec.h"
 
 arrayof(SchemaRule *) SchemaRules_g;
@@ -33,6 +34,100 @@ int SchemaRuleType_Parse(const char *type_str, SchemaRuleType *type, QueryError
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
+#define RULE_KEYNAME_PROPERTY "__key"
+
+static void collectFilterFields(const RSExpr *e, arrayof(char *) * fields) {
+  switch (e->t) {
+    case RSExpr_Property:
+      if (!strcmp(e->property.key, RULE_KEYNAME_PROPERTY)) {
+        return;
+      }
+      for (size_t i = 0; i < array_len(*fields); ++i) {
+        if (!strcmp((*fields)[i], e->property.key)) {
+          return;
+        }
+      }
+      *fields = array_append(*fields, rm_strdup(e->property.key));
+      break;
+    case RSExpr_Function:
+      for (size_t i = 0; i < e->func.args->len; ++i) {
+        collectFilterFields(e->func.args->args[i], fields);
+      }
+      break;
+    case RSExpr_Op:
+      collectFilterFields(e->op.left, fields);
+      collectFilterFields(e->op.right, fields);
+      break;
+    case RSExpr_Predicate:
+      collectFilterFields(e->pred.left, fields);
+      collectFilterFields(e->pred.right, fields);
+      break;
+    case RSExpr_Inverted:
+      collectFilterFields(e->inverted.child, fields);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Resolve the filter's properties into lookup keys once, so evaluating it per key needs
+ * neither a new lookup nor a full load of the hash.
+ */
+static int SchemaRule_PrepareFilter(SchemaRule *rule, QueryError *status) {
+  rule->filter_fields = array_new(char *, 1);
+  collectFilterFields(rule->filter_exp, &rule->filter_fields);
+
+  EvalCtx *r = EvalCtx_FromExpr(rule->filter_exp);
+  rule->filter_ctx = r;
+  rule->filter_keyname = RLookup_GetKey(&r->lk, RULE_KEYNAME_PROPERTY, RLOOKUP_F_OCREAT);
+  rule->filter_keys = array_new(RLookupKey *, array_len(rule->filter_fields));
+  for (size_t i = 0; i < array_len(rule->filter_fields); ++i) {
+    RLookupKey *kk = RLookup_GetKey(&r->lk, rule->filter_fields[i], RLOOKUP_F_OCREAT);
+    rule->filter_keys = array_append(rule->filter_keys, kk);
+  }
+
+  r->ee.root = rule->filter_exp;
+  if (ExprAST_GetLookupKeys(rule->filter_exp, &r->lk, status) != EXPR_EVAL_OK) {
+    return REDISMODULE_ERR;
+  }
+  r->ee.prog = ExprProgram_Compile(rule->filter_exp);
+  return REDISMODULE_OK;
+}
+
+bool SchemaRule_FilterPasses(SchemaRule *rule, RedisModuleString *keyname, RedisModuleKey *key) {
+  if (!rule->filter_exp) {
+    return true;
+  }
+
+  EvalCtx *r = rule->filter_ctx;
+  bool passes = false;
+  RLookup_WriteOwnKey(rule->filter_keyname, &r->row, RS_RedisStringVal(keyname));
+
+  for (size_t i = 0; i < array_len(rule->filter_fields); ++i) {
+    RedisModuleString *val = NULL;
+    if (key) {
+      RedisModule_HashGet(key, REDISMODULE_HASH_CFIELDS, rule->filter_fields[i], &val, NULL);
+    }
+    if (!val) {
+      // A filter referencing a missing field never matches
+      goto done;
+    }
+    RLookup_WriteOwnKey(rule->filter_keys[i], &r->row, RS_OwnRedisStringVal(val));
+  }
+
+  if (ExprEval_Eval(&r->ee, &r->res) == EXPR_EVAL_OK) {
+    passes = RSValue_BoolTest(&r->res);
+  }
+
+done:
+  RSValue_Clear(&r->res);
+  RLookupRow_Wipe(&r->row);
+  BlkAlloc_Clear(&r->ee.stralloc, NULL, NULL, 0);
+  QueryError_ClearError(&r->status);
+  return passes;
+}
+
 SchemaRule *SchemaRule_Create(SchemaRuleArgs *args, IndexSpec *spec, QueryError *status) {
   SchemaRule *rule = rm_calloc(1, sizeof(*rule));
 
@@ -59,6 +154,9 @@ SchemaRule *SchemaRule_Create(SchemaRuleArgs *args, IndexSpec *spec, QueryError
       QueryError_SetError(status, QUERY_EADDARGS, "Invalid expression");
       goto error;
     }
+    if (SchemaRule_PrepareFilter(rule, status) != REDISMODULE_OK) {
+      goto error;
+    }
   }
 
   for (int i = 0; i < array_len(rule->prefixes); ++i) {
@@ -81,6 +179,13 @@ void SchemaRule_Free(SchemaRule *rule) {
   rm_free((void *)rule->score_field);
   rm_free((void *)rule->payload_field);
   rm_free((void *)rule->filter_exp_str);
+  if (rule->filter_ctx) {
+    EvalCtx_Destroy(rule->filter_ctx);
+  }
+  if (rule->filter_fields) {
+    array_free_ex(rule->filter_fields, rm_free(*(char **)ptr));
+  }
+  array_free(rule->filter_keys);
   if (rule->filter_exp) {
     ExprAST_Free((RSExpr *)rule->filter_exp);
   }
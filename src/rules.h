@@ -9,6 +9,8 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 struct RSExpr;
+struct EvalCtx;
+struct RLookupKey;
 struct IndexSpec;
 
 typedef enum { SchameRuleType_Any, SchemaRuleType_Hash } SchemaRuleType;
@@ -34,6 +36,12 @@ typedef struct SchemaRule {
   arrayof(const char *) prefixes;
   char *filter_exp_str;
   struct RSExpr *filter_exp;
+  // Evaluation context of filter_exp, prepared once so that matching a key only needs to load
+  // the hash fields referenced by the filter
+  struct EvalCtx *filter_ctx;
+  struct RLookupKey *filter_keyname;
+  arrayof(char *) filter_fields;
+  arrayof(struct RLookupKey *) filter_keys;
   char *lang_field;
   char *score_field;
   char *payload_field;
@@ -54,6 +62,13 @@ double SchemaRule_HashScore(RedisModuleCtx *rctx, const SchemaRule *rule, RedisM
 RedisModuleString *SchemaRule_HashPayload(RedisModuleCtx *rctx, const SchemaRule *rule,
                                           RedisModuleKey *key, const char *kname);
 
+/**
+ * Evaluate the rule's filter for the given key. Only the hash fields referenced by the filter
+ * are read from `key` (which may be NULL if the key does not exist).
+ * Rules without a filter always pass.
+ */
+bool SchemaRule_FilterPasses(SchemaRule *rule, RedisModuleString *keyname, RedisModuleKey *key);
+
 void SchemaRule_RdbSave(SchemaRule *rule, RedisModuleIO *rdb);
 int SchemaRule_RdbLoad(struct IndexSpec *sp, RedisModuleIO *rdb, int encver);
 
@@ -67,7 +67,8 @@ typedef enum {
   Search_Verbatim = 0x02,
   Search_NoStopwrods = 0x04,
   Search_InOrder = 0x20,
-  Search_HasSlop = 0x200
+  Search_HasSlop = 0x200,
+  Search_PruneScores = 0x400
 } RSSearchFlags;
 
 #define RS_DEFAULT_QUERY_FLAGS 0x00
@@ -98,6 +99,8 @@ typedef struct {
   struct {
     NumericFilter **filters;
     GeoFilter *gf;
+    // A GEOBOX or GEOPOLYGON filter
+    GeoFilter *shape;
     const char **infields;
     size_t ninfields;
   } legacy;
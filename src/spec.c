@@ -6,6 +6,7 @@
 #include "trie/trie_type.h"
 #include <math.h>
 #include <ctype.h>
+#include <sched.h>
 #include "rmalloc.h"
 #include "config.h"
 #include "cursor.h"
@@ -17,6 +18,8 @@
 #include "rmutil/rm_assert.h"
 #include "aggregate/expr/expression.h"
 #include "rules.h"
+#include "doc_values.h"
+#include "numeric_runs.h"
 #include "commands.h"
 
 void (*IndexSpec_OnCreate)(const IndexSpec *) = NULL;
@@ -92,6 +95,75 @@ int IndexSpec_GetFieldSortingIndex(IndexSpec *sp, const char *name, size_t len)
   return RSSortingTable_GetFieldIdx(sp->sortables, name);
 }
 
+/* The number of doc values columns of the fields before the given position */
+static int IndexSpec_CountDocValues(const IndexSpec *sp, size_t beforeField) {
+  int n = 0;
+  for (size_t ii = 0; ii < beforeField; ++ii) {
+    n += !!FieldSpec_HasDocValues(sp->fields + ii);
+  }
+  return n;
+}
+
+/* Create the doc values columns of fields starting at the given position */
+static void IndexSpec_InitDocValues(IndexSpec *sp, size_t fromField) {
+  for (size_t ii = fromField; ii < sp->numFields; ++ii) {
+    const FieldSpec *fs = sp->fields + ii;
+    if (!FieldSpec_HasDocValues(fs)) {
+      continue;
+    }
+    if (!sp->docValues) {
+      sp->docValues = rm_calloc(RS_SORTABLES_MAX, sizeof(*sp->docValues));
+    }
+    sp->docValues[fs->sortIdx] = NewNumericColumn();
+  }
+}
+
+NumericColumn *IndexSpec_GetNumericColumn(const IndexSpec *sp, int idx) {
+  if (!sp->docValues || idx < 0 || idx >= RS_SORTABLES_MAX) {
+    return NULL;
+  }
+  return sp->docValues[idx];
+}
+
+void IndexSpec_ClearDocValues(IndexSpec *sp, t_docId docId) {
+  if (!sp->docValues) {
+    return;
+  }
+  for (size_t ii = 0; ii < RS_SORTABLES_MAX; ++ii) {
+    if (sp->docValues[ii]) {
+      NumericColumn_Set(sp->docValues[ii], docId, NAN);
+    }
+  }
+}
+
+size_t IndexSpec_DocValuesMemUsage(const IndexSpec *sp) {
+  size_t sz = 0;
+  if (sp->docValues) {
+    for (size_t ii = 0; ii < RS_SORTABLES_MAX; ++ii) {
+      if (sp->docValues[ii]) {
+        sz += NumericColumn_MemUsage(sp->docValues[ii]);
+      }
+    }
+  }
+  return sz;
+}
+
+NumericRuns *IndexSpec_GetNumericRuns(IndexSpec *sp, const FieldSpec *fs, int create) {
+  if (!FieldSpec_HasSortedRuns(fs)) {
+    return NULL;
+  }
+  if (!sp->numericRuns) {
+    if (!create) {
+      return NULL;
+    }
+    sp->numericRuns = rm_calloc(SPEC_MAX_FIELDS, sizeof(*sp->numericRuns));
+  }
+  if (!sp->numericRuns[fs->index] && create) {
+    sp->numericRuns[fs->index] = NewNumericRuns();
+  }
+  return sp->numericRuns[fs->index];
+}
+
 const FieldSpec *IndexSpec_GetFieldBySortingIndex(const IndexSpec *sp, uint16_t idx) {
   for (size_t ii = 0; ii < sp->numFields; ++ii) {
     if (sp->fields[ii].options & FieldSpec_Sortable && sp->fields[ii].sortIdx == idx) {
@@ -189,6 +261,9 @@ IndexSpec *IndexSpec_CreateNew(RedisModuleCtx *ctx, RedisModuleString **argv, in
   if (IndexSpec_OnCreate) {
     IndexSpec_OnCreate(sp);
   }
+
+  // Index the keys that already exist, without blocking the server
+  IndexSpec_ScanAndReindex(ctx, sp);
   return sp;
 }
 
@@ -319,6 +394,22 @@ static int parseFieldSpec(ArgsCursor *ac, FieldSpec *sp, QueryError *status) {
     if (AC_AdvanceIfMatch(ac, SPEC_SORTABLE_STR)) {
       FieldSpec_SetSortable(sp);
       continue;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_DOCVALUES_STR)) {
+      if (!FIELD_IS(sp, INDEXFLD_T_NUMERIC)) {
+        QueryError_SetErrorFmt(status, QUERY_EPARSEARGS,
+                               SPEC_DOCVALUES_STR " is only supported for NUMERIC fields");
+        goto error;
+      }
+      sp->options |= FieldSpec_DocValues;
+      continue;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_SORTEDRUNS_STR)) {
+      if (!FIELD_IS(sp, INDEXFLD_T_NUMERIC)) {
+        QueryError_SetErrorFmt(status, QUERY_EPARSEARGS,
+                               SPEC_SORTEDRUNS_STR " is only supported for NUMERIC fields");
+        goto error;
+      }
+      sp->options |= FieldSpec_SortedRuns;
+      continue;
     } else if (AC_AdvanceIfMatch(ac, SPEC_NOINDEX_STR)) {
       sp->options |= FieldSpec_NotIndexable;
       continue;
@@ -406,7 +497,15 @@ static int IndexSpec_AddFieldsInternal(IndexSpec *sp, ArgsCursor *ac, QueryError
       fs->ftId = textId;
     }
 
-    if (FieldSpec_IsSortable(fs)) {
+    if (FieldSpec_HasDocValues(fs)) {
+      // The column replaces the field's sorting vector slot, so SORTABLE is implied but not stored
+      fs->options &= ~FieldSpec_Sortable;
+      fs->sortIdx = IndexSpec_CountDocValues(sp, fs->index);
+      if (fs->sortIdx >= RS_SORTABLES_MAX) {
+        QueryError_SetError(status, QUERY_ELIMIT, "Too many DOCVALUES fields in schema");
+        goto reset;
+      }
+    } else if (FieldSpec_IsSortable(fs)) {
       if (fs->options & FieldSpec_Dynamic) {
         QueryError_SetError(status, QUERY_EBADOPTION, "Cannot set dynamic field to sortable");
         goto reset;
@@ -419,8 +518,12 @@ static int IndexSpec_AddFieldsInternal(IndexSpec *sp, ArgsCursor *ac, QueryError
     if (FieldSpec_IsPhonetics(fs)) {
       sp->flags |= Index_HasPhonetic;
     }
+    if (!isNew) {
+      fs->options |= FieldSpec_NotReindexed;
+    }
     fs = NULL;
   }
+  IndexSpec_InitDocValues(sp, prevNumFields);
   return 1;
 
 reset:
@@ -471,6 +574,7 @@ IndexSpec *IndexSpec_Parse(const char *name, const char **argv, int argc, QueryE
       {AC_MKUNFLAG(SPEC_NOFREQS_STR, &spec->flags, Index_StoreFreqs)},
       {AC_MKBITFLAG(SPEC_SCHEMA_EXPANDABLE_STR, &spec->flags, Index_WideSchema)},
       {AC_MKBITFLAG(SPEC_ASYNC_STR, &spec->flags, Index_Async)},
+      {AC_MKBITFLAG(SPEC_LARGEBLOCKS_STR, &spec->flags, Index_LargeBlocks)},
 
       // For compatibility
       {.name = "NOSCOREIDX", .target = &dummy, .type = AC_ARGTYPE_BOOLFLAG},
@@ -676,6 +780,12 @@ void IndexSpec_FreeWithKey(IndexSpec *sp, RedisModuleCtx *ctx) {
 void IndexSpec_FreeInternals(IndexSpec *spec) {
   dictDelete(specDict, spec->name);
 
+  if (spec->scanner && !spec->scanner->global) {
+    // The scanner frees itself once it notices the cancellation
+    spec->scanner->cancelled = true;
+    spec->scanner->spec = NULL;
+  }
+
   if (spec->indexer) {
     Indexer_Free(spec->indexer);
   }
@@ -705,6 +815,24 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
     SortingTable_Free(spec->sortables);
     spec->sortables = NULL;
   }
+  if (spec->docValues) {
+    for (size_t ii = 0; ii < RS_SORTABLES_MAX; ++ii) {
+      if (spec->docValues[ii]) {
+        NumericColumn_Free(spec->docValues[ii]);
+      }
+    }
+    rm_free(spec->docValues);
+    spec->docValues = NULL;
+  }
+  if (spec->numericRuns) {
+    for (size_t ii = 0; ii < SPEC_MAX_FIELDS; ++ii) {
+      if (spec->numericRuns[ii]) {
+        NumericRuns_Free(spec->numericRuns[ii]);
+      }
+    }
+    rm_free(spec->numericRuns);
+    spec->numericRuns = NULL;
+  }
   if (spec->stopwords) {
     StopWordList_Unref(spec->stopwords);
     spec->stopwords = NULL;
@@ -1101,89 +1229,147 @@ static void IndexStats_RdbSave(RedisModuleIO *rdb, IndexStats *stats) {
   RedisModule_SaveUnsigned(rdb, stats->termsSize);
 }
 
-// todo: the final solution will scan in background
 static threadpool reindexPool = NULL;
+// The scanner reindexing the whole keyspace after loading, if one is running
+static IndexesScanner *global_scanner = NULL;
+
+dict *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
+                                      bool runFilters);
+
+static IndexesScanner *IndexesScanner_New(RedisModuleCtx *ctx, IndexSpec *spec) {
+  IndexesScanner *scanner = rm_calloc(1, sizeof(*scanner));
+  scanner->global = spec == NULL;
+  scanner->spec = spec;
+  scanner->totalKeys = RedisModule_DbSize(ctx);
+  clock_gettime(CLOCK_MONOTONIC, &scanner->startTime);
+  return scanner;
+}
 
-static void IndexSpec_DoneIndexingCallabck(struct RSAddDocumentCtx *docCtx, RedisModuleCtx *ctx,
-                                           void *pd) {
+double IndexesScanner_IndexedPercent(const IndexesScanner *scanner) {
+  if (!scanner || !scanner->totalKeys) {
+    return 100;
+  }
+  // Keys may be added while scanning, so the estimate can go past the total
+  double percent = 100.0 * scanner->scannedKeys / scanner->totalKeys;
+  return MIN(percent, 100);
+}
+
+double IndexesScanner_KeysPerSec(const IndexesScanner *scanner) {
+  if (!scanner) {
+    return 0;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double elapsed = (double)(now.tv_sec - scanner->startTime.tv_sec) +
+                   (double)(now.tv_nsec - scanner->startTime.tv_nsec) / 1e9;
+  return elapsed > 0 ? scanner->scannedKeys / elapsed : 0;
+}
+
+static void IndexesScanner_Free(IndexesScanner *scanner) {
+  if (scanner->global) {
+    // Specs created after loading may have been handed this scanner as well
+    dictIterator *iter = dictGetIterator(specDict);
+    dictEntry *entry = NULL;
+    while ((entry = dictNext(iter))) {
+      IndexSpec *sp = dictGetVal(entry);
+      if (sp->scanner == scanner) {
+        sp->scanner = NULL;
+      }
+    }
+    dictReleaseIterator(iter);
+    if (global_scanner == scanner) {
+      global_scanner = NULL;
+    }
+  } else if (!scanner->cancelled) {
+    scanner->spec->scanner = NULL;
+  }
+  rm_free(scanner);
 }
 
 static void IndexSpec_ScanCallback(RedisModuleCtx *ctx, RedisModuleString *keyname,
                                    RedisModuleKey *key, void *privdata) {
+  IndexesScanner *scanner = privdata;
+  if (scanner->cancelled) {
+    return;
+  }
+  ++scanner->scannedKeys;
   if (!key) {
     // todo: on ROF the key might not be in the ram and we will not get it here, we will need to
     // hanlde it.
     return;
   }
 
-  Indexes_UpdateMatchingWithSchemaRules(ctx, keyname);
+  if (scanner->global) {
+    Indexes_UpdateMatchingWithSchemaRules(ctx, keyname);
+    return;
+  }
 
-  //  size_t keynameCStrLen;
-  //  const char *keynameCStr = RedisModule_StringPtrLen(keyname, &keynameCStrLen);
-  //
-  //  // load the document, todo: use the key itself with scan api.
-  //  Document doc = {0};
-  //  Document_Init(&doc, keyname, 1.0, RS_LANG_ENGLISH);
-  //  if (Document_LoadAllFields(&doc, ctx) != REDISMODULE_OK) {
-  //    RedisModule_Log(ctx, "warning", "Failed loading document %*.s", (int)keynameCStrLen,
-  //                    keynameCStr);
-  //    Document_Free(&doc);
-  //    return;
-  //  }
-  //
-  //  QueryError status = {0};
-  //
-  //  dictIterator *iter = dictGetIterator(specDict);
-  //  dictEntry *entry = NULL;
-  //  while ((entry = dictNext(iter))) {
-  //    IndexSpec *sp = dictGetVal(entry);
-  //    if (IndexSpec_ShouldIndex(sp, keyname, key)) {
-  //
-  //      RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
-  //
-  //      RSAddDocumentCtx *aCtx = NewAddDocumentCtx(sp, &doc, &status);
-  //      if (aCtx == NULL) {
-  //        // todo: handle this error
-  //        continue;
-  //      }
-  //
-  //      aCtx->donecb = IndexSpec_DoneIndexingCallabck;
-  //
-  //      aCtx->stateFlags |= ACTX_F_NOBLOCK;
-  //      aCtx->stateFlags |= ACTX_F_NOFREEDOC;
-  //
-  //      AddDocumentCtx_Submit(aCtx, &sctx, DOCUMENT_ADD_REPLACE);
-  //    }
-  //  }
-  //  dictReleaseIterator(iter);
-  //
-  //  // doc was set DEAD in Document_Moved and was not freed since it set as NOFREEDOC
-  //  doc.flags &= ~DOCUMENT_F_DEAD;
-  //  Document_Free(&doc);
+  dict *specs = Indexes_FindMatchingSchemaRules(ctx, keyname, true);
+  if (dictFind(specs, scanner->spec->name)) {
+    IndexSpec_UpdateWithHash(scanner->spec, ctx, keyname);
+  }
+  dictRelease(specs);
 }
 
-void IndexSpec_ScanAndReindexSpec(void *notused) {
+static void Indexes_ScanProc(void *p) {
+  IndexesScanner *scanner = p;
   RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
   RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
-  //  RedisModule_ThreadSafeContextLock(ctx);
-  while (RedisModule_Scan(ctx, cursor, IndexSpec_ScanCallback, NULL)) {
-    //    RedisModule_ThreadSafeContextUnlock(ctx);
-    //    RedisModule_ThreadSafeContextLock(ctx);
+
+  RedisModule_ThreadSafeContextLock(ctx);
+  size_t sliceStart = scanner->scannedKeys;
+  while (!scanner->cancelled && RedisModule_Scan(ctx, cursor, IndexSpec_ScanCallback, scanner)) {
+    if (scanner->scannedKeys - sliceStart < RSGlobalConfig.bgIndexScanSize) {
+      continue;
+    }
+    // Let the main thread serve other commands between slices
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    sched_yield();
+    RedisModule_ThreadSafeContextLock(ctx);
+    sliceStart = scanner->scannedKeys;
   }
 
-  //  RedisModule_ThreadSafeContextUnlock(ctx);
+  IndexesScanner_Free(scanner);
+  RedisModule_ThreadSafeContextUnlock(ctx);
+
   RedisModule_ScanCursorDestroy(cursor);
   RedisModule_FreeThreadSafeContext(ctx);
 }
 
-void IndexSpec_ScanAndReindex() {
-  /*if (!reindexPool) {
+static void IndexesScanner_Start(IndexesScanner *scanner) {
+  if (!reindexPool) {
     reindexPool = thpool_init(1);
-  }*/
+  }
+  thpool_add_work(reindexPool, Indexes_ScanProc, scanner);
+}
+
+void Indexes_ScanAndReindex(RedisModuleCtx *ctx) {
+  if (global_scanner) {
+    global_scanner->cancelled = true;
+  }
+  global_scanner = IndexesScanner_New(ctx, NULL);
 
-  // todo: the final solution will scan in background
-  IndexSpec_ScanAndReindexSpec(NULL);
-  //  thpool_add_work(reindexPool, IndexSpec_ScanAndReindexSpec, NULL);
+  dictIterator *iter = dictGetIterator(specDict);
+  dictEntry *entry = NULL;
+  while ((entry = dictNext(iter))) {
+    IndexSpec *sp = dictGetVal(entry);
+    sp->scanner = global_scanner;
+  }
+  dictReleaseIterator(iter);
+
+  IndexesScanner_Start(global_scanner);
+}
+
+void IndexSpec_ScanAndReindex(RedisModuleCtx *ctx, IndexSpec *sp) {
+  if (RedisModule_GetContextFlags(ctx) & REDISMODULE_CTX_FLAGS_LOADING) {
+    // The whole keyspace is scanned once loading ends
+    return;
+  }
+  if (!RedisModule_DbSize(ctx)) {
+    return;
+  }
+  sp->scanner = IndexesScanner_New(ctx, sp);
+  IndexesScanner_Start(sp->scanner);
 }
 
 int IndexSpec_RdbLoad(RedisModuleIO *rdb, int encver, int when) {
@@ -1214,6 +1400,9 @@ int IndexSpec_RdbLoad(RedisModuleIO *rdb, int encver, int when) {
     if (encver < INDEX_MIN_NOFREQ_VERSION) {
       sp->flags |= Index_StoreFreqs;
     }
+    if (encver < INDEX_LARGEBLOCKS_VERSION) {
+      sp->flags &= ~Index_LargeBlocks;
+    }
 
     sp->numFields = RedisModule_LoadUnsigned(rdb);
     sp->fields = rm_calloc(sp->numFields, sizeof(FieldSpec));
@@ -1229,6 +1418,7 @@ int IndexSpec_RdbLoad(RedisModuleIO *rdb, int encver, int when) {
         sp->sortables->len = MAX(sp->sortables->len, fs->sortIdx + 1);
       }
     }
+    IndexSpec_InitDocValues(sp, 0);
 
     //    IndexStats_RdbLoad(rdb, &sp->stats);
 
@@ -1344,6 +1534,9 @@ static void IndexSpec_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, ui
   if (subevent == REDISMODULE_SUBEVENT_LOADING_RDB_START ||
       subevent == REDISMODULE_SUBEVENT_LOADING_AOF_START ||
       subevent == REDISMODULE_SUBEVENT_LOADING_REPL_START) {
+    if (global_scanner) {
+      global_scanner->cancelled = true;
+    }
     IndexSpec **specs = array_new(IndexSpec *, 10);
     dictIterator *iter = dictGetIterator(specDict);
     dictEntry *entry = NULL;
@@ -1358,7 +1551,7 @@ static void IndexSpec_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, ui
     }
     array_free(specs);
   } else if (subevent == REDISMODULE_SUBEVENT_LOADING_ENDED) {
-    IndexSpec_ScanAndReindex();
+    Indexes_ScanAndReindex(ctx);
   }
 }
 
@@ -1384,6 +1577,23 @@ int IndexSpec_RegisterType(RedisModuleCtx *ctx) {
 
 int IndexSpec_DeleteHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key);
 
+/* The hash was loaded with all of its schema fields, so a NOINDEX sortable or doc values field which
+ * is missing was deleted from it. The partial update only writes the fields present, so clear the
+ * values of the missing ones here */
+static void clearMissingNoIndexValues(IndexSpec *spec, RSDocumentMetadata *md, Document *doc) {
+  for (size_t ii = 0; ii < spec->numFields; ++ii) {
+    const FieldSpec *fs = spec->fields + ii;
+    if (FieldSpec_IsIndexable(fs) || Document_GetField(doc, fs->name)) {
+      continue;
+    }
+    if (FieldSpec_HasDocValues(fs)) {
+      NumericColumn_Set(IndexSpec_GetNumericColumn(spec, fs->sortIdx), md->id, NAN);
+    } else if (FieldSpec_IsSortable(fs) && md->sortVector && fs->sortIdx >= 0) {
+      RSSortingVector_Put(md->sortVector, fs->sortIdx, NULL, RS_SORTABLE_NIL);
+    }
+  }
+}
+
 int IndexSpec_UpdateWithHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key) {
   if (!spec->rule) {
     RedisModule_Log(ctx, "warning", "Index spec %s: no rule found", spec->name);
@@ -1396,10 +1606,21 @@ int IndexSpec_UpdateWithHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleSt
     Document_Free(&doc);
     return RedisModule_ReplyWithError(ctx, "Could not load document");
   }
+
+  uint32_t options = DOCUMENT_ADD_REPLACE;
+  RSDocumentMetadata *md = DocTable_GetByKeyR(&spec->docs, key);
+  if (md && md->fieldsDigest == Document_IndexedFieldsDigest(&doc, spec)) {
+    // None of the indexed fields changed (e.g. the HSET touched a field outside of the schema).
+    // Keep the docId and only update the score, payload and NOINDEX sortables in place.
+    Document_DropIndexedFields(&doc, spec);
+    clearMissingNoIndexValues(spec, md, &doc);
+    options |= DOCUMENT_ADD_PARTIAL;
+  }
+
   QueryError status = {0};
   RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, &doc, &status);
   aCtx->stateFlags |= ACTX_F_NOBLOCK;
-  AddDocumentCtx_Submit(aCtx, &sctx, DOCUMENT_ADD_REPLACE);
+  AddDocumentCtx_Submit(aCtx, &sctx, options);
 
   // doc was set DEAD in Document_Moved and was not freed since it set as NOFREEDOC
   doc.flags &= ~DOCUMENT_F_DEAD;
@@ -1420,6 +1641,7 @@ int IndexSpec_DeleteHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
   int rc = DocTable_DeleteR(&spec->docs, key);
   if (rc) {
     spec->stats.numDocuments--;
+    IndexSpec_ClearDocValues(spec, id);
 
     // Increment the index's garbage collector's scanning frequency after document deletions
     if (spec->gc) {
@@ -1454,59 +1676,54 @@ void Indexes_Init(RedisModuleCtx *ctx) {
   SchemaRules_Create();
 }
 
-dict *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key) {
-  EvalCtx *r = EvalCtx_Create();
-  // check r for null?
-  EvalCtx_AddHash(r, ctx, key);
-  RSValue *keyRSV = RS_RedisStringVal(key);
-  EvalCtx_Set(r, "__key", keyRSV);
-
-#ifdef DEBUG
-  RLookupKey *k = RLookup_GetKey(&r->lk, "__key", 0);
-  RSValue *v = RLookup_GetItem(k, &r->row);
-  const char *x = RSValue_StringPtrLen(v, NULL);
-  k = RLookup_GetKey(&r->lk, "name", 0);
-  v = RLookup_GetItem(k, &r->row);
-  x = RSValue_StringPtrLen(v, NULL);
-#endif  // DEBUG
-
+/**
+ * Find the specs whose rules match the key. Candidates are narrowed down by the key's prefix
+ * first, so keys that no index covers never have their hash read. If runFilters is set, the
+ * FILTER of each candidate is evaluated as well, reading only the fields it references.
+ */
+dict *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
+                                      bool runFilters) {
   dict *specs = dictCreate(&dictTypeHeapStrings, NULL);
+  RedisModuleKey *k = NULL;
+  bool keyOpened = false;
 
   size_t n;
   const char *key_p = RedisModule_StringPtrLen(key, &n);
   arrayof(SchemaPrefixNode *) prefixes = array_new(SchemaPrefixNode *, 1);
-  int nprefixes = TrieMap_FindPrefixes(ScemaPrefixes_g, key_p, n, (arrayof(void *) *)&prefixes);
+  TrieMap_FindPrefixes(ScemaPrefixes_g, key_p, n, (arrayof(void *) *)&prefixes);
   for (int i = 0; i < array_len(prefixes); ++i) {
     SchemaPrefixNode *node = prefixes[i];
     for (int j = 0; j < array_len(node->index_specs); ++j) {
       IndexSpec *spec = node->index_specs[j];
-      if (!dictFind(specs, node->prefix)) {
-        dictAdd(specs, spec->name, spec);
+      if (dictFind(specs, spec->name)) {
+        continue;
       }
+      if (runFilters && spec->rule->filter_exp) {
+        if (!keyOpened) {
+          k = RedisModule_OpenKey(ctx, key, REDISMODULE_READ);
+          if (k && RedisModule_KeyType(k) != REDISMODULE_KEYTYPE_HASH) {
+            RedisModule_CloseKey(k);
+            k = NULL;
+          }
+          keyOpened = true;
+        }
+        if (!SchemaRule_FilterPasses(spec->rule, key, k)) {
+          continue;
+        }
+      }
+      dictAdd(specs, spec->name, spec);
     }
   }
   array_free(prefixes);
 
-  for (size_t i = 0; i < array_len(SchemaRules_g); i++) {
-    SchemaRule *rule = SchemaRules_g[i];
-    if (!rule->filter_exp) {
-      continue;
-    }
-    if (EvalCtx_EvalExpr(r, rule->filter_exp) == EXPR_EVAL_OK) {
-      IndexSpec *spec = rule->spec;
-      if (RSValue_BoolTest(&r->res) && !dictFind(specs, spec->name)) {
-        dictAdd(specs, spec->name, spec);
-      }
-    }
+  if (k) {
+    RedisModule_CloseKey(k);
   }
-
-  EvalCtx_Destroy(r);
-
   return specs;
 }
 
 void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key) {
-  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key);
+  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key, true);
 
   dictIterator *di = dictGetIterator(specs);
   dictEntry *ent = dictNext(di);
@@ -1521,7 +1738,9 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
 }
 
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key) {
-  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key);
+  // The hash is already gone, so the filters cannot be evaluated. Deleting from an index that
+  // never had the document is a no-op anyway.
+  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key, false);
 
   dictIterator *di = dictGetIterator(specs);
   dictEntry *ent = dictNext(di);
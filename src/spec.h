@@ -2,6 +2,8 @@
 #define __SPEC_H__
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <time.h>
 
 #include "default_gc.h"
 #include "redismodule.h"
@@ -37,11 +39,14 @@ extern "C" {
 #define SPEC_PHONETIC_STR "PHONETIC"
 #define SPEC_TAG_STR "TAG"
 #define SPEC_SORTABLE_STR "SORTABLE"
+#define SPEC_DOCVALUES_STR "DOCVALUES"
+#define SPEC_SORTEDRUNS_STR "SORTEDRUNS"
 #define SPEC_STOPWORDS_STR "STOPWORDS"
 #define SPEC_NOINDEX_STR "NOINDEX"
 #define SPEC_SEPARATOR_STR "SEPARATOR"
 #define SPEC_MULTITYPE_STR "MULTITYPE"
 #define SPEC_ASYNC_STR "ASYNC"
+#define SPEC_LARGEBLOCKS_STR "LARGEBLOCKS"
 
 /**
  * If wishing to represent field types positionally, use this
@@ -95,7 +100,10 @@ typedef enum {
 
   // If any of the fields has phonetics. This is just a cache for quick lookup
   Index_HasPhonetic = 0x400,
-  Index_Async = 0x800
+  Index_Async = 0x800,
+
+  // Term indexes use large blocks with an in-block skip table
+  Index_LargeBlocks = 0x1000,
 } IndexFlags;
 
 /**
@@ -112,9 +120,12 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
    Index_WideSchema)
 
-#define INDEX_CURRENT_VERSION 16
+#define INDEX_CURRENT_VERSION 17
 #define INDEX_MIN_COMPAT_VERSION 16
 
+// Versions below this do not know about Index_LargeBlocks
+#define INDEX_LARGEBLOCKS_VERSION 17
+
 // Those versions contains doc table as array, we modified it to be array of linked lists
 // todo: decide if we need to keep this, currently I keep it if one day we will find a way to
 //       load old rdb versions
@@ -159,6 +170,7 @@ typedef struct {
 } IndexSpecFmtStrings;
 
 struct DocumentIndexer;
+struct IndexesScanner;
 
 typedef struct IndexSpec {
   char *name;
@@ -195,6 +207,15 @@ typedef struct IndexSpec {
   struct DocumentIndexer *indexer;
 
   SchemaRule *rule;
+
+  // Background scanner indexing the existing keyspace, NULL once it is done
+  struct IndexesScanner *scanner;
+
+  // Columns of DOCVALUES fields, indexed by their sortIdx. NULL if no field has doc values
+  struct NumericColumn **docValues;
+
+  // Indexes of SORTEDRUNS fields, indexed by field index. NULL if no field is indexed in runs
+  struct NumericRuns **numericRuns;
 } IndexSpec;
 
 typedef struct {
@@ -265,6 +286,19 @@ int IndexSpec_CheckPhoneticEnabled(const IndexSpec *sp, t_fieldMask fm);
  * not sortable */
 int IndexSpec_GetFieldSortingIndex(IndexSpec *sp, const char *name, size_t len);
 
+/* Get the doc values column at the given index (the sortIdx of a DOCVALUES field), or NULL if there
+ * is none */
+struct NumericColumn *IndexSpec_GetNumericColumn(const IndexSpec *sp, int idx);
+
+/* Clear the doc values of a deleted document */
+void IndexSpec_ClearDocValues(IndexSpec *sp, t_docId docId);
+
+size_t IndexSpec_DocValuesMemUsage(const IndexSpec *sp);
+
+/* Get the sorted runs index of a SORTEDRUNS field, creating it if create is set. Returns NULL if
+ * the field is not indexed in runs, or its index does not exist yet and create is not set */
+struct NumericRuns *IndexSpec_GetNumericRuns(IndexSpec *sp, const FieldSpec *fs, int create);
+
 /**
  * Get the field spec from the sortable index
  */
@@ -411,6 +445,35 @@ void IndexSpec_ClearAliases(IndexSpec *sp);
 t_fieldMask IndexSpec_ParseFieldMask(IndexSpec *sp, RedisModuleString **argv, int argc);
 
 void IndexSpec_InitializeSynonym(IndexSpec *sp);
+
+/**
+ * Scans the keyspace on a background thread, indexing the keys matching the schema rules.
+ * The scan runs in slices of RSGlobalConfig.bgIndexScanSize keys, holding the GIL only for
+ * the duration of a single slice, so queries keep being served (with partial results) while
+ * the scan is in progress.
+ */
+typedef struct IndexesScanner {
+  // Scanning on behalf of all the indexes (after loading), rather than a single one
+  bool global;
+  // Set (under the GIL) when the scanned index is dropped or the keyspace is reloaded
+  bool cancelled;
+  IndexSpec *spec;
+  size_t scannedKeys;
+  size_t totalKeys;
+  struct timespec startTime;
+} IndexesScanner;
+
+/* Scan the whole keyspace in the background and reindex it into all the indexes */
+void Indexes_ScanAndReindex(RedisModuleCtx *ctx);
+
+/* Scan the whole keyspace in the background and index matching keys into the given spec */
+void IndexSpec_ScanAndReindex(RedisModuleCtx *ctx, IndexSpec *sp);
+
+/* Percentage of the keyspace scanned so far, 100 when no scan is running */
+double IndexesScanner_IndexedPercent(const IndexesScanner *scanner);
+
+/* Average number of keys scanned per second since the scan started */
+double IndexesScanner_KeysPerSec(const IndexesScanner *scanner);
 void Indexes_Init(RedisModuleCtx *ctx);
 void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key);
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key);
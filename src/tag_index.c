@@ -7,16 +7,23 @@
 #include "util/misc.h"
 #include "util/arr.h"
 #include "rmutil/rm_assert.h"
+#include "docid_bitmap.h"
 
 static uint32_t tagUniqueId = 0;
 
 // Tags are limited to 4096 each
 #define MAX_TAG_LEN 0x1000
+
+// Tags with at least TAG_BITMAP_MIN_DOCS documents, covering at least 1/TAG_BITMAP_DENSITY of the
+// doc id range, are read through a doc id bitmap
+#define TAG_BITMAP_MIN_DOCS 1024
+#define TAG_BITMAP_DENSITY 8
 /* See tag_index.h for documentation  */
 TagIndex *NewTagIndex() {
   TagIndex *idx = rm_new(TagIndex);
   idx->values = NewTrieMap();
   idx->uniqueId = tagUniqueId++;
+  idx->valuesAreTags = 1;
   return idx;
 }
 
@@ -135,30 +142,13 @@ static void TagReader_OnReopen(RedisModuleKey *k, void *privdata) {
     return;
   }
 
-  // If the key is valid, we just reset the reader's buffer reader to the current block pointer
+  // If the key is valid, we just restore the readers' positions
   for (size_t ii = 0; ii < nits; ++ii) {
-    IndexReader *ir = its[ii]->ctx;
-
-    // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
-    if (ir->gcMarker == ir->idx->gcMarker) {
-      // no GC - we just go to the same offset we were at
-      size_t offset = ir->br.pos;
-      ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-      ir->br.pos = offset;
-    } else {
-      // if there has been a GC cycle on this key while we were asleep, the offset might not be
-      // valid anymore. This means that we need to seek to last docId we were at
-
-      // reset the state of the reader
-      t_docId lastId = ir->lastId;
-      ir->currentBlock = 0;
-      ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-      ir->lastId = 0;
-
-      // seek to the previous last id
-      RSIndexResult *dummy = NULL;
-      IR_SkipTo(ir, lastId, &dummy);
+    if (its[ii]->Read != IR_Read) {
+      // bitmap iterators hold their own reference to the data and need no repositioning
+      continue;
     }
+    IndexReader_Resume(its[ii]->ctx);
   }
 }
 
@@ -180,6 +170,47 @@ void TagIndex_RegisterConcurrentIterators(TagIndex *idx, ConcurrentSearchCtx *co
                           concCtxFree);
 }
 
+static inline int tagIsDense(const InvertedIndex *iv) {
+  return iv->numDocs >= TAG_BITMAP_MIN_DOCS &&
+         (t_docId)iv->numDocs * TAG_BITMAP_DENSITY >= iv->lastId;
+}
+
+size_t TagIndex_CountDocs(InvertedIndex *iv, const DocIdBitmap *docs) {
+  size_t count = 0;
+  if (tagIsDense(iv)) {
+    const DocIdBitmap *bm = InvertedIndex_GetBitmap(iv);
+    size_t nwords = MIN(bm->nwords, docs->nwords);
+    for (size_t ii = 0; ii < nwords; ++ii) {
+      count += __builtin_popcountll(bm->words[ii] & docs->words[ii]);
+    }
+    return count;
+  }
+
+  IndexReader *ir = NewTermIndexReader(iv, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *res;
+  while (IR_Read(ir, &res) == INDEXREAD_OK) {
+    count += DocIdBitmap_Contains(docs, res->docId);
+  }
+  IR_Free(ir);
+  return count;
+}
+
+size_t TagIndex_CountCost(TagIndex *idx, size_t max) {
+  size_t cost = 0;
+  TrieMapIterator *it = TrieMap_Iterate(idx->values, "", 0);
+  char *str;
+  tm_len_t slen;
+  void *ptr;
+  while (cost <= max && TrieMapIterator_Next(it, &str, &slen, &ptr)) {
+    const InvertedIndex *iv = ptr;
+    // a dense tag's bitmap is built from its postings once, then only its words are read
+    size_t n = tagIsDense(iv) && iv->bitmap ? iv->lastId / 64 + 1 : iv->numDocs;
+    cost += 1 + n;
+  }
+  TrieMapIterator_Free(it);
+  return cost;
+}
+
 /* Open an index reader to iterate a tag index for a specific tag. Used at query evaluation time.
  * Returns NULL if there is no such tag in the index */
 IndexIterator *TagIndex_OpenReader(TagIndex *idx, IndexSpec *sp, const char *value, size_t len,
@@ -192,6 +223,16 @@ IndexIterator *TagIndex_OpenReader(TagIndex *idx, IndexSpec *sp, const char *val
 
   RSToken tok = {.str = (char *)value, .len = len};
   RSQueryTerm *t = NewQueryTerm(&tok, 0);
+
+  // dense tags are served from a bitmap, which is no larger than the varint encoded blocks and
+  // answers SkipTo without decoding
+  if (tagIsDense(iv)) {
+    if (sp) {
+      t->idf = CalculateIDF(sp->docs.size, iv->numDocs);
+    }
+    return NewDocIdBitmapIterator(InvertedIndex_GetBitmap(iv), t, weight);
+  }
+
   IndexReader *r = NewTermIndexReader(iv, sp, RS_FIELDMASK_ALL, t, weight);
   if (!r) {
     return NULL;
@@ -277,6 +318,8 @@ RedisModuleType *TagIndexType;
 void *TagIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
   unsigned long long elems = RedisModule_LoadUnsigned(rdb);
   TagIndex *idx = NewTagIndex();
+  // The documents' values are not known
+  idx->valuesAreTags = 0;
 
   while (elems--) {
     size_t slen;
@@ -8,6 +8,7 @@
 #include "geo_index.h"
 
 struct InvertedIndex;
+struct DocIdBitmap;
 
 #ifdef __cplusplus
 extern "C" {
@@ -94,6 +95,11 @@ extern "C" {
  */
 typedef struct {
   uint32_t uniqueId;
+  // Set while the field value of every indexed document is exactly its single tag, as the value is
+  // loaded by aggregations. Grouping documents by the field's values then gives the same groups as
+  // grouping them by tag. Cleared for good by the first document with several tags, or with a value
+  // changed by tokenization (e.g. lowercased or trimmed)
+  int valuesAreTags;
   TrieMap *values;
 } TagIndex;
 
@@ -119,6 +125,13 @@ static inline void TagIndex_FreePreprocessedData(char **s) {
 /* Index a vector of pre-processed tags for a docId */
 size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId);
 
+/* Count the documents of one of the index's tags which are also in `docs` */
+size_t TagIndex_CountDocs(struct InvertedIndex *iv, const struct DocIdBitmap *docs);
+
+/* The cost of counting the documents of every tag of the index with TagIndex_CountDocs, in postings
+ * read. Stops adding up once it goes over `max`, so a larger result only means it exceeds `max` */
+size_t TagIndex_CountCost(TagIndex *idx, size_t max);
+
 /* Open an index reader to iterate a tag index for a specific tag. Used at query evaluation time.
  * Returns NULL if there is no such tag in the index */
 IndexIterator *TagIndex_OpenReader(TagIndex *idx, IndexSpec *sp, const char *value, size_t len,